@@ -0,0 +1,230 @@
+/**
+ * @file s21_bench_lib.c
+ * @brief Замер пропускной способности libtetris.so (шагов игры в секунду).
+ *
+ * Играет фиксированной псевдослучайной последовательностью действий с
+ * фиксированным seed, поэтому результаты разных сборок сравнимы.
+ * Реализация операций с полем: standard (по умолчанию, специализированная
+ * для 10x20) или generic; make bench замеряет обе. make perf-check
+ * сравнивает результат с базовым (bench/perf_baseline.txt), который
+ * записывается make perf-baseline на этой же машине и в репозиторий не
+ * входит.
+ * Запуск: make bench [BENCH_STEPS=N]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../brick_game/tetris/s21_tetris_lib.h"
+
+#define BENCH_SEED 42u
+#define BENCH_BATCH 256
+#define BENCH_STEPS 2000000
+// Допустимое падение пропускной способности относительно базовой, %
+#define BENCH_TOLERANCE 10.0
+
+/**
+ * @brief Заполнение буфера действий: в основном движение и вращение,
+ * периодически сдвиг вниз по таймеру и падение фигуры.
+ */
+static void fillActions(unsigned int *rnd, int *actions, int *holds,
+                        int count) {
+  static const int mix[8] = {TETRIS_ACTION_LEFT,   TETRIS_ACTION_RIGHT,
+                             TETRIS_ACTION_ACTION, TETRIS_ACTION_DOWN,
+                             TETRIS_ACTION_LEFT,   TETRIS_ACTION_RIGHT,
+                             TETRIS_ACTION_DOWN,   TETRIS_ACTION_DOWN};
+  for (int i = 0; i < count; i++) {
+    *rnd = *rnd * 1103515245u + 12345u;
+    unsigned int r = *rnd >> 16;
+    actions[i] = mix[r & 7];
+    holds[i] = actions[i] == TETRIS_ACTION_DOWN && (r & 0x70) == 0;
+  }
+}
+
+/// @brief Результат одного прогона
+typedef struct {
+  long steps;
+  long games;
+  /// Общее время, с
+  double elapsed;
+  /// Шагов в секунду без сброса партий и наблюдения
+  double step_path;
+  /// Среднее время tetrisEngineObserve, нс, и tetrisEngineReset, мкс
+  double observe_ns;
+  double reset_us;
+} bench_result_t;
+
+/**
+ * @brief Один прогон: steps шагов с одинаковыми действиями и seed.
+ * @return 0 - успешно, 1 - ошибка создания игры.
+ */
+static int benchRun(long steps, int board, bench_result_t *result) {
+  TetrisEngine_t *engine = tetrisEngineCreate(BENCH_SEED);
+  if (engine == NULL) return 1;
+  tetrisEngineSetBoard(engine, board);
+  int actions[BENCH_BATCH], holds[BENCH_BATCH];
+  int field[TETRIS_FIELD_CELLS], next[TETRIS_NEXT_CELLS],
+      stats[TETRIS_STAT_COUNT];
+  unsigned int rnd = BENCH_SEED;
+  long done = 0, games = 1, observed = 0;
+  double observe_time = 0, reset_time = 0;
+  double start = tetrisNow() / 1e9;
+  while (done < steps) {
+    fillActions(&rnd, actions, holds, BENCH_BATCH);
+    int count = steps - done < BENCH_BATCH ? (int)(steps - done) : BENCH_BATCH;
+    int offset = 0;
+    while (offset < count) {
+      int n = tetrisEngineStepBatch(engine, actions + offset, holds + offset,
+                                    count - offset);
+      offset += n;
+      double t = tetrisNow() / 1e9;
+      tetrisEngineObserve(engine, field, next, stats);
+      observe_time += tetrisNow() / 1e9 - t;
+      observed++;
+      if (stats[TETRIS_STAT_STATE] != TETRIS_STATE_MOVING) {
+        t = tetrisNow() / 1e9;
+        tetrisEngineReset(engine, BENCH_SEED + (unsigned int)games);
+        reset_time += tetrisNow() / 1e9 - t;
+        games++;
+      }
+    }
+    done += count;
+  }
+  double elapsed = tetrisNow() / 1e9 - start;
+  result->steps = done;
+  result->games = games;
+  result->elapsed = elapsed;
+  result->step_path = done / (elapsed - reset_time - observe_time);
+  result->observe_ns = observe_time * 1e9 / observed;
+  result->reset_us = reset_time * 1e6 / games;
+  tetrisEngineDestroy(engine);
+  return 0;
+}
+
+/**
+ * @brief Запись базового результата для --baseline.
+ * @return 0 - успешно, 1 - ошибка записи.
+ */
+static int benchSave(const char *path, const bench_result_t *result) {
+  FILE *file = fopen(path, "w");
+  int res = file == NULL;
+  if (!res) {
+    fprintf(file, "# make perf-baseline: fixed-seed workload of bench_lib\n");
+    fprintf(file, "steps %ld\ngames %ld\nstep_path %.0f\n", result->steps,
+            result->games, result->step_path);
+    res = fclose(file) != 0;
+  }
+  return res;
+}
+
+/**
+ * @brief Сравнение с базовым результатом: нагрузка (steps, games) должна
+ * совпадать, пропускная способность - быть не ниже базовой больше чем на
+ * tolerance процентов.
+ * @return 0 - нет регрессии, 1 - регрессия или ошибка чтения.
+ */
+static int benchCheck(const char *path, const bench_result_t *result,
+                      double tolerance) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr,
+            "perf-check: cannot read %s: record a local baseline with "
+            "make perf-baseline\n",
+            path);
+    return 1;
+  }
+  char line[128], key[32];
+  double value, steps = -1, games = -1, step_path = -1;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (line[0] != '#' && sscanf(line, "%31s %lf", key, &value) == 2) {
+      if (strcmp(key, "steps") == 0) steps = value;
+      if (strcmp(key, "games") == 0) games = value;
+      if (strcmp(key, "step_path") == 0) step_path = value;
+    }
+  }
+  fclose(file);
+  int res = 0;
+  if (steps != result->steps || games != result->games) {
+    fprintf(stderr,
+            "perf-check: workload differs from %s (steps %.0f, games %.0f): "
+            "record a new baseline\n",
+            path, steps, games);
+    res = 1;
+  } else {
+    double change = (result->step_path / step_path - 1) * 100;
+    printf("baseline:     %.0f steps/sec (%+.1f%%, tolerance %.1f%%)\n",
+           step_path, change, tolerance);
+    if (change < -tolerance) {
+      fprintf(stderr, "perf-check: throughput regression %.1f%%\n", change);
+      res = 1;
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Запуск: bench_lib [STEPS] [standard|generic] [--repeat N]
+ * [--save FILE] [--baseline FILE] [--tolerance PERCENT].
+ *
+ * При --repeat берется лучший из N прогонов (наименее зашумленный).
+ * --save записывает результат как базовый, --baseline сравнивает с ним и
+ * завершается с кодом 1 при регрессии больше tolerance (по умолчанию 10%).
+ */
+int main(int argc, char **argv) {
+  long steps = BENCH_STEPS;
+  int board = TETRIS_BOARD_STANDARD, repeat = 1, bad = 0;
+  const char *save = NULL, *baseline = NULL;
+  double tolerance = BENCH_TOLERANCE;
+  for (int i = 1; i < argc && !bad; i++) {
+    if (strcmp(argv[i], "generic") == 0) {
+      board = TETRIS_BOARD_GENERIC;
+    } else if (strcmp(argv[i], "standard") == 0) {
+      board = TETRIS_BOARD_STANDARD;
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      save = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (argv[i][0] != '-' && atol(argv[i]) > 0) {
+      steps = atol(argv[i]);
+    } else {
+      bad = 1;
+    }
+  }
+  if (bad || repeat < 1) {
+    fprintf(stderr,
+            "usage: %s [STEPS] [standard|generic] [--repeat N] "
+            "[--save FILE] [--baseline FILE] [--tolerance PERCENT]\n",
+            argv[0]);
+    return 1;
+  }
+  bench_result_t best = {0}, result;
+  for (int i = 0; i < repeat; i++) {
+    if (benchRun(steps, board, &result)) {
+      fprintf(stderr, "tetrisEngineCreate failed\n");
+      return 1;
+    }
+    if (result.step_path > best.step_path) best = result;
+  }
+  printf("board:        %s\n",
+         board == TETRIS_BOARD_GENERIC ? "generic" : "standard");
+  printf("steps:        %ld\n", best.steps);
+  printf("games:        %ld\n", best.games);
+  printf("time:         %.3f s\n", best.elapsed);
+  printf("steps/sec:    %.0f\n", best.steps / best.elapsed);
+  // Только шаги игры, без сброса партий и наблюдения
+  printf("step path:    %.0f steps/sec\n", best.step_path);
+  printf("observe:      %.1f ns/call\n", best.observe_ns);
+  printf("reset:        %.1f us/call\n", best.reset_us);
+  printf("memory:       %d bytes/engine\n", tetrisEngineMemory());
+  int res = 0;
+  if (save != NULL && benchSave(save, &best)) {
+    fprintf(stderr, "cannot write %s\n", save);
+    res = 1;
+  }
+  if (baseline != NULL) res |= benchCheck(baseline, &best, tolerance);
+  return res;
+}
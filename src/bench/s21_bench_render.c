@@ -0,0 +1,341 @@
+/**
+ * @file s21_bench_render.c
+ * @brief Замер отрисовки интерфейса: мкс и байт на кадр по режимам GUI для
+ * каждого способа вывода.
+ *
+ * Состояния игры воспроизводятся на игре GUI через userInput / userKey /
+ * userTick: из журнала игр (--log FILE, запись tetris --record) или
+ * фиксированной псевдослучайной последовательностью действий с паузами.
+ * После каждого изменения состояния выводится кадр (printGameScreen и
+ * screenRefresh), как в игровом цикле без ограничения частоты кадров.
+ *
+ * Способы вывода: ncurses и свой ANSI-рендерер (--ansi) - в терминал
+ * newterm на псевдотерминале, байты кадра считываются с другой его
+ * стороны; memory - кадр только собирается в памяти (SCREEN_MEMORY).
+ * Тип терминала фиксирован (BENCH_TERM, --term), чтобы результаты разных
+ * машин были сравнимы. Отдельно на memory замеряются функции отрисовки
+ * режима игры: printGlass, printNext, printGameStat.
+ *
+ * Запуск: make bench-render [BENCH_RENDER_ARGS="--log FILE --repeat N"]
+ */
+#define _XOPEN_SOURCE 600
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "../gui/cli/s21_tetris.h"
+
+#define BENCH_SEED 42u
+// Игр псевдослучайной последовательности действий
+#define BENCH_GAMES 20
+// Пауза (и продолжение) каждые BENCH_PAUSE_PERIOD действий
+#define BENCH_PAUSE_PERIOD 100
+// Повторов вызова функции отрисовки при замере функций
+#define BENCH_CALLS 16
+// Тип терминала newterm
+#define BENCH_TERM "xterm-256color"
+// Режимов GUI (значения game_info.pause)
+#define BENCH_MODES (GAMEOVER_MODE + 1)
+
+/// @brief Статистика кадров одного режима GUI
+typedef struct {
+  long long frames;
+  long long time_ns;
+  long long bytes;
+} bench_mode_t;
+
+/// @brief Прогон: способ вывода, источник состояний и статистика
+typedef struct {
+  screen_t screen;
+  /// Ведущая сторона псевдотерминала (байты вывода) или -1
+  int master;
+  /// Журнал игр или NULL - псевдослучайные действия
+  const replay_log_t *log;
+  bench_mode_t modes[BENCH_MODES];
+  /// Замер функций отрисовки режима игры (на каждом его кадре)
+  bool functions;
+  long long glass_ns, next_ns, stat_ns, function_frames;
+} bench_t;
+
+static const char *const mode_names[BENCH_MODES] = {"game", "pause", "start",
+                                                    "exit", "gameover"};
+
+/**
+ * @brief Чтение всего вывода из псевдотерминала.
+ * @return Количество байт.
+ */
+static long long benchDrain(int master) {
+  long long bytes = 0;
+  char buf[4096];
+  ssize_t res;
+  while ((res = read(master, buf, sizeof(buf))) > 0 ||
+         (res < 0 && errno == EINTR))
+    if (res > 0) bytes += res;
+  return bytes;
+}
+
+/**
+ * @brief Время вызова функции отрисовки, нс (среднее по BENCH_CALLS).
+ */
+static long long benchCall(void (*print)(GameInfo_t *), GameInfo_t *info) {
+  long long start = metricsNow();
+  for (int i = 0; i < BENCH_CALLS; i++) print(info);
+  return (metricsNow() - start) / BENCH_CALLS;
+}
+
+/**
+ * @brief Кадр текущего состояния игры GUI с замером времени и байт.
+ */
+static void benchFrame(bench_t *bench) {
+  GameInfo_t game_info = updateCurrentState();
+  if (game_info.pause < 0 || game_info.pause >= BENCH_MODES) return;
+  long long start = metricsNow();
+  printGameScreen(&game_info);
+  long long bytes = screenRefresh();
+  long long time = metricsNow() - start;
+  if (bench->master >= 0) bytes = benchDrain(bench->master);
+  bench_mode_t *mode = &bench->modes[game_info.pause];
+  mode->frames++;
+  mode->time_ns += time;
+  mode->bytes += bytes > 0 ? bytes : 0;
+  if (bench->functions && game_info.pause == GAME_MODE) {
+    bench->glass_ns += benchCall(printGlass, &game_info);
+    bench->next_ns += benchCall(printNext, &game_info);
+    bench->stat_ns += benchCall(printGameStat, &game_info);
+    bench->function_frames++;
+  }
+}
+
+/**
+ * @brief Вызов API игры и кадр, если состояние изменилось.
+ */
+static void benchInput(bench_t *bench, UserAction_t action, bool hold) {
+  unsigned int steps = fsmGuiEngine()->step_count;
+  userInput(action, hold);
+  if (fsmGuiEngine()->step_count != steps) benchFrame(bench);
+}
+
+/**
+ * @brief Окончание игры GUI и переход в стартовое окно.
+ */
+static void benchFinish(bench_t *bench) {
+  tetris_state state = fsmGuiEngine()->state;
+  if (state == MOVING || state == PAUSE) benchInput(bench, Terminate, false);
+  if (fsmGuiEngine()->state == GAMEOVER) benchInput(bench, Start, false);
+}
+
+/**
+ * @brief Игры журнала: события повторяются через API игры GUI.
+ */
+static void benchPlayLog(bench_t *bench) {
+  for (long long g = 0; g < bench->log->games; g++) {
+    const replay_event_t *events;
+    const replay_game_t *game = replayGame(bench->log, g, &events);
+    fsmGuiSeed(game->seed);
+    fsmGuiAdaptive((game->flags & REPLAY_ADAPTIVE) != 0);
+    benchInput(bench, Start, false);
+    for (unsigned int i = 0; i < game->count; i++) {
+      const replay_event_t *event = &events[i];
+      UserAction_t action = (UserAction_t)event->action;
+      unsigned int steps = fsmGuiEngine()->step_count;
+      if (event->action > Hold) continue;
+      if (event->kind == REPLAY_INPUT)
+        userInput(action, action == Down && event->value);
+      else if (event->kind == REPLAY_KEY)
+        userKey(action, event->value != 0);
+      else
+        for (int t = 0; t < event->value; t++) userTick();
+      if (fsmGuiEngine()->step_count != steps) benchFrame(bench);
+    }
+    benchFinish(bench);
+  }
+}
+
+/**
+ * @brief Игры с псевдослучайными действиями: в основном сдвиги и вращения,
+ * шаги времени, периодически падение фигуры и пауза.
+ */
+static void benchPlayRandom(bench_t *bench) {
+  static const UserAction_t mix[8] = {Left, Right, Action, Down,
+                                      Left, Right, Down,   Down};
+  unsigned int rnd = BENCH_SEED;
+  for (int g = 0; g < BENCH_GAMES; g++) {
+    fsmGuiSeed(BENCH_SEED + g);
+    fsmGuiAdaptive(false);
+    benchInput(bench, Start, false);
+    for (int i = 0; fsmGuiEngine()->state != GAMEOVER; i++) {
+      rnd = rnd * 1103515245u + 12345u;
+      unsigned int r = rnd >> 16;
+      UserAction_t action = mix[r & 7];
+      if (i % BENCH_PAUSE_PERIOD == 0 && i > 0) {
+        benchInput(bench, Pause, false);
+        benchInput(bench, Pause, false);
+      }
+      benchInput(bench, action, action == Down && (r & 0x70) == 0);
+      unsigned int steps = fsmGuiEngine()->step_count;
+      userTick();
+      if (fsmGuiEngine()->step_count != steps) benchFrame(bench);
+    }
+    benchFinish(bench);
+  }
+}
+
+/**
+ * @brief Псевдотерминал для newterm.
+ * @param master Ведущая сторона (неблокирующее чтение). Заполняется.
+ * @return Ведомая сторона или -1 при ошибке.
+ */
+static int benchOpenPty(int *master) {
+  int slave = -1;
+  *master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (*master >= 0 && grantpt(*master) == 0 && unlockpt(*master) == 0)
+    slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+  if (slave >= 0) {
+    struct winsize size = {.ws_row = 24, .ws_col = 80};
+    ioctl(slave, TIOCSWINSZ, &size);
+    fcntl(*master, F_SETFL, fcntl(*master, F_GETFL) | O_NONBLOCK);
+  } else if (*master >= 0) {
+    close(*master);
+  }
+  return slave;
+}
+
+/**
+ * @brief Один прогон всех игр со способом вывода backend.
+ * @param master Ведущая сторона псевдотерминала или -1 (SCREEN_MEMORY).
+ * @param slave Терминал вывода SCREEN_ANSI.
+ */
+static void benchRun(bench_t *bench, screen_backend_t backend, int master,
+                     int slave) {
+  bench->master = master;
+  screenInit(&bench->screen, backend, slave, false);
+  screenUse(&bench->screen);
+  if (backend == SCREEN_NCURSES) {
+    clear();
+    refresh();
+  }
+  if (master >= 0) benchDrain(master);
+  if (bench->log != NULL)
+    benchPlayLog(bench);
+  else
+    benchPlayRandom(bench);
+  screenClose(&bench->screen);
+}
+
+/**
+ * @brief Печать статистики прогона по режимам.
+ */
+static void benchPrint(const bench_t *bench, const char *name) {
+  for (int i = 0; i < BENCH_MODES; i++) {
+    const bench_mode_t *mode = &bench->modes[i];
+    if (mode->frames == 0) continue;
+    printf("%-8s %-9s %8lld %10.2f %12.1f\n", name, mode_names[i],
+           mode->frames, mode->time_ns / 1e3 / mode->frames,
+           (double)mode->bytes / mode->frames);
+  }
+}
+
+/**
+ * @brief Лучший (наименее зашумленный) из repeat прогонов: по каждому
+ * режиму - с наименьшим временем.
+ */
+static void benchBest(bench_t *best, const bench_t *run) {
+  for (int i = 0; i < BENCH_MODES; i++)
+    if (best->modes[i].frames == 0 ||
+        run->modes[i].time_ns < best->modes[i].time_ns)
+      best->modes[i] = run->modes[i];
+}
+
+/**
+ * @brief Запуск: bench_render [--log FILE] [--repeat N] [--term TERM].
+ */
+int main(int argc, char **argv) {
+  const char *log_path = NULL, *term = BENCH_TERM;
+  int repeat = 1, bad = 0;
+  for (int i = 1; i < argc && !bad; i++) {
+    if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+      log_path = argv[++i];
+    else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+      repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--term") == 0 && i + 1 < argc)
+      term = argv[++i];
+    else
+      bad = 1;
+  }
+  if (bad || repeat < 1) {
+    fprintf(stderr, "Usage: %s [--log FILE] [--repeat N] [--term TERM]\n",
+            argv[0]);
+    return 1;
+  }
+  replay_log_t log;
+  if (log_path != NULL && replayMap(log_path, &log)) {
+    fprintf(stderr, "%s: cannot read log %s\n", argv[0], log_path);
+    return 1;
+  }
+  srand(BENCH_SEED);
+  int master = -1, slave = benchOpenPty(&master);
+  FILE *out = slave >= 0 ? fdopen(dup(slave), "w") : NULL;
+  FILE *in = slave >= 0 ? fdopen(dup(slave), "r") : NULL;
+  SCREEN *terminal = out && in ? newterm(term, out, in) : NULL;
+  if (terminal != NULL) {
+    noecho();
+    curs_set(0);
+    ncursesColors();
+  } else {
+    fprintf(stderr, "%s: no terminal %s, memory only\n", argv[0], term);
+  }
+  // Создание игры GUI, как в main tetris
+  userInput(Start, true);
+  if (log_path != NULL)
+    printf("states: log %s, %lld games\n", log_path, log.games);
+  else
+    printf("states: %d games, seed %u\n", BENCH_GAMES, BENCH_SEED);
+  printf("%-8s %-9s %8s %10s %12s\n", "backend", "mode", "frames", "us/frame",
+         "bytes/frame");
+  static const struct {
+    const char *name;
+    screen_backend_t backend;
+  } backends[] = {{"ncurses", SCREEN_NCURSES},
+                  {"ansi", SCREEN_ANSI},
+                  {"memory", SCREEN_MEMORY}};
+  static bench_t best, run;
+  for (int b = 0; b < 3; b++) {
+    bool tty = backends[b].backend != SCREEN_MEMORY;
+    if (tty && terminal == NULL) continue;
+    best = (bench_t){.log = log_path != NULL ? &log : NULL};
+    for (int r = 0; r < repeat; r++) {
+      run = (bench_t){.log = best.log, .functions = !tty && r == 0};
+      benchRun(&run, backends[b].backend, tty ? master : -1, slave);
+      benchBest(&best, &run);
+      if (run.functions) {
+        best.glass_ns = run.glass_ns;
+        best.next_ns = run.next_ns;
+        best.stat_ns = run.stat_ns;
+        best.function_frames = run.function_frames;
+      }
+    }
+    benchPrint(&best, backends[b].name);
+  }
+  if (best.function_frames > 0)
+    printf("functions (memory, game mode): printGlass %.2f us, printNext "
+           "%.2f us, printGameStat %.2f us\n",
+           best.glass_ns / 1e3 / best.function_frames,
+           best.next_ns / 1e3 / best.function_frames,
+           best.stat_ns / 1e3 / best.function_frames);
+  userInput(Terminate, true);
+  if (terminal != NULL) {
+    endwin();
+    delscreen(terminal);
+  }
+  if (out != NULL) fclose(out);
+  if (in != NULL) fclose(in);
+  if (slave >= 0) close(slave);
+  if (master >= 0) close(master);
+  if (log_path != NULL) replayUnmap(&log);
+  return 0;
+}
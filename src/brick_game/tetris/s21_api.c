@@ -3,38 +3,105 @@
  * @brief Функции API между GUI и бекэндом (по ТЗ).
  */
 
+#include "s21_api.h"
 #include "s21_tetris_fsm.h"
+#include "s21_tetris_replay.h"
+
+/// Журнал ввода игр GUI (userRecord) или NULL
+static replay_recorder_t *api_recorder = NULL;
+
+/**
+ * @brief Запись ввода игр GUI в журнал.
+ * @param recorder Журнал (replayRecorderOpen) или NULL - запись отключена.
+ */
+void userRecord(replay_recorder_t *recorder) { api_recorder = recorder; }
+
+/**
+ * @brief Адаптивная сложность (скорость и веса фигур по навыку игрока) для
+ * следующих игр GUI.
+ */
+void userAdaptive(bool enabled) { fsmGuiAdaptive(enabled); }
 
 /**
  * @brief Функция приема пользовательского ввода
  *
  * Принимает ввод действий пользователя, а также действия начала и конца игры.
- * Передает в FSM сформированный сигнал. Получает состояние FSM по результату.
- * Если состояние FSM не требует действий пользователя, то снова запускается FSM
+ * Передает в FSM сформированный сигнал. Состояния FSM, не требующие действий
+ * пользователя, обрабатываются FSM в рамках этого же вызова.
  * @param action Действие пользователя (или GUI)
  * @param hold Уточнение действия (падение фигуры, старт / завершение программы)
  */
 void userInput(UserAction_t action, bool hold) {
   tetris_state state = 0;
-  signal_t signal;
-  signal.action = action;
-  signal.signal = ACT_SIG;
-  // Создание массивов при запуске программы
-  if (signal.action == Start && hold) signal.signal = INIT_SIG;
-  // Нажатие стрелки вниз (падение фигуры) отличается от сдвига вниз по таймеру
-  if (signal.action == Down && hold) signal.signal = DROP_SIG;
-  // Очистка памяти перед выходом из программы
-  if (signal.action == Terminate && hold) signal.signal = DESTR_SIG;
-
-  // Для SPAWN и ATTACHING не требуется новых сигналов,
-  // сразу передаем обратно в FSM
-  bool return_flag = false;
-  while (!return_flag) {
-    fsm(&signal, &state);
-    if (state != SPAWN && state != ATTACHING) {
-      return_flag = true;
+  signal_t signal = makeSignal(action, hold);
+
+  // SPAWN и ATTACHING проходятся внутри того же шага FSM
+  fsm(&signal, &state);
+  replayRecord(api_recorder, fsmGuiEngine(), REPLAY_INPUT, action, hold);
+}
+
+/**
+ * @brief Нажатие или отпускание клавиши с автоповтором (Left, Right -
+ * сдвиг, Down - мягкое падение). Повтор выполняет игра по шагам времени.
+ * @param action Клавиша (действие).
+ * @param pressed true - нажатие, false - отпускание.
+ */
+void userKey(UserAction_t action, bool pressed) {
+  tetris_state state;
+  signal_t signal = {action, pressed ? PRESS_SIG : RELEASE_SIG};
+  fsm(&signal, &state);
+  replayRecord(api_recorder, fsmGuiEngine(), REPLAY_KEY, action, pressed);
+}
+
+/**
+ * @brief Клавиша с автоповтором от терминала, который не сообщает об
+ * отпускании, а удержание передает повторами клавиши.
+ *
+ * Нажатие - один сдвиг (возвращается для userInput), как и короткое
+ * нажатие. Клавиша считается удерживаемой, когда приходит первый повтор
+ * терминала (не позже KEY_REPEAT_DELAY_NS, задержка автоповтора терминала
+ * 250-600 мс): тогда она передается в игру нажатием (userKey), и автоповтор
+ * выполняет игра. Отпущенной удерживаемая клавиша считается, если повторов
+ * нет дольше KEY_RELEASE_NS, или при нажатии другой клавиши.
+ * @param held Клавиша, нажатая сейчас. Обновляется.
+ * @param action Действие нажатой клавиши с автоповтором (Left, Right) или
+ * Up, если нажата другая клавиша или нажатий нет.
+ * @param key Была нажата какая-либо клавиша.
+ * @param now Текущее время, нс.
+ * @return Действие для userInput или Up.
+ */
+UserAction_t userHeldKey(held_key_t *held, UserAction_t action, bool key,
+                         long long now) {
+  UserAction_t res = Up;
+  long long timeout = held->repeating ? KEY_RELEASE_NS : KEY_REPEAT_DELAY_NS;
+  if (held->action != Up &&
+      (now - held->last > timeout || (key && action != held->action))) {
+    if (held->repeating) userKey(held->action, false);
+    held->action = Up;
+  }
+  if (action != Up) {
+    if (held->action == Up) {
+      res = action;
+      held->repeating = false;
+    } else if (!held->repeating) {
+      userKey(action, true);
+      held->repeating = true;
     }
+    held->action = action;
+    held->last = now;
   }
+  return res;
+}
+
+/**
+ * @brief Один шаг времени игры (TIMING_TICK_NS): автоповтор, мягкое
+ * падение, гравитация, задержка фиксации.
+ */
+void userTick() {
+  tetris_state state;
+  signal_t signal = {Up, TICK_SIG};
+  fsm(&signal, &state);
+  replayRecord(api_recorder, fsmGuiEngine(), REPLAY_TICK, Up, 1);
 }
 
 /**
@@ -4,8 +4,25 @@
 #include <stdbool.h>
 
 #include "../../gui/cli/s21_define.h"
+#include "s21_tetris_replay.h"
+
+/// @brief Клавиша с автоповтором, которая сейчас нажата (userHeldKey)
+typedef struct {
+  /// Действие клавиши, Up - не нажата
+  UserAction_t action;
+  /// Время последнего нажатия или повтора терминала, нс
+  long long last;
+  /// Повторы терминала уже пришли: клавиша удерживается
+  bool repeating;
+} held_key_t;
 
 void userInput(UserAction_t action, bool hold);
+void userKey(UserAction_t action, bool pressed);
+UserAction_t userHeldKey(held_key_t *held, UserAction_t action, bool key,
+                         long long now);
+void userTick();
 GameInfo_t updateCurrentState();
+void userRecord(replay_recorder_t *recorder);
+void userAdaptive(bool enabled);
 
 #endif  // API_BACK_H
\ No newline at end of file
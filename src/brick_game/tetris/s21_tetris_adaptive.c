@@ -0,0 +1,127 @@
+/**
+ * @file s21_tetris_adaptive.c
+ * @brief Адаптивная сложность: скорость падения и веса выбора фигур по
+ * оценке навыка игрока.
+ *
+ * После закрепления каждой фигуры обновляются скользящие средние времени
+ * на фигуру, высоты стакана и количества закрытых пустых клеток, по ним -
+ * оценка навыка. Скорость уровня (как в fsmAttach) изменяется до
+ * +-ADAPTIVE_SPEED_RANGE: новичку медленнее, опытному игроку быстрее. Веса
+ * удобных фигур (O, I) и неудобных (S, Z) сдвигаются в пользу новичка или
+ * против опытного игрока, сумма весов не меняется.
+ *
+ * Обновление - один проход по полю фиксированного размера и несколько
+ * целочисленных операций, без выделения памяти, поэтому режим можно держать
+ * включенным в любой игре. Выключенный режим (по умолчанию) игру не меняет:
+ * веса фигур нулевые, скорость считается только по уровню.
+ */
+#include "s21_tetris_adaptive.h"
+
+#include <string.h>
+
+// id фигур, веса которых подстраиваются (порядок шаблонов getPiece)
+#define ADAPTIVE_O 0
+#define ADAPTIVE_I 1
+#define ADAPTIVE_Z 2
+#define ADAPTIVE_S 3
+
+/**
+ * @brief Начало игры: средние - середина между новичком и опытным игроком,
+ * веса фигур равные. Выключенный режим оставляет веса нулевыми (tetrisInit).
+ */
+void adaptiveReset(engine_t *engine) {
+  adaptive_t *adaptive = &engine->adaptive;
+  adaptive->placement =
+      (ADAPTIVE_FAST_TICKS + ADAPTIVE_SLOW_TICKS) * ADAPTIVE_ONE / 2;
+  adaptive->height =
+      (ADAPTIVE_LOW_STACK + ADAPTIVE_HIGH_STACK) * ADAPTIVE_ONE / 2;
+  adaptive->holes = ADAPTIVE_MAX_HOLES * ADAPTIVE_ONE / 2;
+  adaptive->skill = ADAPTIVE_ONE / 2;
+  adaptive->spawn_tick = engine->timing.ticks;
+  if (adaptive->active)
+    memset(engine->addinfo.piece_weights, ADAPTIVE_WEIGHT,
+           sizeof(engine->addinfo.piece_weights));
+}
+
+/**
+ * @brief Появление фигуры: начало отсчета времени на фигуру.
+ */
+void adaptiveSpawn(engine_t *engine) {
+  engine->adaptive.spawn_tick = engine->timing.ticks;
+}
+
+/**
+ * @brief Высота стакана и закрытые пустые клетки (под занятой клеткой
+ * своего столбца).
+ *
+ * Поле проходится по строкам сверху вниз с маской столбцов, уже закрытых
+ * сверху: пустые клетки строки под маской - закрытые.
+ */
+void adaptiveFieldStats(cell_t **field, int *height, int *holes) {
+  unsigned int covered = 0;
+  *height = 0;
+  *holes = 0;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    unsigned int bits = 0;
+#pragma GCC unroll 10
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      bits |= (unsigned int)(field[i][j] != 0) << j;
+    if (bits && !covered) *height = FIELD_ROWS - i;
+    *holes += __builtin_popcount(covered & ~bits);
+    covered |= bits;
+  }
+}
+
+/**
+ * @brief Обновление скользящего среднего значением sample.
+ */
+static int adaptiveAverage(int average, int sample) {
+  return average + (sample * ADAPTIVE_ONE - average) / (1 << ADAPTIVE_SHIFT);
+}
+
+/**
+ * @brief Оценка по одному показателю: ADAPTIVE_ONE при значении good и
+ * лучше, 0 при bad и хуже, между ними - линейно.
+ */
+static int adaptiveScale(int average, int bad, int good) {
+  int res = (bad * ADAPTIVE_ONE - average) / (bad - good);
+  if (res < 0) res = 0;
+  if (res > ADAPTIVE_ONE) res = ADAPTIVE_ONE;
+  return res;
+}
+
+/**
+ * @brief Закрепление фигуры: обновление оценки навыка, скорости и весов
+ * фигур. Вызывается из fsmAttach после подсчета уровня.
+ */
+void adaptivePiece(engine_t *engine) {
+  adaptive_t *adaptive = &engine->adaptive;
+  GameInfo_t *game_info = &engine->game_info;
+  unsigned long long ticks = engine->timing.ticks - adaptive->spawn_tick;
+  if (ticks > 4 * ADAPTIVE_SLOW_TICKS) ticks = 4 * ADAPTIVE_SLOW_TICKS;
+  int height, holes;
+  adaptiveFieldStats(game_info->field, &height, &holes);
+  adaptive->placement = adaptiveAverage(adaptive->placement, (int)ticks);
+  adaptive->height = adaptiveAverage(adaptive->height, height);
+  adaptive->holes = adaptiveAverage(adaptive->holes, holes);
+  adaptive->skill = (adaptiveScale(adaptive->placement, ADAPTIVE_SLOW_TICKS,
+                                   ADAPTIVE_FAST_TICKS) +
+                     adaptiveScale(adaptive->height, ADAPTIVE_HIGH_STACK,
+                                   ADAPTIVE_LOW_STACK) +
+                     adaptiveScale(adaptive->holes, ADAPTIVE_MAX_HOLES, 0)) /
+                    3;
+  // Отклонение навыка от среднего: от -ADAPTIVE_ONE / 2 (новичок) до
+  // ADAPTIVE_ONE / 2 (опытный игрок)
+  int delta = adaptive->skill - ADAPTIVE_ONE / 2;
+  int speed = START_SPEED - (game_info->level - 1) * STEP_SPEED;
+  speed -= speed * delta * 2 * ADAPTIVE_SPEED_RANGE /
+           (ADAPTIVE_ONE * ADAPTIVE_ONE);
+  if (speed < ADAPTIVE_SPEED_MIN) speed = ADAPTIVE_SPEED_MIN;
+  if (speed > ADAPTIVE_SPEED_MAX) speed = ADAPTIVE_SPEED_MAX;
+  game_info->speed = speed;
+  int shift = -delta * ADAPTIVE_WEIGHT_RANGE / (ADAPTIVE_ONE / 2);
+  unsigned char *weights = engine->addinfo.piece_weights;
+  memset(weights, ADAPTIVE_WEIGHT, sizeof(engine->addinfo.piece_weights));
+  weights[ADAPTIVE_O] = weights[ADAPTIVE_I] = ADAPTIVE_WEIGHT + shift;
+  weights[ADAPTIVE_Z] = weights[ADAPTIVE_S] = ADAPTIVE_WEIGHT - shift;
+}
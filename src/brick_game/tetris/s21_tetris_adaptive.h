@@ -0,0 +1,32 @@
+#ifndef TETRIS_ADAPTIVE_H
+#define TETRIS_ADAPTIVE_H
+
+#include "s21_tetris_fsm.h"
+
+// Единица оценок адаптивной сложности (фиксированная точка)
+#define ADAPTIVE_ONE 256
+// Сглаживание средних: новое значение входит с весом 1 / 2^ADAPTIVE_SHIFT
+#define ADAPTIVE_SHIFT 3
+// Время на фигуру, шагов времени: опытный игрок и новичок
+#define ADAPTIVE_FAST_TICKS 30
+#define ADAPTIVE_SLOW_TICKS 180
+// Высота стакана, строк: опытный игрок и новичок
+#define ADAPTIVE_LOW_STACK 4
+#define ADAPTIVE_HIGH_STACK 14
+// Закрытых пустых клеток у новичка (у опытного игрока - 0)
+#define ADAPTIVE_MAX_HOLES 8
+// Изменение скорости уровня: до +-30% (в долях ADAPTIVE_ONE)
+#define ADAPTIVE_SPEED_RANGE 77
+// Границы скорости game_info.speed
+#define ADAPTIVE_SPEED_MIN 800
+#define ADAPTIVE_SPEED_MAX (START_SPEED + 2 * STEP_SPEED)
+// Вес фигуры без подстройки и наибольшее изменение веса O, I, S, Z
+#define ADAPTIVE_WEIGHT 16
+#define ADAPTIVE_WEIGHT_RANGE 8
+
+void adaptiveReset(engine_t *engine);
+void adaptiveSpawn(engine_t *engine);
+void adaptivePiece(engine_t *engine);
+void adaptiveFieldStats(cell_t **field, int *height, int *holes);
+
+#endif  // TETRIS_ADAPTIVE_H
@@ -4,6 +4,83 @@
  */
 #include "s21_tetris_backend.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+unsigned long long zobrist_keys[FIELD_ROWS][FIELD_COLUMNS];
+static pthread_once_t zobrist_once = PTHREAD_ONCE_INIT;
+// Предзагрузка рекорда: поток, признак запуска и прочитанное значение
+static pthread_mutex_t high_score_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t high_score_thread;
+static bool high_score_pending = false;
+static int high_score_loaded = 0;
+// Рекорд после предзагрузки (-1 - нет), читается без блокировки
+static atomic_int high_score_cached = -1;
+
+/**
+ * @brief Заполнение ключей Зобриста (генератор splitmix64, постоянный seed,
+ * поэтому хеши одинаковых полей совпадают между запусками).
+ */
+static void zobristFill() {
+  unsigned long long state = 0x5A0B1257ULL;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    for (int j = 0; j < FIELD_COLUMNS; j++) {
+      unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      zobrist_keys[i][j] = z ^ (z >> 31);
+    }
+  }
+}
+
+/**
+ * @brief Однократное заполнение ключей Зобриста (безопасно из нескольких
+ * потоков).
+ */
+void zobristInit() { pthread_once(&zobrist_once, zobristFill); }
+
+/**
+ * @brief Хеш Зобриста заполнения поля, посчитанный заново по всем клеткам.
+ *
+ * Хеш зависит только от того, какие клетки заняты (не от цвета).
+ */
+unsigned long long fieldHash(cell_t **field) {
+  unsigned long long hash = 0;
+  for (int i = 0; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (field[i][j]) hash ^= zobrist_keys[i][j];
+  return hash;
+}
+
+/**
+ * @brief Создание массивов для игры без инициализации партии (ее выполняет
+ * старт игры, tetrisInit). Поле пустое, значения - как на стартовом
+ * экране. При ошибке выделения памяти game_info.pause устанавливается в
+ * EXIT_MODE, для выхода из программы.
+ *
+ * @param game_info Информация о состоянии игры для GUI.
+ * @param fsm_addinfo Доп. инфо FSM. Задается начальное значение генератора.
+ */
+void tetrisAllocate(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+  game_info->field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  game_info->next = createMatrix(PIECE_ROWS, PIECE_COLUMNS);
+  fsm_addinfo->piece = createMatrix(PIECE_ROWS, PIECE_COLUMNS);
+  // Начальное значение генератора берется из общего rand() (srand в main)
+  fsm_addinfo->seed = (unsigned int)rand();
+  game_info->hash = 0;
+  game_info->score = 0;
+  game_info->high_score = 0;
+  game_info->level = 1;
+  game_info->speed = START_SPEED;
+  game_info->pause = START_MODE;
+  zobristInit();
+  if (game_info->field == NULL || game_info->next == NULL ||
+      fsm_addinfo->piece == NULL)
+    game_info->pause = EXIT_MODE;
+}
+
 /**
  * @brief Создание массивов для игры и инициализация. При ошибке выделения
  * памяти game_info.pause устанавливается в EXIT_MODE, для выхода из программы.
@@ -13,15 +90,8 @@
  * @param fsm_addinfo Доп. инфо FSM. Устанавливаются начальные значения.
  */
 void tetrisCreate(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
-  game_info->field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
-  game_info->next = createMatrix(PIECE_ROWS, PIECE_COLUMNS);
-  fsm_addinfo->piece = createMatrix(PIECE_ROWS, PIECE_COLUMNS);
-  if (game_info->field == NULL || game_info->next == NULL ||
-      fsm_addinfo->piece == NULL) {
-    game_info->pause = EXIT_MODE;
-  } else {
-    tetrisInit(game_info, fsm_addinfo);
-  }
+  tetrisAllocate(game_info, fsm_addinfo);
+  if (game_info->pause != EXIT_MODE) tetrisInit(game_info, fsm_addinfo);
 }
 
 /**
@@ -31,73 +101,216 @@ void tetrisCreate(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
  * @param fsm_addinfo Доп. инфо FSM. Очистка поля piece.
  */
 void tetrisDestroy(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
-  if (game_info->field != NULL) {
-    free(game_info->field[0]);
-    free(game_info->field);
-    game_info->field = NULL;
-  }
-  if (game_info->next != NULL) {
-    free(game_info->next[0]);
-    free(game_info->next);
-    game_info->next = NULL;
-  }
-  if (fsm_addinfo->piece != NULL) {
-    free(fsm_addinfo->piece[0]);
-    free(fsm_addinfo->piece);
-    fsm_addinfo->piece = NULL;
-  }
+  freeMatrix(game_info->field);
+  game_info->field = NULL;
+  freeMatrix(game_info->next);
+  game_info->next = NULL;
+  freeMatrix(fsm_addinfo->piece);
+  fsm_addinfo->piece = NULL;
 }
 
 /**
  * @brief Сброс начальных значений при старте каждой игры.
+ *
+ * Рекорд (game_info->high_score) сохраняется между играми.
  */
 void tetrisInit(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
   for (int i = 0; i < FIELD_ROWS; i++)
     for (int j = 0; j < FIELD_COLUMNS; j++) game_info->field[i][j] = 0;
+  game_info->hash = 0;
   game_info->score = 0;
   game_info->level = 1;
   game_info->speed = START_SPEED;
   game_info->pause = START_MODE;
-  game_info->high_score = getHighScore();
 
   fsm_addinfo->col_pos = 0;
   fsm_addinfo->row_pos = 0;
   fsm_addinfo->piece_id = 0;
   fsm_addinfo->piece_rot_id = 0;
-  fsm_addinfo->next_id = 0;
-  fsm_addinfo->next_rot_id = 0;
-  genNextPiece(game_info, fsm_addinfo);
+  memset(fsm_addinfo->piece_weights, 0, sizeof(fsm_addinfo->piece_weights));
+  fsm_addinfo->next_id = nextRandom(fsm_addinfo) % 7;
+  fsm_addinfo->next_rot_id = nextRandom(fsm_addinfo) % 4;
+  for (int i = 0; i < PREVIEW_MAX - 1; i++) {
+    int id = nextRandom(fsm_addinfo) % 7;
+    int rot_id = nextRandom(fsm_addinfo) % 4;
+    fsm_addinfo->queue[i] = (unsigned char)(id * 4 + rot_id);
+  }
+  fsm_addinfo->queue_head = 0;
+  fsm_addinfo->has_hold = false;
+  fsm_addinfo->hold_id = 0;
+  fsm_addinfo->hold_rot_id = 0;
+  fsm_addinfo->hold_used = false;
+}
+
+/**
+ * @brief Байт на массив rows x cols (createMatrix): указатели строк и
+ * клетки.
+ */
+static size_t matrixSize(int rows, int cols) {
+  return rows * sizeof(cell_t *) + rows * cols * sizeof(cell_t);
 }
 
 /**
  * @brief Создание двумерного массива размера rows x cols.
+ *
+ * Указатели строк и клетки (по строкам подряд) выделяются одним блоком.
  * При ошибке выделения памяти возвращает NULL.
  */
-int **createMatrix(int rows, int cols) {
-  int **res = (int **)calloc(rows, sizeof(int *));
-  int *matrix = (int *)calloc(rows * cols, sizeof(int));
-  if (res == NULL || matrix == NULL) {
-    if (res) free(res);
-    if (matrix) free(matrix);
-    res = NULL;
-  } else {
-    for (int i = 0; i < rows; i++) res[i] = matrix + cols * i;
+cell_t **createMatrix(int rows, int cols) {
+  cell_t **res = (cell_t **)calloc(1, matrixSize(rows, cols));
+  if (res != NULL) {
+    cell_t *cells = (cell_t *)(res + rows);
+    for (int i = 0; i < rows; i++) res[i] = cells + cols * i;
   }
   return res;
 }
 
 /**
- * @brief Генерация новой следующей фигуры. Фигура определяется по двум
- * случайным числам - id фигуры и id вращения.
- * @param game_info Информация о состоянии игры. Заполняется next.
- * @param fsm_addinfo Доп. инфо FSM. Заполняются поля с id для next.
+ * @brief Освобождение массива createMatrix (NULL игнорируется).
+ */
+void freeMatrix(cell_t **matrix) { free(matrix); }
+
+/**
+ * @brief Память одной игры: engine_t и массивы поля, следующей и текущей
+ * фигуры (без служебных данных malloc), байт.
+ */
+size_t engineMemory() {
+  return sizeof(engine_t) + matrixSize(FIELD_ROWS, FIELD_COLUMNS) +
+         2 * matrixSize(PIECE_ROWS, PIECE_COLUMNS);
+}
+
+/**
+ * @brief Псевдослучайное число от 0 до 32767.
+ *
+ * Линейный конгруэнтный генератор, состояние которого хранится в fsm_addinfo,
+ * поэтому несколько игр в одном процессе не влияют друг на друга, а при
+ * одинаковом seed последовательность фигур повторяется.
+ * @param fsm_addinfo Доп. инфо FSM. Изменяется состояние генератора.
+ */
+int nextRandom(addinfo_t *fsm_addinfo) {
+  fsm_addinfo->seed = fsm_addinfo->seed * 1103515245u + 12345u;
+  return (int)((fsm_addinfo->seed >> 16) & 0x7FFF);
+}
+
+/**
+ * @brief id фигуры по случайному числу: равновероятно или, если заданы,
+ * по весам piece_weights (адаптивная сложность).
+ */
+static int randomPiece(const addinfo_t *fsm_addinfo, int random) {
+  const unsigned char *weights = fsm_addinfo->piece_weights;
+  int total = 0;
+  for (int i = 0; i < 7; i++) total += weights[i];
+  int id = random % 7;
+  if (total > 0) {
+    int rest = random % total;
+    for (id = 0; rest >= weights[id]; id++) rest -= weights[id];
+  }
+  return id;
+}
+
+/**
+ * @brief Сдвиг очереди фигур: следующей становится первая фигура очереди,
+ * в конец очереди добавляется новая. Фигура определяется по двум
+ * случайным числам - id фигуры (randomPiece) и id вращения.
+ *
+ * Очередь - кольцевой буфер id, поэтому сдвиг не зависит от ее длины.
+ * Матрица game_info->next (по ТЗ) не заполняется: она строится по
+ * next_id и next_rot_id при чтении состояния (updateCurrentState).
+ * @param game_info Информация о состоянии игры. Не изменяется.
+ * @param fsm_addinfo Доп. инфо FSM. Изменяются id для next и очередь.
  */
 void genNextPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
-  fsm_addinfo->next_id = rand() % 7;
-  fsm_addinfo->next_rot_id = rand() % 4;
-  getPiece(game_info->next, fsm_addinfo->next_id, fsm_addinfo->next_rot_id);
+  (void)game_info;
+  unsigned char *slot = &fsm_addinfo->queue[fsm_addinfo->queue_head];
+  fsm_addinfo->next_id = *slot / 4;
+  fsm_addinfo->next_rot_id = *slot % 4;
+  int id = randomPiece(fsm_addinfo, nextRandom(fsm_addinfo));
+  int rot_id = nextRandom(fsm_addinfo) % 4;
+  *slot = (unsigned char)(id * 4 + rot_id);
+  fsm_addinfo->queue_head = (fsm_addinfo->queue_head + 1) % (PREVIEW_MAX - 1);
+}
+
+/**
+ * @brief Фигура из очереди известных.
+ * @param k Номер: 0 - следующая (next_id), дальше - очередь, меньше
+ * PREVIEW_MAX.
+ * @param rot_id id вращения фигуры. Заполняется.
+ * @return id фигуры.
+ */
+int previewPiece(const addinfo_t *fsm_addinfo, int k, int *rot_id) {
+  int id = fsm_addinfo->next_id;
+  *rot_id = fsm_addinfo->next_rot_id;
+  if (k > 0) {
+    int index = (fsm_addinfo->queue_head + k - 1) % (PREVIEW_MAX - 1);
+    int code = fsm_addinfo->queue[index];
+    id = code / 4;
+    *rot_id = code % 4;
+  }
+  return id;
 }
 
+/// Шаблоны фигур [id][id вращения]. Вращение с id + 1 - по часовой стрелке.
+static const cell_t pieces[7][4][PIECE_ROWS][PIECE_COLUMNS] = {
+    {{{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}},
+    {{{2, 2, 2, 2}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}},
+     {{2, 2, 2, 2}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}}},
+    {{{0, 3, 3, 0}, {0, 0, 3, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 3, 0}, {0, 3, 3, 0}, {0, 3, 0, 0}, {0, 0, 0, 0}},
+     {{0, 3, 3, 0}, {0, 0, 3, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 3, 0}, {0, 3, 3, 0}, {0, 3, 0, 0}, {0, 0, 0, 0}}},
+    {{{0, 0, 4, 4}, {0, 4, 4, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 4, 0, 0}, {0, 4, 4, 0}, {0, 0, 4, 0}, {0, 0, 0, 0}},
+     {{0, 0, 4, 4}, {0, 4, 4, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 4, 0, 0}, {0, 4, 4, 0}, {0, 0, 4, 0}, {0, 0, 0, 0}}},
+    {{{0, 5, 5, 5}, {0, 0, 0, 5}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 5, 0}, {0, 0, 5, 0}, {0, 5, 5, 0}, {0, 0, 0, 0}},
+     {{0, 5, 0, 0}, {0, 5, 5, 5}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 5, 5, 0}, {0, 5, 0, 0}, {0, 5, 0, 0}, {0, 0, 0, 0}}},
+    {{{0, 6, 6, 6}, {0, 6, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 6, 6, 0}, {0, 0, 6, 0}, {0, 0, 6, 0}, {0, 0, 0, 0}},
+     {{0, 0, 0, 6}, {0, 6, 6, 6}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 6, 0, 0}, {0, 6, 0, 0}, {0, 6, 6, 0}, {0, 0, 0, 0}}},
+    {{{0, 7, 7, 7}, {0, 0, 7, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 0, 7, 0}, {0, 7, 7, 0}, {0, 0, 7, 0}, {0, 0, 0, 0}},
+     {{0, 0, 7, 0}, {0, 7, 7, 7}, {0, 0, 0, 0}, {0, 0, 0, 0}},
+     {{0, 7, 0, 0}, {0, 7, 7, 0}, {0, 7, 0, 0}, {0, 0, 0, 0}}}};
+
+/// @brief Смещения {столбец, строка} для проверок вращения по схеме SRS:
+/// [id вращения до поворота][0 - по часовой, 1 - против][номер проверки].
+/// Строка растет вниз. Для фигур J, L, S, T, Z (и O, у которой первая
+/// проверка без смещения всегда успешна).
+static const signed char kicks_jlstz[4][2][KICK_TESTS][2] = {
+    {{{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},
+     {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}}},
+    {{{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},
+     {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}},
+    {{{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
+     {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}},
+    {{{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},
+     {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}}};
+/// Битовые маски шаблонов фигур [id][id вращения]: бит i * PIECE_COLUMNS + j -
+/// непустая клетка строки i, столбца j (соответствуют шаблонам pieces).
+const unsigned short piece_masks[7][4] = {
+    {0x0066, 0x0066, 0x0066, 0x0066}, {0x000F, 0x4444, 0x000F, 0x4444},
+    {0x00C6, 0x0264, 0x00C6, 0x0264}, {0x006C, 0x0462, 0x006C, 0x0462},
+    {0x008E, 0x0644, 0x00E2, 0x0226}, {0x002E, 0x0446, 0x00E8, 0x0622},
+    {0x004E, 0x0464, 0x00E4, 0x0262}};
+/// Смещения для проверок вращения фигуры I, индексы как у kicks_jlstz.
+static const signed char kicks_i[4][2][KICK_TESTS][2] = {
+    {{{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}},
+     {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}}},
+    {{{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}},
+     {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}}},
+    {{{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}},
+     {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}}},
+    {{{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}},
+     {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}}}};
+
 /**
  * @brief Передает "шаблон" фигуры по ее id. Цифры заполнения соответствуют
  * цветовой схеме для этой фигуры.
@@ -106,57 +319,33 @@ void genNextPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
  * @param id Номер, определяющий тип фигуры (от 0 до 6).
  * @param rot_id Номер вращения, определяющий поворот фигуры (от 0 до 4).
  */
-void getPiece(int **dst, int id, int rot_id) {
-  // static чтобы не пересоздавать массив при каждом вызове
-  static int src[7][4][PIECE_ROWS][PIECE_COLUMNS] = {
-      {{{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 1, 1, 0}, {0, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}},
-      {{{2, 2, 2, 2}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}},
-       {{2, 2, 2, 2}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}, {0, 0, 2, 0}}},
-      {{{0, 3, 3, 0}, {0, 0, 3, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 3, 0}, {0, 3, 3, 0}, {0, 3, 0, 0}, {0, 0, 0, 0}},
-       {{0, 3, 3, 0}, {0, 0, 3, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 3, 0}, {0, 3, 3, 0}, {0, 3, 0, 0}, {0, 0, 0, 0}}},
-      {{{0, 0, 4, 4}, {0, 4, 4, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 4, 0, 0}, {0, 4, 4, 0}, {0, 0, 4, 0}, {0, 0, 0, 0}},
-       {{0, 0, 4, 4}, {0, 4, 4, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 4, 0, 0}, {0, 4, 4, 0}, {0, 0, 4, 0}, {0, 0, 0, 0}}},
-      {{{0, 5, 5, 5}, {0, 0, 0, 5}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 5, 0}, {0, 0, 5, 0}, {0, 5, 5, 0}, {0, 0, 0, 0}},
-       {{0, 5, 0, 0}, {0, 5, 5, 5}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 5, 5, 0}, {0, 5, 0, 0}, {0, 5, 0, 0}, {0, 0, 0, 0}}},
-      {{{0, 6, 6, 6}, {0, 6, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 6, 6, 0}, {0, 0, 6, 0}, {0, 0, 6, 0}, {0, 0, 0, 0}},
-       {{0, 0, 0, 6}, {0, 6, 6, 6}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 6, 0, 0}, {0, 6, 0, 0}, {0, 6, 6, 0}, {0, 0, 0, 0}}},
-      {{{0, 7, 7, 7}, {0, 0, 7, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 0, 7, 0}, {0, 7, 7, 0}, {0, 0, 7, 0}, {0, 0, 0, 0}},
-       {{0, 0, 7, 0}, {0, 7, 7, 7}, {0, 0, 0, 0}, {0, 0, 0, 0}},
-       {{0, 7, 0, 0}, {0, 7, 7, 0}, {0, 7, 0, 0}, {0, 0, 0, 0}}}};
+void getPiece(cell_t **dst, int id, int rot_id) {
   for (int i = 0; i < PIECE_ROWS; i++)
-    for (int j = 0; j < PIECE_COLUMNS; j++) dst[i][j] = src[id][rot_id][i][j];
+    for (int j = 0; j < PIECE_COLUMNS; j++)
+      dst[i][j] = pieces[id][rot_id][i][j];
 }
 
 /**
- * @brief Перенос фигуры (шаблона и id) из next в текущую. Сброс
- * координат фигуры на поле на стартовые.
+ * @brief Битовая маска шаблона фигуры: бит i * PIECE_COLUMNS + j - непустая
+ * клетка строки i, столбца j.
+ */
+int pieceMask(int id, int rot_id) { return piece_masks[id][rot_id]; }
+
+/**
+ * @brief Перенос фигуры (id) из next в текущую, шаблон берется из таблицы
+ * фигур. Сброс координат фигуры на поле на стартовые.
  * @param game_info Информация о состоянии игры. Не изменяется.
- * @param fsm_addinfo Доп. инфо FSM. Заполняется шаблон из game_info->next,
+ * @param fsm_addinfo Доп. инфо FSM. Заполняется шаблон по next_id,
  * id текущей фигуры, сбрасываются координаты положения фигуры на начальные.
  */
 void fromNextIntoCurrent(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
   fsm_addinfo->piece_id = fsm_addinfo->next_id;
   fsm_addinfo->piece_rot_id = fsm_addinfo->next_rot_id;
   fsm_addinfo->row_pos = 0;
-  fsm_addinfo->col_pos = 3;
-  for (int i = 0; i < PIECE_ROWS; i++)
-    for (int j = 0; j < PIECE_COLUMNS; j++) {
-      fsm_addinfo->piece[i][j] = game_info->next[i][j];
-    }
+  fsm_addinfo->col_pos = SPAWN_COL;
+  (void)game_info;
+  getPiece(fsm_addinfo->piece, fsm_addinfo->piece_id,
+           fsm_addinfo->piece_rot_id);
 }
 
 /**
@@ -185,34 +374,53 @@ int checkPlacePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
   return res;
 }
 
+/**
+ * @brief Проверка, что клетка (row, col) находится на поле.
+ */
+static inline int isOnField(int row, int col) {
+  return row >= 0 && row < FIELD_ROWS && col >= 0 && col < FIELD_COLUMNS;
+}
+
 /**
  * @brief Размещение фигуры на поле по текущим координатам.
  *
- * @param game_info Информация о состоянии игры. Изменяется field.
+ * Хеш поля обновляется по клеткам, которые были пустыми. Клетки вне поля не
+ * записываются (координаты проверяются заранее checkPlacePiece, но запись за
+ * пределы массива недопустима и при ошибке в вызывающем коде).
+ * @param game_info Информация о состоянии игры. Изменяются field, hash.
  * @param fsm_addinfo Доп. инфо FSM (текущая фигура). Не изменяется.
  */
 void placePieceOnField(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
   for (int i = 0; i < PIECE_ROWS; i++) {
     for (int j = 0; j < PIECE_COLUMNS; j++) {
       if (fsm_addinfo->piece[i][j]) {
-        game_info->field[i + fsm_addinfo->row_pos][j + fsm_addinfo->col_pos] =
-            fsm_addinfo->piece[i][j];
+        int row = i + fsm_addinfo->row_pos, col = j + fsm_addinfo->col_pos;
+        if (isOnField(row, col)) {
+          if (!game_info->field[row][col])
+            game_info->hash ^= zobrist_keys[row][col];
+          game_info->field[row][col] = fsm_addinfo->piece[i][j];
+        }
       }
     }
   }
 }
 
 /**
- * @brief Удаление текущей фигуры с поля перед ее перемещением.
- * @param game_info Информация о состоянии игры. Изменяется field.
+ * @brief Удаление текущей фигуры с поля перед ее перемещением. Клетки вне
+ * поля пропускаются.
+ * @param game_info Информация о состоянии игры. Изменяются field, hash.
  * @param fsm_addinfo Доп. инфо FSM (текущая фигура). Не изменяется.
  */
 void removePieceFromField(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
   for (int i = 0; i < PIECE_ROWS; i++) {
     for (int j = 0; j < PIECE_COLUMNS; j++) {
       if (fsm_addinfo->piece[i][j]) {
-        game_info->field[i + fsm_addinfo->row_pos][j + fsm_addinfo->col_pos] =
-            0;
+        int row = i + fsm_addinfo->row_pos, col = j + fsm_addinfo->col_pos;
+        if (isOnField(row, col)) {
+          if (game_info->field[row][col])
+            game_info->hash ^= zobrist_keys[row][col];
+          game_info->field[row][col] = 0;
+        }
       }
     }
   }
@@ -235,25 +443,68 @@ void shiftPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo, int shift) {
 }
 
 /**
- * @brief Вращение фигуры. При невозможности вращения фигура остается на месте.
+ * @brief Маска строки поля: столбец j - бит j + KICK_MARGIN. Клетки за
+ * стенами, а также строки вне поля (выше и ниже) считаются занятыми.
+ */
+static unsigned int fieldRowMask(GameInfo_t *game_info, int row) {
+  unsigned int mask = ~0u;
+  if (row >= 0 && row < FIELD_ROWS) {
+    mask = ~(((1u << FIELD_COLUMNS) - 1) << KICK_MARGIN);
+    const cell_t *cells = game_info->field[row];
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      mask |= (unsigned int)(cells[j] != 0) << (j + KICK_MARGIN);
+  }
+  return mask;
+}
+
+/**
+ * @brief Вращение фигуры со смещениями (wall kicks) по схеме SRS. При
+ * невозможности вращения фигура остается на месте.
  *
- * Текущая фигура заменяется на фигуру со следующим id вращения, проверяется
- * возможность ее помещения на поле. Если невозможно, то возвращается старая
- * фигура. Итоговая фигура помещается на поле по тем же координатам.
+ * Повернутая фигура по очереди проверяется со смещениями из таблицы kicks_*,
+ * берется первое подходящее положение. Проверки идут по битовым маскам:
+ * строка поля переводится в маску при первом обращении к ней, после чего
+ * проверка строки фигуры - одна операция AND.
  * @param game_info Информация о состоянии игры. Изменяется field.
  * @param fsm_addinfo Доп. инфо FSM (текущая фигура). Изменяются данные о
- * фигуре.
+ * фигуре и ее координаты.
+ * @param rotation 1 - по часовой стрелке, -1 - против.
  */
-void rotatePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+void rotatePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo,
+                 int rotation) {
   removePieceFromField(game_info, fsm_addinfo);
-  int tmp_rot_id = fsm_addinfo->piece_rot_id;
-  fsm_addinfo->piece_rot_id = (fsm_addinfo->piece_rot_id + 1) % 4;
-  getPiece(fsm_addinfo->piece, fsm_addinfo->piece_id,
-           fsm_addinfo->piece_rot_id);
-  if (checkPlacePiece(game_info, fsm_addinfo)) {
-    fsm_addinfo->piece_rot_id = tmp_rot_id;
-    getPiece(fsm_addinfo->piece, fsm_addinfo->piece_id,
-             fsm_addinfo->piece_rot_id);
+  int from = fsm_addinfo->piece_rot_id;
+  int to = (from + 4 + rotation) % 4;
+  const signed char(*kicks)[2] = fsm_addinfo->piece_id == 1
+                                     ? kicks_i[from][rotation < 0]
+                                     : kicks_jlstz[from][rotation < 0];
+  unsigned int piece = piece_masks[fsm_addinfo->piece_id][to];
+  // Маски строк поля, начиная со строки top. built - уже посчитанные
+  int top = fsm_addinfo->row_pos - KICK_ROWS;
+  unsigned int window[PIECE_ROWS + 2 * KICK_ROWS];
+  unsigned int built = 0;
+  int kick = -1;
+  for (int k = 0; k < KICK_TESTS && kick < 0; k++) {
+    int shift = fsm_addinfo->col_pos + kicks[k][0] + KICK_MARGIN;
+    unsigned int hit = 0;
+    for (int i = 0; i < PIECE_ROWS; i++) {
+      unsigned int row = (piece >> (i * PIECE_COLUMNS)) & 0xF;
+      int w = KICK_ROWS + kicks[k][1] + i;
+      if (row) {
+        if (!(built & (1u << w))) {
+          window[w] = fieldRowMask(game_info, top + w);
+          built |= 1u << w;
+        }
+        hit |= (row << shift) & window[w];
+      }
+    }
+    if (!hit) kick = k;
+  }
+  if (kick >= 0) {
+    fsm_addinfo->piece_rot_id = to;
+    fsm_addinfo->col_pos += kicks[kick][0];
+    fsm_addinfo->row_pos += kicks[kick][1];
+    getPiece(fsm_addinfo->piece, fsm_addinfo->piece_id, to);
   }
   placePieceOnField(game_info, fsm_addinfo);
 }
@@ -296,7 +547,7 @@ tetris_state movePieceDown(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
  * @param row Проверяемая строка.
  * @return 1 - если строка заполнена (нет нолей), 0 - иначе.
  */
-int isRowFilled(const int *row) {
+int isRowFilled(const cell_t *row) {
   int res = 1;
   for (int i = 0; i < FIELD_COLUMNS && res; i++) {
     if (!row[i]) res = 0;
@@ -309,7 +560,7 @@ int isRowFilled(const int *row) {
  * @param field Массив поля, в котором происходит удаление строки.
  * @param row Номер удаляемой строки.
  */
-void shiftField(int **field, int row) {
+void shiftField(cell_t **field, int row) {
   for (int i = row; i > 0; i--) {
     for (int j = 0; j < FIELD_COLUMNS; j++) {
       field[i][j] = field[i - 1][j];
@@ -318,18 +569,69 @@ void shiftField(int **field, int row) {
   for (int j = 0; j < FIELD_COLUMNS; j++) field[0][j] = 0;
 }
 
+/**
+ * @brief Удаление заполненных строк среди строк [first, last).
+ * @param field Поле. Изменяется.
+ * @return Количество удаленных строк.
+ */
+int clearFilledRows(cell_t **field, int first, int last) {
+  int count = 0;
+  for (int i = first; i < last; i++) {
+    if (isRowFilled(field[i])) {
+      count++;
+      shiftField(field, i);
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Подъем поля на rows строк мусора снизу (режим versus).
+ *
+ * Строка мусора заполнена клетками GARBAGE_CELL, кроме одной дыры.
+ * @param field Поле без текущей фигуры. Изменяется.
+ * @param holes Столбцы дыр строк мусора, первая - нижняя строка.
+ * @param rows Количество строк мусора, не больше FIELD_ROWS.
+ * @return FAILURE_EXIT, если занятые клетки ушли за верх поля (проигрыш),
+ * иначе SUCCESSFUL_EXIT.
+ */
+int pushGarbage(cell_t **field, const unsigned char *holes, int rows) {
+  int res = SUCCESSFUL_EXIT;
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (field[i][j]) res = FAILURE_EXIT;
+  for (int i = 0; i < FIELD_ROWS - rows; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++) field[i][j] = field[i + rows][j];
+  for (int k = 0; k < rows; k++) {
+    cell_t *row = field[FIELD_ROWS - 1 - k];
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      row[j] = j == holes[k] ? 0 : GARBAGE_CELL;
+  }
+  return res;
+}
+
 /**
  * @brief Запись рекорда в файл.
  *
- * В случае, если установлен новый рекорд, он записывается в файл.
- * Информация о предыдущем рекорде уничтожается.
+ * В случае, если установлен новый (ненулевой) рекорд, он записывается в
+ * файл.
+ * Информация о предыдущем рекорде уничтожается. Если файл не открывается
+ * (нет прав на запись и т.п.), рекорд не сохраняется.
  * @param game_info Информация о состоянии игры. Не изменяется.
  */
 void saveHighScore(GameInfo_t *game_info) {
-  if (game_info->score >= game_info->high_score) {
+  if (game_info->score > 0 && game_info->score >= game_info->high_score) {
     FILE *file = fopen("highscore.txt", "w");
-    fprintf(file, "%d", game_info->high_score);
-    fclose(file);
+    if (file != NULL) {
+      fprintf(file, "%d", game_info->high_score);
+      fclose(file);
+      // Предзагруженное значение заменяется новым рекордом
+      int cached = atomic_load(&high_score_cached);
+      while (cached >= 0 && cached < game_info->high_score &&
+             !atomic_compare_exchange_weak(&high_score_cached, &cached,
+                                           game_info->high_score)) {
+      }
+    }
   }
 }
 
@@ -338,7 +640,7 @@ void saveHighScore(GameInfo_t *game_info) {
  * @return Значение рекорда из файла. Если файл не найден или пустой
  * (некорректный), то возвращается 0.
  */
-int getHighScore() {
+static int readHighScore() {
   int high_score = 0;
   int tmp;
   FILE *file = fopen("highscore.txt", "r");
@@ -349,4 +651,57 @@ int getHighScore() {
     fclose(file);
   }
   return high_score;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Поток предзагрузки: ключи Зобриста и рекорд из файла.
+ */
+static void *highScoreLoad(void *arg) {
+  (void)arg;
+  zobristInit();
+  high_score_loaded = readHighScore();
+  return NULL;
+}
+
+/**
+ * @brief Запуск чтения рекорда (и заполнения ключей Зобриста) в отдельном
+ * потоке, чтобы файловый ввод-вывод шел параллельно с инициализацией
+ * интерфейса. Результат забирает следующий вызов getHighScore() и
+ * сохраняет для последующих. Если поток не создается, рекорд будет
+ * прочитан синхронно.
+ */
+void highScorePrefetch() {
+  pthread_mutex_lock(&high_score_mutex);
+  if (!high_score_pending) {
+    high_score_pending =
+        pthread_create(&high_score_thread, NULL, highScoreLoad, NULL) == 0;
+    if (high_score_pending) atomic_store(&high_score_cached, -1);
+  }
+  pthread_mutex_unlock(&high_score_mutex);
+}
+
+/**
+ * @brief Текущий рекорд.
+ *
+ * После предзагрузки (highScorePrefetch) первый вызов дожидается ее, а
+ * прочитанное значение (с учетом новых рекордов saveHighScore) возвращается
+ * всеми следующими вызовами без блокировки и чтения файла. Без
+ * предзагрузки файл читается при каждом вызове, вне блокировки.
+ * @return Значение рекорда из файла. Если файл не найден или пустой
+ * (некорректный), то возвращается 0.
+ */
+int getHighScore() {
+  int high_score = atomic_load(&high_score_cached);
+  if (high_score < 0) {
+    pthread_mutex_lock(&high_score_mutex);
+    if (high_score_pending) {
+      pthread_join(high_score_thread, NULL);
+      high_score_pending = false;
+      atomic_store(&high_score_cached, high_score_loaded);
+    }
+    high_score = atomic_load(&high_score_cached);
+    pthread_mutex_unlock(&high_score_mutex);
+    if (high_score < 0) high_score = readHighScore();
+  }
+  return high_score;
+}
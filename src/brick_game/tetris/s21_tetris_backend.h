@@ -1,15 +1,30 @@
 #ifndef TETRIS_BACK_H
 #define TETRIS_BACK_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "../../gui/cli/s21_define.h"
+#include "s21_tetris_metrics.h"
+
+// Количество проверок смещения (wall kicks) при вращении фигуры
+#define KICK_TESTS 5
+// Максимальное смещение фигуры по вертикали при вращении
+#define KICK_ROWS 2
+// Сдвиг столбцов поля в битовой маске строки (место под клетки за стенами)
+#define KICK_MARGIN 8
+// Значение клетки строки мусора (режим versus), цвет - пара 5
+#define GARBAGE_CELL 5
+// Длина очереди известных фигур (следующая и дальше) - максимум показа
+#define PREVIEW_MAX 6
+// Стартовая позиция новой фигуры
+#define SPAWN_COL 3
 
 /// @brief Доп.информация FSM, которая сохраняется на протяжении игры
 typedef struct {
   /// Текущая фигура
-  int **piece;
+  cell_t **piece;
   /// Позиция текущей фигуры - строка
   int row_pos;
   /// Позиция текущей фигуры - столбец
@@ -22,6 +37,20 @@ typedef struct {
   int next_id;
   /// id вращения следующей фигуры
   int next_rot_id;
+  /// Состояние генератора случайных чисел (свой для каждой игры)
+  unsigned int seed;
+  /// Фигуры после следующей - кольцевой буфер: id * 4 + id вращения
+  unsigned char queue[PREVIEW_MAX - 1];
+  /// Начало очереди в queue
+  int queue_head;
+  /// Отложенная фигура (hold): есть ли, id и id вращения
+  bool has_hold;
+  int hold_id;
+  int hold_rot_id;
+  /// Отложение уже использовано для текущей фигуры
+  bool hold_used;
+  /// Веса выбора фигур по id (адаптивная сложность), все 0 - равновероятно
+  unsigned char piece_weights[7];
 } addinfo_t;
 
 // Типы сигналов в FSM, дополнительно к Action_t
@@ -35,9 +64,74 @@ typedef enum {
   // Для удаления массивов в конце работы программы
   DESTR_SIG,
   // Выполнение действия падения фигуры
-  DROP_SIG
+  DROP_SIG,
+  // Один шаг времени игры (автоповтор, падение, задержка фиксации)
+  TICK_SIG,
+  // Нажатие и отпускание клавиши с автоповтором (Left, Right, Down)
+  PRESS_SIG,
+  RELEASE_SIG
 } sig;
 
+/// @brief Настройки управления по времени, в шагах времени (TIMING_TICK_NS)
+typedef struct {
+  /// Задержка автоповтора сдвига (DAS)
+  int das;
+  /// Период автоповтора сдвига (ARR), 0 - сразу до препятствия
+  int arr;
+  /// Период мягкого падения на строку при удержании Down
+  int soft_drop;
+  /// Задержка фиксации фигуры на опоре
+  int lock_delay;
+  /// Максимум сбросов задержки фиксации движением фигуры на опоре
+  int lock_resets;
+} timing_config_t;
+
+/// @brief Состояние управления по времени
+typedef struct {
+  /// Настройки
+  timing_config_t config;
+  /// Нажатые клавиши сдвига: бит 1 << Left, 1 << Right
+  unsigned int held;
+  /// Направление автоповтора сдвига (Left, Right или Up - нет)
+  UserAction_t shift;
+  /// Шагов до следующего сдвига автоповтора
+  int shift_timer;
+  /// Удерживается Down (мягкое падение) и шагов до следующей строки
+  bool soft_drop;
+  int soft_timer;
+  /// Накопленное время гравитации, нс
+  long long gravity_ns;
+  /// Шагов фигуры на опоре и использовано сбросов задержки фиксации
+  int lock_timer;
+  int lock_resets;
+  /// Самая нижняя строка фигуры (спуск ниже возвращает сбросы)
+  int lock_row;
+  /// Номер фигуры, к которой относится состояние фиксации
+  unsigned int piece;
+  /// Выполнено шагов времени
+  unsigned long long ticks;
+} timing_t;
+
+/// @brief Адаптивная сложность: оценка навыка игрока по ходу игры.
+/// Средние - экспоненциальные скользящие, в долях ADAPTIVE_ONE.
+typedef struct {
+  /// Включена (настройка, сохраняется между играми)
+  bool enabled;
+  /// Включена в текущей игре: копия enabled при старте игры, поэтому
+  /// изменение настройки во время игры действует со следующей игры
+  bool active;
+  /// Время на фигуру от появления до закрепления, шагов времени
+  int placement;
+  /// Высота стакана после закрепления, строк
+  int height;
+  /// Закрытые пустые клетки под стаканом
+  int holes;
+  /// Оценка навыка: 0 - новичок, ADAPTIVE_ONE - опытный игрок
+  int skill;
+  /// Шаг времени (timing.ticks) появления текущей фигуры
+  unsigned long long spawn_tick;
+} adaptive_t;
+
 /// @brief Полная информация по действию для FSM
 typedef struct {
   /// Информация по действиям пользователя
@@ -46,23 +140,90 @@ typedef struct {
   sig signal;
 } signal_t;
 
+/// @brief Операции с полем и текущей фигурой (горячий цикл игры).
+/// Реализации: общая (s21_tetris_backend.c) и специализированная для поля
+/// 10x20 (s21_tetris_board.c), выбор - при создании игры (boardSelect).
+typedef struct {
+  /// Название реализации
+  const char *name;
+  int (*check)(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+  void (*place)(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+  void (*remove)(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+  void (*shift)(GameInfo_t *game_info, addinfo_t *fsm_addinfo, int shift);
+  void (*drop)(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+  tetris_state (*move_down)(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+  int (*clear_rows)(cell_t **field, int first, int last);
+} board_ops_t;
+
+/// @brief Полное состояние одного экземпляра игры (движка)
+typedef struct {
+  /// Текущее состояние FSM
+  tetris_state state;
+  /// Информация о состоянии игры для GUI
+  GameInfo_t game_info;
+  /// Доп.информация FSM
+  addinfo_t addinfo;
+  /// Метрики игры
+  metrics_t metrics;
+  /// Счетчик шагов для выборки замеров задержки
+  unsigned int step_count;
+  /// Количество появившихся фигур (номер текущей фигуры)
+  unsigned int piece_count;
+  /// Строк удалено последней закрепленной фигурой
+  int last_clear;
+  /// Начальное состояние генератора фигур текущей игры
+  unsigned int game_seed;
+  /// Строк удалено в текущей игре
+  int lines;
+  /// Входящий мусор (режим versus): столбцы дыр строк, которые поднимутся
+  /// снизу после закрепления фигуры без удаления строк
+  unsigned char garbage[FIELD_ROWS];
+  int garbage_count;
+  /// Управление по времени: автоповтор, мягкое падение, задержка фиксации
+  timing_t timing;
+  /// Адаптивная сложность (по умолчанию выключена)
+  adaptive_t adaptive;
+  /// Операции с полем (NULL - общая реализация board_generic)
+  const board_ops_t *board;
+  /// Рекорд читается из файла и сохраняется в него (только игры GUI,
+  /// см. fsm), остальные игры файл не трогают
+  bool high_score_file;
+} engine_t;
+
+/// Ключи Зобриста для клеток поля (заполняются zobristInit)
+extern unsigned long long zobrist_keys[FIELD_ROWS][FIELD_COLUMNS];
+/// Битовые маски шаблонов фигур [id][id вращения]
+extern const unsigned short piece_masks[7][4];
+
+void zobristInit();
+unsigned long long fieldHash(cell_t **field);
+void tetrisAllocate(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void tetrisCreate(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void tetrisInit(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void tetrisDestroy(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
-int **createMatrix(int rows, int cols);
+cell_t **createMatrix(int rows, int cols);
+void freeMatrix(cell_t **matrix);
+size_t engineMemory();
+int nextRandom(addinfo_t *fsm_addinfo);
 void genNextPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
-void getPiece(int **dst, int id, int rot_id);
+int previewPiece(const addinfo_t *fsm_addinfo, int k, int *rot_id);
+void getPiece(cell_t **dst, int id, int rot_id);
+int pieceMask(int id, int rot_id);
 void fromNextIntoCurrent(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 int checkPlacePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void placePieceOnField(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void removePieceFromField(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 void shiftPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo, int shift);
-void rotatePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
+void rotatePiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo,
+                 int rotation);
 void dropPiece(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
 tetris_state movePieceDown(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
-int isRowFilled(const int *row);
-void shiftField(int **field, int row);
+int isRowFilled(const cell_t *row);
+void shiftField(cell_t **field, int row);
+int clearFilledRows(cell_t **field, int first, int last);
+int pushGarbage(cell_t **field, const unsigned char *holes, int rows);
 void saveHighScore(GameInfo_t *game_info);
 int getHighScore();
+void highScorePrefetch();
 
 #endif  // TETRIS_BACK_H
\ No newline at end of file
@@ -0,0 +1,233 @@
+/**
+ * @file s21_tetris_board.c
+ * @brief Реализации операций с полем (board_ops_t) и их выбор.
+ *
+ * Общая реализация - функции s21_tetris_backend.c: клетки шаблона фигуры
+ * и поля проверяются по одной. Специализированная собирается для
+ * стандартного поля 10x20 и 7 фигур: размеры и маски фигур (piece_masks) -
+ * константы, циклы по строкам фигуры и клеткам строки разворачиваются,
+ * строка поля и строка фигуры сравниваются одной операцией AND. Падение
+ * считается по нижним клеткам столбцов фигуры без снятия ее с поля,
+ * заполненные строки удаляются одним проходом. Вращение (rotatePiece) уже
+ * работает с масками и общее для обеих реализаций.
+ *
+ * Обе реализации работают с одним и тем же полем и дают одинаковые
+ * результаты, поэтому реализацию можно сменить и посреди игры.
+ */
+#include "s21_tetris_board.h"
+
+#include <string.h>
+
+/// Общая реализация (для любых размеров поля)
+const board_ops_t board_generic = {.name = "generic",
+                                   .check = checkPlacePiece,
+                                   .place = placePieceOnField,
+                                   .remove = removePieceFromField,
+                                   .shift = shiftPiece,
+                                   .drop = dropPiece,
+                                   .move_down = movePieceDown,
+                                   .clear_rows = clearFilledRows};
+
+#if BOARD_STANDARD_ENABLED
+
+// Маска заполненной строки поля
+#define BOARD_FULL_ROW 0x3FFu
+// Клетки за стенами в маске строки со сдвигом KICK_MARGIN
+#define BOARD_WALLS (~(BOARD_FULL_ROW << KICK_MARGIN))
+
+/**
+ * @brief Маска занятых клеток строки поля: столбец j - бит j.
+ */
+static inline unsigned int boardRowBits(const cell_t *row) {
+  unsigned int bits = 0;
+#pragma GCC unroll 10
+  for (int j = 0; j < 10; j++) bits |= (unsigned int)(row[j] != 0) << j;
+  return bits;
+}
+
+/**
+ * @brief Маска текущей фигуры (по id и id вращения).
+ */
+static inline unsigned int boardPiece(const addinfo_t *fsm_addinfo) {
+  return piece_masks[fsm_addinfo->piece_id][fsm_addinfo->piece_rot_id];
+}
+
+/**
+ * @brief checkPlacePiece для поля 10x20: строки вне поля и клетки за
+ * стенами заняты.
+ * @return 0 - если фигуру можно разместить, 1 - если нельзя.
+ */
+static int boardCheck(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+  unsigned int piece = boardPiece(fsm_addinfo);
+  int shift = fsm_addinfo->col_pos + KICK_MARGIN;
+  unsigned int hit = shift < 0;
+#pragma GCC unroll 4
+  for (int i = 0; i < 4; i++) {
+    unsigned int bits = (piece >> (i * 4)) & 0xFu;
+    int row = fsm_addinfo->row_pos + i;
+    if (bits && !hit) {
+      unsigned int mask = ~0u;
+      if (row >= 0 && row < 20)
+        mask = BOARD_WALLS | boardRowBits(game_info->field[row]) << KICK_MARGIN;
+      hit |= (bits << shift) & mask;
+    }
+  }
+  return hit ? FAILURE_EXIT : SUCCESSFUL_EXIT;
+}
+
+/**
+ * @brief Запись на поле клеток текущей фигуры значением value (0 - снятие
+ * фигуры) с обновлением хеша. Перебираются только 4 занятых бита маски.
+ */
+static inline void boardPaint(GameInfo_t *game_info,
+                              const addinfo_t *fsm_addinfo, int value) {
+  unsigned int piece = boardPiece(fsm_addinfo);
+  while (piece) {
+    int k = __builtin_ctz(piece);
+    piece &= piece - 1;
+    int row = fsm_addinfo->row_pos + k / 4, col = fsm_addinfo->col_pos + k % 4;
+    if ((unsigned int)row < 20u && (unsigned int)col < 10u) {
+      cell_t *cell = &game_info->field[row][col];
+      if (!*cell != !value) game_info->hash ^= zobrist_keys[row][col];
+      *cell = value;
+    }
+  }
+}
+
+/**
+ * @brief placePieceOnField для поля 10x20 (цвет клетки - id фигуры + 1, как
+ * в шаблонах getPiece).
+ */
+static void boardPlace(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+  boardPaint(game_info, fsm_addinfo, fsm_addinfo->piece_id + 1);
+}
+
+/**
+ * @brief removePieceFromField для поля 10x20.
+ */
+static void boardRemove(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+  boardPaint(game_info, fsm_addinfo, 0);
+}
+
+/**
+ * @brief shiftPiece для поля 10x20.
+ */
+static void boardShift(GameInfo_t *game_info, addinfo_t *fsm_addinfo,
+                       int shift) {
+  boardRemove(game_info, fsm_addinfo);
+  fsm_addinfo->col_pos += shift;
+  if (boardCheck(game_info, fsm_addinfo)) fsm_addinfo->col_pos -= shift;
+  boardPlace(game_info, fsm_addinfo);
+}
+
+/**
+ * @brief На сколько строк (не больше limit) фигура может опуститься.
+ *
+ * Для каждого столбца фигуры считаются свободные клетки под ее нижней
+ * клеткой в этом столбце. Клетки самой фигуры под нижней не лежат, поэтому
+ * фигура остается на поле.
+ */
+static int boardFall(GameInfo_t *game_info, addinfo_t *fsm_addinfo,
+                     int limit) {
+  unsigned int piece = boardPiece(fsm_addinfo);
+  int fall = limit;
+#pragma GCC unroll 4
+  for (int j = 0; j < 4; j++) {
+    unsigned int column = piece & (0x1111u << j);
+    if (column) {
+      int col = fsm_addinfo->col_pos + j;
+      int row = fsm_addinfo->row_pos + (31 - __builtin_clz(column)) / 4 + 1;
+      int free = 0;
+      if (col >= 0 && col < 10 && row >= 0)
+        while (free < fall && row + free < 20 &&
+               !game_info->field[row + free][col])
+          free++;
+      fall = free;
+    }
+  }
+  return fall;
+}
+
+/**
+ * @brief dropPiece для поля 10x20: фигура переносится сразу на место.
+ */
+static void boardDrop(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
+  int fall = boardFall(game_info, fsm_addinfo, 20);
+  if (fall > 0) {
+    boardRemove(game_info, fsm_addinfo);
+    fsm_addinfo->row_pos += fall;
+    boardPlace(game_info, fsm_addinfo);
+  }
+}
+
+/**
+ * @brief movePieceDown для поля 10x20.
+ * @return MOVING или ATTACHING, если фигура дошла до препятствия.
+ */
+static tetris_state boardMoveDown(GameInfo_t *game_info,
+                                  addinfo_t *fsm_addinfo) {
+  tetris_state state = ATTACHING;
+  if (boardFall(game_info, fsm_addinfo, 1)) {
+    boardRemove(game_info, fsm_addinfo);
+    fsm_addinfo->row_pos++;
+    boardPlace(game_info, fsm_addinfo);
+    state = MOVING;
+  }
+  return state;
+}
+
+/**
+ * @brief clearFilledRows для поля 10x20: оставшиеся строки сдвигаются вниз
+ * за один проход (каждая строка копируется не больше одного раза).
+ */
+static int boardClearRows(cell_t **field, int first, int last) {
+  unsigned int full = 0;
+  for (int i = first; i < last; i++)
+    if (boardRowBits(field[i]) == BOARD_FULL_ROW) full |= 1u << i;
+  int count = 0;
+  if (full) {
+    int dst = last - 1;
+    for (int src = last - 1; src >= 0; src--) {
+      if ((full >> src) & 1) {
+        count++;
+      } else {
+        if (dst != src) memcpy(field[dst], field[src], 10 * sizeof(cell_t));
+        dst--;
+      }
+    }
+    for (; dst >= 0; dst--) memset(field[dst], 0, 10 * sizeof(cell_t));
+  }
+  return count;
+}
+
+/// Специализированная реализация для поля 10x20
+const board_ops_t board_standard = {.name = "standard",
+                                    .check = boardCheck,
+                                    .place = boardPlace,
+                                    .remove = boardRemove,
+                                    .shift = boardShift,
+                                    .drop = boardDrop,
+                                    .move_down = boardMoveDown,
+                                    .clear_rows = boardClearRows};
+
+#endif  // BOARD_STANDARD_ENABLED
+
+/**
+ * @brief Выбор реализации операций с полем при создании игры.
+ *
+ * BOARD_AUTO - специализированная реализация, если она собрана, кроме
+ * случая TETRIS_BOARD=generic в окружении. Если специализированная не
+ * собрана (поле другого размера), всегда возвращается общая.
+ */
+const board_ops_t *boardSelect(board_kind kind) {
+  if (kind == BOARD_AUTO) {
+    const char *env = getenv(BOARD_ENV);
+    kind = env != NULL && strcmp(env, "generic") == 0 ? BOARD_GENERIC
+                                                      : BOARD_STANDARD;
+  }
+  const board_ops_t *res = &board_generic;
+#if BOARD_STANDARD_ENABLED
+  if (kind == BOARD_STANDARD) res = &board_standard;
+#endif
+  return res;
+}
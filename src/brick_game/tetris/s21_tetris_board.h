@@ -0,0 +1,40 @@
+#ifndef TETRIS_BOARD_H
+#define TETRIS_BOARD_H
+
+#include "s21_tetris_backend.h"
+
+// Специализированная реализация собирается только для стандартного поля
+#if FIELD_ROWS == 20 && FIELD_COLUMNS == 10
+#define BOARD_STANDARD_ENABLED 1
+#else
+#define BOARD_STANDARD_ENABLED 0
+#endif
+
+// Переменная окружения для выбора реализации: generic или standard
+#define BOARD_ENV "TETRIS_BOARD"
+
+/// @brief Выбор реализации операций с полем
+typedef enum {
+  /// Специализированная, если собрана и не выбрана общая через BOARD_ENV
+  BOARD_AUTO = 0,
+  /// Общая: клетки шаблона фигуры и поля по одной
+  BOARD_GENERIC,
+  /// Поле 10x20 и 7 фигур - константы времени компиляции, битовые маски
+  BOARD_STANDARD
+} board_kind;
+
+extern const board_ops_t board_generic;
+#if BOARD_STANDARD_ENABLED
+extern const board_ops_t board_standard;
+#endif
+
+const board_ops_t *boardSelect(board_kind kind);
+
+/**
+ * @brief Операции с полем игры (общие, если игра создана без выбора).
+ */
+static inline const board_ops_t *engineBoard(const engine_t *engine) {
+  return engine->board != NULL ? engine->board : &board_generic;
+}
+
+#endif  // TETRIS_BOARD_H
@@ -0,0 +1,382 @@
+/**
+ * @file s21_tetris_bot.c
+ * @brief Бот: автоматическая игра для нагрузочных тестов и демонстрации.
+ *
+ * Для каждой новой фигуры строится план - положение (поворот и столбец), в
+ * которое фигура бросается. Перебираются размещения текущей и следующей
+ * фигур, дальше - ожидание (expectimax) по всем 7 возможным фигурам. На
+ * каждом уровне раскрываются только BOT_BEAM лучших по оценке размещений
+ * (beam search). Глубина наращивается итеративно, пока хватает времени,
+ * используется результат последней полностью пройденной глубины.
+ *
+ * Оценки полей на уровнях с неизвестными фигурами сохраняются в таблице
+ * транспозиций по хешу Зобриста, поэтому поле, полученное разными
+ * последовательностями размещений, оценивается один раз.
+ */
+#include "s21_tetris_bot.h"
+
+/// Веса оценки поля: высоты столбцов, удаленные строки, дыры, неровность
+static const double w_height = -0.510066;
+static const double w_lines = 0.760666;
+static const double w_holes = -0.35663;
+static const double w_bumpiness = -0.184483;
+/// Оценка проигрыша (фигуру некуда поместить)
+static const double lost_value = -1e9;
+
+/// Клетки поля в маске строки
+#define BOT_FIELD_BITS (((1u << FIELD_COLUMNS) - 1) << KICK_MARGIN)
+/// Пустая строка: заняты только клетки за стенами
+#define BOT_EMPTY_ROW (~BOT_FIELD_BITS)
+
+/// @brief Размещение фигуры на поле
+typedef struct {
+  /// Поле после размещения и удаления строк
+  bot_board_t board;
+  /// Маска шаблона фигуры, строка и столбец
+  int mask;
+  int row;
+  int col;
+  /// Удаленные строки
+  int lines;
+  /// Оценка без учета следующих фигур
+  double score;
+} bot_move_t;
+
+/**
+ * @brief Количество единичных битов (без обращения к библиотеке, т.к.
+ * инструкция popcnt может быть недоступна).
+ */
+static inline int botPopcount(unsigned int x) {
+  x = x - ((x >> 1) & 0x55555555u);
+  x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+  return (int)((((x + (x >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+/**
+ * @brief Хеш поля, посчитанный заново по всем клеткам.
+ */
+static unsigned long long botHash(const bot_board_t *board) {
+  unsigned long long hash = 0;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    unsigned int cells = (board->rows[i] & BOT_FIELD_BITS) >> KICK_MARGIN;
+    while (cells) {
+      hash ^= zobrist_keys[i][__builtin_ctz(cells)];
+      cells &= cells - 1;
+    }
+  }
+  return hash;
+}
+
+/**
+ * @brief Поле игры без текущей фигуры.
+ *
+ * Хеш берется из хеша поля, который ведет игра, без клеток текущей фигуры.
+ */
+static void botBoard(const engine_t *engine, bot_board_t *board) {
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  board->hash = engine->game_info.hash;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    board->rows[i] = BOT_EMPTY_ROW;
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (fieldCell(&engine->game_info, i, j))
+        board->rows[i] |= 1u << (j + KICK_MARGIN);
+  }
+  int mask = pieceMask(fsm_addinfo->piece_id, fsm_addinfo->piece_rot_id);
+  for (int i = 0; i < PIECE_ROWS; i++) {
+    unsigned int cells = (mask >> (i * PIECE_COLUMNS)) & 0xF;
+    if (cells)
+      board->rows[fsm_addinfo->row_pos + i] &=
+          ~(cells << (fsm_addinfo->col_pos + KICK_MARGIN));
+    while (cells) {
+      board->hash ^= zobrist_keys[fsm_addinfo->row_pos + i]
+                                 [fsm_addinfo->col_pos + __builtin_ctz(cells)];
+      cells &= cells - 1;
+    }
+  }
+}
+
+/**
+ * @brief Проверка, помещается ли фигура (маска шаблона) в позицию.
+ */
+static bool botFits(const bot_board_t *board, int mask, int row, int col) {
+  bool fits = true;
+  for (int i = 0; i < PIECE_ROWS && fits; i++) {
+    unsigned int cells = (mask >> (i * PIECE_COLUMNS)) & 0xF;
+    if (cells)
+      fits = row + i < FIELD_ROWS &&
+             !(board->rows[row + i] & (cells << (col + KICK_MARGIN)));
+  }
+  return fits;
+}
+
+/**
+ * @brief Размещение фигуры и удаление заполненных строк.
+ *
+ * Хеш обновляется по размещенным клеткам, после удаления строк
+ * пересчитывается заново.
+ * @return Количество удаленных строк.
+ */
+static int botPlace(const bot_board_t *src, bot_board_t *dst, int mask,
+                    int row, int col) {
+  *dst = *src;
+  for (int i = 0; i < PIECE_ROWS; i++) {
+    unsigned int cells = (mask >> (i * PIECE_COLUMNS)) & 0xF;
+    if (cells) dst->rows[row + i] |= cells << (col + KICK_MARGIN);
+    while (cells) {
+      dst->hash ^= zobrist_keys[row + i][col + __builtin_ctz(cells)];
+      cells &= cells - 1;
+    }
+  }
+  int lines = 0;
+  for (int i = FIELD_ROWS - 1; i >= 0; i--) {
+    if (dst->rows[i] == ~0u) {
+      lines++;
+    } else if (lines) {
+      dst->rows[i + lines] = dst->rows[i];
+    }
+  }
+  if (lines) {
+    for (int i = 0; i < lines; i++) dst->rows[i] = BOT_EMPTY_ROW;
+    dst->hash = botHash(dst);
+  }
+  return lines;
+}
+
+/**
+ * @brief Оценка поля: суммарная высота столбцов, дыры (пустые клетки под
+ * заполненными) и неровность (разница высот соседних столбцов).
+ */
+static double botEvaluate(const bot_board_t *board) {
+  int heights[FIELD_COLUMNS] = {0};
+  unsigned int covered = 0;
+  int holes = 0;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    unsigned int cells = (board->rows[i] & BOT_FIELD_BITS) >> KICK_MARGIN;
+    unsigned int fresh = cells & ~covered;
+    while (fresh) {
+      heights[__builtin_ctz(fresh)] = FIELD_ROWS - i;
+      fresh &= fresh - 1;
+    }
+    holes += botPopcount(covered & ~cells);
+    covered |= cells;
+  }
+  int height = heights[0], bumpiness = 0;
+  for (int j = 1; j < FIELD_COLUMNS; j++) {
+    height += heights[j];
+    bumpiness += abs(heights[j] - heights[j - 1]);
+  }
+  return w_height * height + w_holes * holes + w_bumpiness * bumpiness;
+}
+
+/**
+ * @brief Все размещения фигуры: для каждого различного поворота и столбца
+ * фигура падает вертикально из строки start_row.
+ * @return Количество размещений.
+ */
+static int botMoves(const bot_board_t *board, int id, int start_row,
+                    bot_move_t *moves) {
+  int count = 0;
+  // Над верхней заполненной строкой фигура падает без проверок
+  int top = 0;
+  while (top < FIELD_ROWS && board->rows[top] == BOT_EMPTY_ROW) top++;
+  int free_row = top - PIECE_ROWS > start_row ? top - PIECE_ROWS : start_row;
+  for (int rot = 0; rot < 4; rot++) {
+    int mask = pieceMask(id, rot);
+    bool repeat = false;
+    for (int r = 0; r < rot; r++) repeat = repeat || pieceMask(id, r) == mask;
+    for (int col = 1 - PIECE_COLUMNS; col < FIELD_COLUMNS && !repeat; col++) {
+      if (botFits(board, mask, start_row, col)) {
+        int row = free_row;
+        while (botFits(board, mask, row + 1, col)) row++;
+        bot_move_t *move = &moves[count++];
+        move->mask = mask;
+        move->row = row;
+        move->col = col;
+        move->lines = botPlace(board, &move->board, mask, row, col);
+        move->score = w_lines * move->lines + botEvaluate(&move->board);
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Сортировка размещений по убыванию оценки (вставками, размещений
+ * немного).
+ */
+static void botSortMoves(bot_move_t *moves, int count) {
+  for (int i = 1; i < count; i++) {
+    bot_move_t tmp = moves[i];
+    int j = i;
+    for (; j > 0 && moves[j - 1].score < tmp.score; j--)
+      moves[j] = moves[j - 1];
+    moves[j] = tmp;
+  }
+}
+
+static double botValue(bot_t *bot, const bot_board_t *board, int level,
+                       int depth);
+
+/**
+ * @brief Лучшее размещение фигуры с учетом следующих уровней поиска.
+ * @param level Уровень фигуры (0 - текущая).
+ * @param depth Глубина поиска.
+ * @param best Лучшее размещение (маска, строка и столбец) или NULL.
+ * @return Оценка лучшего размещения или lost_value, если размещений нет.
+ */
+static double botMax(bot_t *bot, const bot_board_t *board, int id,
+                     int start_row, int level, int depth, bot_move_t *best) {
+  bot_move_t moves[(PIECE_COLUMNS + FIELD_COLUMNS) * 4];
+  int count = botMoves(board, id, start_row, moves);
+  bot->nodes++;
+  if (level + 1 < depth) {
+    botSortMoves(moves, count);
+    if (count > BOT_BEAM) count = BOT_BEAM;
+  }
+  double res = lost_value;
+  for (int k = 0; k < count && !bot->aborted; k++) {
+    double value = moves[k].score;
+    if (level + 1 < depth)
+      value = w_lines * moves[k].lines +
+              botValue(bot, &moves[k].board, level + 1, depth);
+    if (value > res) {
+      res = value;
+      if (best != NULL) {
+        best->mask = moves[k].mask;
+        best->row = moves[k].row;
+        best->col = moves[k].col;
+      }
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Оценка поля перед размещением фигуры уровня level.
+ *
+ * Для известной фигуры - лучшее размещение, для неизвестной - среднее по
+ * всем 7 фигурам. Оценки для неизвестных фигур зависят только от поля и
+ * оставшейся глубины, поэтому берутся из таблицы транспозиций. Время
+ * поиска проверяется перед каждой оценкой, в том числе для известных фигур:
+ * подсказка хода ищет только на них и должна уложиться в кадр.
+ */
+static double botValue(bot_t *bot, const bot_board_t *board, int level,
+                       int depth) {
+  double res = 0;
+  if (metricsNow() > bot->deadline) bot->aborted = true;
+  if (level < BOT_KNOWN) {
+    if (!bot->aborted)
+      res = botMax(bot, board, bot->pieces[level], 0, level, depth, NULL);
+  } else {
+    bot_tt_entry_t *entry = &bot->tt[board->hash & (BOT_TT_SIZE - 1)];
+    if (entry->key == board->hash && entry->depth == depth - level + 1) {
+      res = entry->value;
+      bot->tt_hits++;
+    } else {
+      for (int id = 0; id < PIECE_TYPES && !bot->aborted; id++)
+        res += botMax(bot, board, id, 0, level, depth, NULL) / PIECE_TYPES;
+      if (!bot->aborted) {
+        entry->key = board->hash;
+        entry->depth = depth - level + 1;
+        entry->value = res;
+      }
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Создание бота.
+ * @param budget_ns Время на планирование одной фигуры, нс.
+ * @return Указатель на бота или NULL при ошибке выделения памяти.
+ */
+bot_t *botCreate(long long budget_ns) {
+  zobristInit();
+  bot_t *bot = (bot_t *)calloc(1, sizeof(bot_t));
+  if (bot != NULL) {
+    bot->budget_ns = budget_ns;
+    bot->max_depth = BOT_MAX_DEPTH;
+  }
+  return bot;
+}
+
+/**
+ * @brief Удаление бота.
+ */
+void botDestroy(bot_t *bot) { free(bot); }
+
+/**
+ * @brief Построение плана для текущей фигуры игры.
+ *
+ * Глубина поиска наращивается от 1 до max_depth. Если время budget_ns
+ * закончилось, используется план последней полностью пройденной глубины
+ * (глубина 1 проходится всегда).
+ * @param bot Бот. Заполняются цель плана и статистика.
+ * @param engine Игра в состоянии MOVING. Не изменяется.
+ */
+void botPlan(bot_t *bot, const engine_t *engine) {
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  bot_board_t board;
+  botBoard(engine, &board);
+  bot->pieces[0] = fsm_addinfo->piece_id;
+  bot->pieces[1] = fsm_addinfo->next_id;
+  bot->target_mask =
+      pieceMask(fsm_addinfo->piece_id, fsm_addinfo->piece_rot_id);
+  bot->target_row = fsm_addinfo->row_pos;
+  bot->target_col = fsm_addinfo->col_pos;
+  bot->deadline = metricsNow() + bot->budget_ns;
+  bot->aborted = false;
+  bot->nodes = 0;
+  bot->tt_hits = 0;
+  bot->depth = 0;
+  for (int depth = 1; depth <= bot->max_depth && !bot->aborted; depth++) {
+    bot_move_t best = {.mask = -1};
+    botMax(bot, &board, bot->pieces[0], fsm_addinfo->row_pos, 0, depth,
+           &best);
+    if (!bot->aborted && best.mask >= 0) {
+      bot->target_mask = best.mask;
+      bot->target_row = best.row;
+      bot->target_col = best.col;
+      bot->depth = depth;
+    }
+  }
+}
+
+/**
+ * @brief Следующее действие бота - источник ввода вместо клавиатуры.
+ *
+ * Для новой фигуры строится план, затем фигура поворачивается и сдвигается
+ * к цели по одному действию за вызов и бросается.
+ * @param bot Бот.
+ * @param engine Игра. Не изменяется.
+ * @param hold Уточнение действия (true - падение фигуры).
+ * @return Действие для userInput / engineInput. Up - если игра не в
+ * состоянии MOVING (бот ничего не делает).
+ */
+UserAction_t botAction(bot_t *bot, const engine_t *engine, bool *hold) {
+  UserAction_t action = Up;
+  *hold = false;
+  if (engine->state == MOVING) {
+    const addinfo_t *fsm_addinfo = &engine->addinfo;
+    if (bot->piece != engine->piece_count) {
+      botPlan(bot, engine);
+      bot->piece = engine->piece_count;
+      bot->moves = 0;
+    }
+    int mask = pieceMask(fsm_addinfo->piece_id, fsm_addinfo->piece_rot_id);
+    // Если цель недостижима (препятствие), фигура бросается как есть
+    if (bot->moves++ >= BOT_MOVES_LIMIT) {
+      action = Down;
+    } else if (mask != bot->target_mask) {
+      action = Action;
+    } else if (fsm_addinfo->col_pos < bot->target_col) {
+      action = Right;
+    } else if (fsm_addinfo->col_pos > bot->target_col) {
+      action = Left;
+    } else {
+      action = Down;
+    }
+    *hold = action == Down;
+  }
+  return action;
+}
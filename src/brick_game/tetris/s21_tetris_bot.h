@@ -0,0 +1,74 @@
+#ifndef TETRIS_BOT_H
+#define TETRIS_BOT_H
+
+#include <stdbool.h>
+
+#include "../../gui/cli/s21_define.h"
+#include "s21_tetris_backend.h"
+
+// Время на планирование одной фигуры по умолчанию, нс
+#define BOT_BUDGET 1000000LL
+// Максимальная глубина поиска (количество фигур)
+#define BOT_MAX_DEPTH 4
+// Известные фигуры: текущая и следующая, дальше - ожидание по всем 7
+#define BOT_KNOWN 2
+// Ширина луча: сколько лучших размещений раскрывается на следующий уровень
+#define BOT_BEAM 6
+// Размер таблицы транспозиций (степень двойки)
+#define BOT_TT_SIZE (1 << 14)
+// Максимум действий на одну фигуру, после чего фигура бросается
+#define BOT_MOVES_LIMIT 32
+
+/// @brief Поле в виде битовых масок строк (как при проверке вращения:
+/// столбец j - бит j + KICK_MARGIN, клетки за стенами заняты)
+typedef struct {
+  /// Маски строк
+  unsigned int rows[FIELD_ROWS];
+  /// Хеш Зобриста заполненных клеток
+  unsigned long long hash;
+} bot_board_t;
+
+/// @brief Запись таблицы транспозиций
+typedef struct {
+  /// Хеш поля
+  unsigned long long key;
+  /// Оставшаяся глубина + 1 (0 - пустая запись)
+  int depth;
+  /// Оценка поля
+  double value;
+} bot_tt_entry_t;
+
+/// @brief Состояние бота
+typedef struct {
+  /// Время на планирование одной фигуры, нс
+  long long budget_ns;
+  /// Ограничение глубины поиска
+  int max_depth;
+  /// Номер фигуры (engine_t.piece_count), для которой построен план
+  unsigned int piece;
+  /// Цель плана: маска шаблона фигуры, строка, на которой фигура
+  /// остановится, и столбец
+  int target_mask;
+  int target_row;
+  int target_col;
+  /// Выполнено действий для текущей фигуры
+  int moves;
+  /// Статистика последнего плана: глубина, узлы, попадания в таблицу
+  int depth;
+  long long nodes;
+  long long tt_hits;
+  /// Известные фигуры для текущего поиска
+  int pieces[BOT_KNOWN];
+  /// Время окончания поиска и признак прерывания по времени
+  long long deadline;
+  bool aborted;
+  /// Таблица транспозиций: оценки полей по хешу (сохраняется между ходами)
+  bot_tt_entry_t tt[BOT_TT_SIZE];
+} bot_t;
+
+bot_t *botCreate(long long budget_ns);
+void botDestroy(bot_t *bot);
+void botPlan(bot_t *bot, const engine_t *engine);
+UserAction_t botAction(bot_t *bot, const engine_t *engine, bool *hold);
+
+#endif  // TETRIS_BOT_H
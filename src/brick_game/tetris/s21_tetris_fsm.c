@@ -1,47 +1,250 @@
 /**
  * @file s21_tetris_fsm.c
  * @brief Реализация автомата конечных состояний (FSM).
+ *
+ * Переходы описаны таблицей (состояние x событие) -> обработчик, которая
+ * собирается из спецификации s21_tetris_fsm.def. Схема FSM.pdf строится из
+ * той же спецификации (make fsm_diagram).
  */
 #include "s21_tetris_fsm.h"
 
+#include "s21_tetris_adaptive.h"
+#include "s21_tetris_board.h"
+#include "s21_tetris_timing.h"
+
+/// @brief Обработчик перехода FSM. Возвращает новое состояние.
+typedef tetris_state (*fsm_handler)(engine_t *engine);
+
+// id обработчиков (индексы в fsm_handlers)
+#define FSM_HANDLER(name, function) FSM_H_##name,
+#define FSM_TRANSITION(state, event, handler, next)
+typedef enum {
+#include "s21_tetris_fsm.def"
+  FSM_HANDLER_COUNT
+} fsm_handler_id;
+
+// Объявления обработчиков
+#define FSM_HANDLER(name, function) \
+  static tetris_state function(engine_t *engine);
+#define FSM_TRANSITION(state, event, handler, next)
+#include "s21_tetris_fsm.def"
+
+/// Обработчики по id
+static const fsm_handler fsm_handlers[FSM_HANDLER_COUNT] = {
+#define FSM_HANDLER(name, function) [FSM_H_##name] = function,
+#define FSM_TRANSITION(state, event, handler, next)
+#include "s21_tetris_fsm.def"
+};
+
+/// Таблица переходов. Не описанные пары - 0, т.е. FSM_H_IGNORE
+static const unsigned char fsm_table[EXIT_STATE + 1][FSM_EVENT_COUNT] = {
+#define FSM_HANDLER(name, function)
+#define FSM_TRANSITION(state, event, handler, next) \
+  [state][event] = FSM_H_##handler,
+#include "s21_tetris_fsm.def"
+};
+
+/// Состояния, которые обрабатываются без ожидания ввода
+static const unsigned char fsm_auto[EXIT_STATE + 1] = {
+#define FSM_HANDLER(name, function)
+#define FSM_TRANSITION(state, event, handler, next)
+#define FSM_AUTO(state) [state] = 1,
+#include "s21_tetris_fsm.def"
+};
+
+/// Игра GUI по умолчанию: режим FSM, информация для фронтенд, доп.инфо
+static engine_t gui_default = {.state = START};
+/// Текущая игра GUI (fsmGuiUse), к ней обращаются функции API
+static engine_t *gui_engine = &gui_default;
+
 /**
- * @brief Автомат конечных состояний (FSM).
+ * @brief Выполнение перехода по таблице для текущего состояния игры.
+ * @param engine Игра.
+ * @param event Событие FSM.
+ * @return Новое состояние FSM (engine->state не изменяется).
+ */
+static inline tetris_state fsmDispatch(engine_t *engine, fsm_event event) {
+  return fsm_handlers[fsm_table[engine->state][event]](engine);
+}
+
+/**
+ * @brief Событие FSM по сигналу: действие пользователя, а для падения фигуры
+ * (Down с DROP_SIG) - отдельное событие EV_DROP.
+ */
+static inline fsm_event fsmEvent(signal_t *signal) {
+  return signal->signal == DROP_SIG ? EV_DROP : (fsm_event)signal->action;
+}
+
+/**
+ * @brief Автомат конечных состояний (FSM) для игры, общей для GUI.
  *
- * В зависимости от текущего состояния и пришедшего сигнала выполняются
- * определенные действия и, если нужно, переход в другое состояние.
- * Схема работы FSM описана в файле FSM.pdf
+ * Передает сигнал в fsmStep для текущей игры интерфейса (fsmGuiUse).
  * @param signal Обрабатываемый сигнал.
  * @param state Состояние FSM после обработки сигнала.
  */
 GameInfo_t fsm(signal_t *signal, tetris_state *state) {
-  // Текущий режим FSM
-  static tetris_state fsm_state = START;
-  // Информация о состоянии игры для фронтенд (по ТЗ)
-  static GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  // Доп.инфо: о текущей фигуре, id следующей фигуры
-  static addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  // Рекорд в файле ведут только игры интерфейса
+  gui_engine->high_score_file = true;
+  fsmStep(gui_engine, signal);
+  // Матрица следующей фигуры (по ТЗ) строится по id только для GUI
+  if (signal->signal == GET_SIG && gui_engine->game_info.next != NULL) {
+    getPiece(gui_engine->game_info.next, gui_engine->addinfo.next_id,
+             gui_engine->addinfo.next_rot_id);
+  }
+  *state = gui_engine->state;
+  return gui_engine->game_info;
+}
+
+/**
+ * @brief Полное состояние игры GUI (только чтение), например для бота.
+ */
+const engine_t *fsmGuiEngine() { return gui_engine; }
+
+/**
+ * @brief Выбор текущей игры GUI, к которой обращаются функции API
+ * (userInput, userKey, userTick, updateCurrentState), - для нескольких игр
+ * в одном процессе (сервер сессий).
+ * @param engine Игра (начальное состояние START) или NULL - игра по
+ * умолчанию.
+ */
+void fsmGuiUse(engine_t *engine) {
+  gui_engine = engine != NULL ? engine : &gui_default;
+}
+
+/**
+ * @brief Адаптивная сложность игры GUI (действует со следующей игры).
+ */
+void fsmGuiAdaptive(bool enabled) { gui_engine->adaptive.enabled = enabled; }
 
+/**
+ * @brief Начальное состояние генератора фигур следующей игры GUI (повтор
+ * записанной игры, замеры на одинаковых партиях).
+ */
+void fsmGuiSeed(unsigned int seed) { gui_engine->addinfo.seed = seed; }
+
+/**
+ * @brief Один шаг автомата конечных состояний (FSM) для заданной игры.
+ *
+ * Сигнал переводится в событие, по таблице переходов выбирается и
+ * выполняется обработчик. Затем в этом же вызове проходятся состояния, не
+ * требующие ввода (SPAWN, ATTACHING), так что после шага игра всегда ждет
+ * следующего действия пользователя.
+ * Повторное создание массивов игнорируется, как и любые действия после их
+ * удаления (до нового создания). Шаги времени и клавиши с автоповтором
+ * (TICK_SIG, PRESS_SIG, RELEASE_SIG) передаются управлению по времени
+ * (s21_tetris_timing.c), которое выполняет действия через этот же вызов.
+ * После каждого действия обновляется задержка фиксации (timingMoved), так
+ * что сдвиг или вращение фигуры на опоре через userInput продлевает ее так
+ * же, как клавиша с автоповтором.
+ * Схема FSM строится из спецификации s21_tetris_fsm.def (make fsm_diagram).
+ * @param engine Игра, состояние которой изменяется.
+ * @param signal Обрабатываемый сигнал.
+ */
+void fsmStep(engine_t *engine, signal_t *signal) {
+  bool created = engine->game_info.field != NULL;
   if (signal->signal == INIT_SIG) {
-    tetrisCreate(&game_info, &fsm_addinfo);
+    if (!created) {
+      engine->state = START;
+      // Партию инициализирует старт игры (fsmStartGame)
+      tetrisAllocate(&engine->game_info, &engine->addinfo);
+      engine->board = boardSelect(BOARD_AUTO);
+      timingDefaultConfig(&engine->timing.config);
+      timingReset(&engine->timing);
+      metricsRegister(&engine->metrics);
+      if (engine->high_score_file)
+        engine->game_info.high_score = getHighScore();
+    }
   } else if (signal->signal == DESTR_SIG) {
-    tetrisDestroy(&game_info, &fsm_addinfo);
-  } else if (signal->signal != GET_SIG) {
-    if (fsm_state == START) {
-      fsm_state = fsmOnStartMode(signal, &game_info, &fsm_addinfo);
-    } else if (fsm_state == SPAWN) {
-      fsm_state = fsmOnSpawnMode(&game_info, &fsm_addinfo);
-    } else if (fsm_state == MOVING) {
-      fsm_state = fsmOnMovingMode(signal, &game_info, &fsm_addinfo);
-    } else if (fsm_state == ATTACHING) {
-      fsm_state = fsmOnAttachingMode(&game_info);
-    } else if (fsm_state == PAUSE) {
-      fsm_state = fsmOnPauseMode(signal, &game_info);
-    } else if (fsm_state == GAMEOVER) {
-      fsm_state = fsmOnGameoverMode(signal, &game_info);
+    if (created) metricsUnregister(&engine->metrics);
+    tetrisDestroy(&engine->game_info, &engine->addinfo);
+  } else if (signal->signal == TICK_SIG) {
+    if (created) timingTick(engine);
+  } else if (signal->signal == PRESS_SIG || signal->signal == RELEASE_SIG) {
+    if (created) timingKey(engine, signal->action, signal->signal == PRESS_SIG);
+  } else if (signal->signal != GET_SIG && created) {
+    // Задержка замеряется выборочно, чтобы не замедлять каждый шаг
+    bool sample = engine->step_count++ % METRICS_SAMPLE_PERIOD == 0;
+    long long start = sample ? metricsNow() : 0;
+    int col = engine->addinfo.col_pos, rot_id = engine->addinfo.piece_rot_id;
+    engine->state = fsmDispatch(engine, fsmEvent(signal));
+    while (fsm_auto[engine->state]) {
+      engine->state = fsmDispatch(engine, EV_AUTO);
     }
+    timingMoved(engine, col, rot_id);
+    metricsAdd(&engine->metrics.inputs, 1);
+    if (sample) metricsStepLatency(&engine->metrics, metricsNow() - start);
   }
-  *state = fsm_state;
-  return game_info;
+}
+
+/**
+ * @brief Формирование сигнала FSM по действию пользователя.
+ * @param action Действие пользователя (или GUI)
+ * @param hold Уточнение действия (падение фигуры, старт / завершение программы)
+ * @return Сигнал для передачи в FSM.
+ */
+signal_t makeSignal(UserAction_t action, bool hold) {
+  signal_t signal;
+  signal.action = action;
+  signal.signal = ACT_SIG;
+  // Создание массивов при запуске программы
+  if (signal.action == Start && hold) signal.signal = INIT_SIG;
+  // Нажатие стрелки вниз (падение фигуры) отличается от сдвига вниз по таймеру
+  if (signal.action == Down && hold) signal.signal = DROP_SIG;
+  // Очистка памяти перед выходом из программы
+  if (signal.action == Terminate && hold) signal.signal = DESTR_SIG;
+  return signal;
+}
+
+/**
+ * @brief Прием пользовательского ввода для заданной игры.
+ *
+ * Аналог userInput для игр, созданных вне GUI (библиотека, тесты).
+ * @param engine Игра, состояние которой изменяется.
+ * @param action Действие пользователя
+ * @param hold Уточнение действия (падение фигуры, старт / завершение игры)
+ */
+void engineInput(engine_t *engine, UserAction_t action, bool hold) {
+  signal_t signal = makeSignal(action, hold);
+  fsmStep(engine, &signal);
+}
+
+/**
+ * @brief Нажатие или отпускание клавиши с автоповтором для заданной игры.
+ * @param engine Игра, состояние которой изменяется.
+ * @param action Клавиша: Left, Right - сдвиг с автоповтором, Down - мягкое
+ * падение; остальные действия выполняются при нажатии.
+ * @param pressed true - нажатие, false - отпускание.
+ */
+void engineKey(engine_t *engine, UserAction_t action, bool pressed) {
+  signal_t signal = {action, pressed ? PRESS_SIG : RELEASE_SIG};
+  fsmStep(engine, &signal);
+}
+
+/**
+ * @brief Шаги времени игры (по TIMING_TICK_NS) для заданной игры.
+ * @param engine Игра, состояние которой изменяется.
+ * @param ticks Количество шагов.
+ */
+void engineTick(engine_t *engine, int ticks) {
+  signal_t signal = {Up, TICK_SIG};
+  for (int i = 0; i < ticks; i++) fsmStep(engine, &signal);
+}
+
+/**
+ * @brief Один переход из заданного состояния без автоматических переходов.
+ *
+ * Используется функциями fsmOn*Mode: игра собирается из переданных структур,
+ * после перехода изменения копируются обратно.
+ */
+static tetris_state fsmSingleTransition(tetris_state state, fsm_event event,
+                                        GameInfo_t *game_info,
+                                        addinfo_t *fsm_addinfo) {
+  engine_t engine = {.state = state, .game_info = *game_info};
+  if (fsm_addinfo != NULL) engine.addinfo = *fsm_addinfo;
+  tetris_state res = fsmDispatch(&engine, event);
+  *game_info = engine.game_info;
+  if (fsm_addinfo != NULL) *fsm_addinfo = engine.addinfo;
+  return res;
 }
 
 /**
@@ -58,16 +261,7 @@ GameInfo_t fsm(signal_t *signal, tetris_state *state) {
  */
 tetris_state fsmOnStartMode(signal_t *signal, GameInfo_t *game_info,
                             addinfo_t *fsm_addinfo) {
-  tetris_state state = START;
-  if (signal->action == Start) {
-    tetrisInit(game_info, fsm_addinfo);
-    state = SPAWN;
-    game_info->pause = GAME_MODE;
-  } else if (signal->action == Terminate) {
-    state = EXIT_STATE;
-    game_info->pause = EXIT_MODE;
-  }
-  return state;
+  return fsmSingleTransition(START, fsmEvent(signal), game_info, fsm_addinfo);
 }
 
 /**
@@ -83,18 +277,7 @@ tetris_state fsmOnStartMode(signal_t *signal, GameInfo_t *game_info,
  * @return Обновленное состояние FSM
  */
 tetris_state fsmOnSpawnMode(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
-  tetris_state state = SPAWN;
-  fromNextIntoCurrent(game_info, fsm_addinfo);
-  genNextPiece(game_info, fsm_addinfo);
-  if (checkPlacePiece(game_info, fsm_addinfo)) {
-    state = GAMEOVER;
-    game_info->pause = GAMEOVER_MODE;
-  } else {
-    state = MOVING;
-  }
-  // Фигура рисуется в любом случае, чтобы показать заполненность стакана
-  placePieceOnField(game_info, fsm_addinfo);
-  return state;
+  return fsmSingleTransition(SPAWN, EV_AUTO, game_info, fsm_addinfo);
 }
 
 /**
@@ -113,26 +296,7 @@ tetris_state fsmOnSpawnMode(GameInfo_t *game_info, addinfo_t *fsm_addinfo) {
  */
 tetris_state fsmOnMovingMode(signal_t *signal, GameInfo_t *game_info,
                              addinfo_t *fsm_addinfo) {
-  tetris_state state = MOVING;
-  if (signal->action == Terminate) {
-    state = GAMEOVER;
-    game_info->pause = GAMEOVER_MODE;
-  } else if (signal->action == Pause) {
-    state = PAUSE;
-    game_info->pause = PAUSE_MODE;
-  } else if (signal->action == Left) {
-    shiftPiece(game_info, fsm_addinfo, -1);
-  } else if (signal->action == Right) {
-    shiftPiece(game_info, fsm_addinfo, 1);
-  } else if (signal->action == Action) {
-    rotatePiece(game_info, fsm_addinfo);
-  } else if (signal->action == Down && signal->signal == DROP_SIG) {
-    dropPiece(game_info, fsm_addinfo);
-    state = ATTACHING;
-  } else if (signal->action == Down) {
-    state = movePieceDown(game_info, fsm_addinfo);
-  }
-  return state;
+  return fsmSingleTransition(MOVING, fsmEvent(signal), game_info, fsm_addinfo);
 }
 
 /**
@@ -146,34 +310,7 @@ tetris_state fsmOnMovingMode(signal_t *signal, GameInfo_t *game_info,
  * @return Обновленное состояние FSM
  */
 tetris_state fsmOnAttachingMode(GameInfo_t *game_info) {
-  // Удаление строк с подсчетом количества
-  int count = 0;
-  for (int i = 0; i < FIELD_ROWS; i++) {
-    if (isRowFilled(game_info->field[i])) {
-      count++;
-      shiftField(game_info->field, i);
-    }
-  }
-  // Подсчет очков за удаленные строки (согласно ТЗ)
-  if (count == 1) {
-    game_info->score += 100;
-  } else if (count == 2) {
-    game_info->score += 300;
-  } else if (count == 3) {
-    game_info->score += 700;
-  } else if (count == 4) {
-    game_info->score += 1500;
-  }
-  // Изменение скорости, уровня, рекорда
-  if (count > 0) {
-    if (game_info->score > game_info->high_score) {
-      game_info->high_score = game_info->score;
-    }
-    game_info->level = 1 + game_info->score / 600;
-    if (game_info->level > 10) game_info->level = 10;
-    game_info->speed = START_SPEED - (game_info->level - 1) * STEP_SPEED;
-  }
-  return SPAWN;
+  return fsmSingleTransition(ATTACHING, EV_AUTO, game_info, NULL);
 }
 
 /**
@@ -187,15 +324,7 @@ tetris_state fsmOnAttachingMode(GameInfo_t *game_info) {
  * @return Обновленное состояние FSM
  */
 tetris_state fsmOnGameoverMode(signal_t *signal, GameInfo_t *game_info) {
-  tetris_state state = GAMEOVER;
-  if (signal->action != Up &&
-      !(signal->action == Down && signal->signal == ACT_SIG)) {
-    state = START;
-    game_info->pause = START_MODE;
-    game_info->speed = START_SPEED;
-    saveHighScore(game_info);
-  }
-  return state;
+  return fsmSingleTransition(GAMEOVER, fsmEvent(signal), game_info, NULL);
 }
 
 /**
@@ -210,13 +339,240 @@ tetris_state fsmOnGameoverMode(signal_t *signal, GameInfo_t *game_info) {
  * @return Обновленное состояние FSM
  */
 tetris_state fsmOnPauseMode(signal_t *signal, GameInfo_t *game_info) {
-  tetris_state state = PAUSE;
-  if (signal->action == Pause) {
-    game_info->pause = GAME_MODE;
-    state = MOVING;
-  } else if (signal->action == Terminate) {
-    game_info->pause = GAMEOVER_MODE;
+  return fsmSingleTransition(PAUSE, fsmEvent(signal), game_info, NULL);
+}
+
+/**
+ * @brief Событие не меняет игру, состояние остается прежним.
+ */
+static tetris_state fsmIgnore(engine_t *engine) { return engine->state; }
+
+/**
+ * @brief START -> SPAWN: инициализация новой игры.
+ */
+static tetris_state fsmStartGame(engine_t *engine) {
+  engine->game_seed = engine->addinfo.seed;
+  engine->lines = 0;
+  tetrisInit(&engine->game_info, &engine->addinfo);
+  engine->game_info.pause = GAME_MODE;
+  engine->last_clear = 0;
+  engine->garbage_count = 0;
+  timingReset(&engine->timing);
+  engine->adaptive.active = engine->adaptive.enabled;
+  adaptiveReset(engine);
+  metricsGameStart(&engine->metrics);
+  return SPAWN;
+}
+
+/**
+ * @brief START -> EXIT_STATE: окончание работы программы.
+ */
+static tetris_state fsmExit(engine_t *engine) {
+  engine->game_info.pause = EXIT_MODE;
+  return EXIT_STATE;
+}
+
+/**
+ * @brief SPAWN: следующая фигура переносится на поле.
+ * @return MOVING или GAMEOVER, если фигуру некуда поместить.
+ */
+static tetris_state fsmSpawn(engine_t *engine) {
+  GameInfo_t *game_info = &engine->game_info;
+  addinfo_t *fsm_addinfo = &engine->addinfo;
+  const board_ops_t *board = engineBoard(engine);
+  tetris_state state = MOVING;
+  fromNextIntoCurrent(game_info, fsm_addinfo);
+  genNextPiece(game_info, fsm_addinfo);
+  engine->piece_count++;
+  adaptiveSpawn(engine);
+  metricsAdd(&engine->metrics.pieces[fsm_addinfo->piece_id], 1);
+  if (board->check(game_info, fsm_addinfo)) {
     state = GAMEOVER;
+    game_info->pause = GAMEOVER_MODE;
+    metricsGameEnd(&engine->metrics);
+  }
+  // Фигура рисуется в любом случае, чтобы показать заполненность стакана
+  board->place(game_info, fsm_addinfo);
+  return state;
+}
+
+/**
+ * @brief MOVING: сдвиг фигуры влево.
+ */
+static tetris_state fsmShiftLeft(engine_t *engine) {
+  engineBoard(engine)->shift(&engine->game_info, &engine->addinfo, -1);
+  return MOVING;
+}
+
+/**
+ * @brief MOVING: сдвиг фигуры вправо.
+ */
+static tetris_state fsmShiftRight(engine_t *engine) {
+  engineBoard(engine)->shift(&engine->game_info, &engine->addinfo, 1);
+  return MOVING;
+}
+
+/**
+ * @brief MOVING: вращение фигуры по часовой стрелке.
+ */
+static tetris_state fsmRotate(engine_t *engine) {
+  rotatePiece(&engine->game_info, &engine->addinfo, 1);
+  return MOVING;
+}
+
+/**
+ * @brief MOVING: вращение фигуры против часовой стрелки.
+ */
+static tetris_state fsmRotateCCW(engine_t *engine) {
+  rotatePiece(&engine->game_info, &engine->addinfo, -1);
+  return MOVING;
+}
+
+/**
+ * @brief MOVING: сдвиг фигуры вниз по таймеру.
+ * @return MOVING или ATTACHING, если фигура дошла до препятствия.
+ */
+static tetris_state fsmMoveDown(engine_t *engine) {
+  return engineBoard(engine)->move_down(&engine->game_info, &engine->addinfo);
+}
+
+/**
+ * @brief MOVING -> ATTACHING: падение фигуры.
+ */
+static tetris_state fsmDrop(engine_t *engine) {
+  engineBoard(engine)->drop(&engine->game_info, &engine->addinfo);
+  return ATTACHING;
+}
+
+/**
+ * @brief MOVING: отложение фигуры (hold), не чаще раза на фигуру.
+ *
+ * Если отложенной фигуры нет, текущая откладывается и появляется следующая.
+ * Иначе текущая и отложенная меняются местами, отложенная появляется в
+ * стартовой позиции.
+ * @return SPAWN, MOVING или GAMEOVER, если отложенную фигуру некуда
+ * поместить.
+ */
+static tetris_state fsmHold(engine_t *engine) {
+  GameInfo_t *game_info = &engine->game_info;
+  addinfo_t *fsm_addinfo = &engine->addinfo;
+  const board_ops_t *board = engineBoard(engine);
+  tetris_state state = MOVING;
+  if (!fsm_addinfo->hold_used) {
+    board->remove(game_info, fsm_addinfo);
+    int id = fsm_addinfo->hold_id, rot_id = fsm_addinfo->hold_rot_id;
+    bool has_hold = fsm_addinfo->has_hold;
+    fsm_addinfo->hold_id = fsm_addinfo->piece_id;
+    fsm_addinfo->hold_rot_id = fsm_addinfo->piece_rot_id;
+    fsm_addinfo->has_hold = true;
+    fsm_addinfo->hold_used = true;
+    if (!has_hold) {
+      state = SPAWN;
+    } else {
+      fsm_addinfo->piece_id = id;
+      fsm_addinfo->piece_rot_id = rot_id;
+      getPiece(fsm_addinfo->piece, id, rot_id);
+      fsm_addinfo->row_pos = 0;
+      fsm_addinfo->col_pos = SPAWN_COL;
+      if (board->check(game_info, fsm_addinfo)) {
+        state = GAMEOVER;
+        game_info->pause = GAMEOVER_MODE;
+        metricsGameEnd(&engine->metrics);
+      }
+      board->place(game_info, fsm_addinfo);
+    }
+  }
+  return state;
+}
+
+/**
+ * @brief ATTACHING -> SPAWN: удаление заполненных строк, подсчет очков,
+ * изменение уровня, скорости, рекорда.
+ *
+ * Если строки не удалены, поднимается входящий мусор (режим versus). В
+ * режиме адаптивной сложности скорость уровня и веса фигур подстраиваются
+ * по навыку игрока (adaptivePiece).
+ * @return SPAWN или GAMEOVER, если мусор вытолкнул клетки за верх поля.
+ */
+static tetris_state fsmAttach(engine_t *engine) {
+  GameInfo_t *game_info = &engine->game_info;
+  // Заполниться могли только строки, занятые последней фигурой. Без данных о
+  // фигуре (fsmOnAttachingMode) проверяется все поле.
+  int first = 0, last = FIELD_ROWS;
+  if (engine->addinfo.piece != NULL) {
+    first = engine->addinfo.row_pos > 0 ? engine->addinfo.row_pos : 0;
+    if (first + PIECE_ROWS < FIELD_ROWS) last = first + PIECE_ROWS;
+  }
+  // Удаление строк с подсчетом количества
+  int count = engineBoard(engine)->clear_rows(game_info->field, first, last);
+  // Подсчет очков за удаленные строки (согласно ТЗ)
+  static const int points[PIECE_ROWS + 1] = {0, 100, 300, 700, 1500};
+  game_info->score += points[count];
+  // Изменение скорости, уровня, рекорда
+  if (count > 0) {
+    // Строки выше удаленных сдвинулись, хеш считается заново
+    game_info->hash = fieldHash(game_info->field);
+    int old_level = game_info->level;
+    if (game_info->score > game_info->high_score) {
+      game_info->high_score = game_info->score;
+    }
+    game_info->level = 1 + game_info->score / 600;
+    if (game_info->level > 10) game_info->level = 10;
+    game_info->speed = START_SPEED - (game_info->level - 1) * STEP_SPEED;
+    metricsAdd(&engine->metrics.clears[count], 1);
+    if (game_info->level > old_level) {
+      metricsAdd(&engine->metrics.level_ups, game_info->level - old_level);
+    }
+  }
+  engine->last_clear = count;
+  engine->lines += count;
+  engine->addinfo.hold_used = false;
+  tetris_state state = SPAWN;
+  if (count == 0 && engine->garbage_count > 0) {
+    if (pushGarbage(game_info->field, engine->garbage, engine->garbage_count)) {
+      state = GAMEOVER;
+      game_info->pause = GAMEOVER_MODE;
+      metricsGameEnd(&engine->metrics);
+    }
+    engine->garbage_count = 0;
+    game_info->hash = fieldHash(game_info->field);
   }
+  if (engine->adaptive.active) adaptivePiece(engine);
   return state;
 }
+
+/**
+ * @brief MOVING -> PAUSE.
+ */
+static tetris_state fsmPause(engine_t *engine) {
+  engine->game_info.pause = PAUSE_MODE;
+  return PAUSE;
+}
+
+/**
+ * @brief PAUSE -> MOVING.
+ */
+static tetris_state fsmResume(engine_t *engine) {
+  engine->game_info.pause = GAME_MODE;
+  return MOVING;
+}
+
+/**
+ * @brief MOVING, PAUSE -> GAMEOVER: окончание игры по Esc.
+ */
+static tetris_state fsmGameover(engine_t *engine) {
+  engine->game_info.pause = GAMEOVER_MODE;
+  metricsGameEnd(&engine->metrics);
+  return GAMEOVER;
+}
+
+/**
+ * @brief GAMEOVER -> START: запись рекорда (игры GUI) и возврат к стартовому
+ * экрану.
+ */
+static tetris_state fsmRestart(engine_t *engine) {
+  engine->game_info.pause = START_MODE;
+  engine->game_info.speed = START_SPEED;
+  if (engine->high_score_file) saveHighScore(&engine->game_info);
+  return START;
+}
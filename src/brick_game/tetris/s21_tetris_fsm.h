@@ -6,6 +6,25 @@
 #include "../../gui/cli/s21_define.h"
 #include "s21_tetris_backend.h"
 
+/// @brief События FSM: действия пользователя и служебные события
+typedef enum {
+  EV_START = Start,
+  EV_PAUSE = Pause,
+  EV_TERMINATE = Terminate,
+  EV_LEFT = Left,
+  EV_RIGHT = Right,
+  EV_UP = Up,
+  EV_DOWN = Down,
+  EV_ACTION = Action,
+  EV_ACTION_CCW = ActionCCW,
+  EV_HOLD = Hold,
+  // Падение фигуры (Down с сигналом DROP_SIG)
+  EV_DROP,
+  // Автоматический переход из состояний без ввода (SPAWN, ATTACHING)
+  EV_AUTO,
+  FSM_EVENT_COUNT
+} fsm_event;
+
 tetris_state fsmOnStartMode(signal_t *signal, GameInfo_t *game_info,
                             addinfo_t *fsm_addinfo);
 tetris_state fsmOnSpawnMode(GameInfo_t *game_info, addinfo_t *fsm_addinfo);
@@ -15,5 +34,14 @@ tetris_state fsmOnAttachingMode(GameInfo_t *game_info);
 tetris_state fsmOnGameoverMode(signal_t *signal, GameInfo_t *game_info);
 tetris_state fsmOnPauseMode(signal_t *signal, GameInfo_t *game_info);
 GameInfo_t fsm(signal_t *signal, tetris_state *state);
+const engine_t *fsmGuiEngine();
+void fsmGuiUse(engine_t *engine);
+void fsmGuiAdaptive(bool enabled);
+void fsmGuiSeed(unsigned int seed);
+void fsmStep(engine_t *engine, signal_t *signal);
+signal_t makeSignal(UserAction_t action, bool hold);
+void engineInput(engine_t *engine, UserAction_t action, bool hold);
+void engineKey(engine_t *engine, UserAction_t action, bool pressed);
+void engineTick(engine_t *engine, int ticks);
 
 #endif  // FSM_BACK_H
@@ -0,0 +1,103 @@
+/**
+ * @file s21_tetris_hint.c
+ * @brief Подсказка хода (--hint): лучшее размещение текущей фигуры,
+ * которое интерфейс рисует контуром на поле.
+ *
+ * Размещения перебирает планировщик бота: все повороты и столбцы фигуры по
+ * битовым маскам строк, с учетом следующей фигуры, в пределах времени
+ * HINT_BUDGET. Подсказка запрашивается на каждом кадре, поэтому найденное
+ * размещение хранится вместе с ключом - номером и видом фигуры и хешем
+ * поля без нее. Сдвиги, вращения и падение фигуры ключ не меняют, и кадр
+ * обходится сравнением ключа (хеш поля без фигуры считается по 4 клеткам
+ * из хеша, который ведет игра). Поиск повторяется только для новой фигуры,
+ * после обмена с отложенной или при изменении поля под фигурой.
+ */
+#include "s21_tetris_hint.h"
+
+/**
+ * @brief Создание подсказки.
+ * @param budget_ns Время на поиск размещения одной фигуры, нс.
+ * @return Подсказка или NULL при ошибке выделения памяти.
+ */
+hint_t *hintCreate(long long budget_ns) {
+  hint_t *hint = (hint_t *)calloc(1, sizeof(hint_t));
+  if (hint != NULL) {
+    hint->bot = botCreate(budget_ns);
+    if (hint->bot == NULL) {
+      free(hint);
+      hint = NULL;
+    } else {
+      hint->bot->max_depth = HINT_DEPTH;
+    }
+  }
+  return hint;
+}
+
+/**
+ * @brief Удаление подсказки. NULL игнорируется.
+ */
+void hintDestroy(hint_t *hint) {
+  if (hint != NULL) {
+    botDestroy(hint->bot);
+    free(hint);
+  }
+}
+
+/**
+ * @brief Хеш поля игры без клеток текущей фигуры.
+ */
+static unsigned long long hintBoardHash(const engine_t *engine) {
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  unsigned long long hash = engine->game_info.hash;
+  int mask = pieceMask(fsm_addinfo->piece_id, fsm_addinfo->piece_rot_id);
+  for (; mask; mask &= mask - 1) {
+    int k = __builtin_ctz(mask);
+    hash ^= zobrist_keys[fsm_addinfo->row_pos + k / PIECE_COLUMNS]
+                        [fsm_addinfo->col_pos + k % PIECE_COLUMNS];
+  }
+  return hash;
+}
+
+/**
+ * @brief Подсказка для текущего состояния игры.
+ *
+ * Если фигура и поле под ней не изменились с прошлого вызова, размещение
+ * не ищется заново.
+ * @param engine Игра. Не изменяется.
+ * @return true - размещение есть (игра в состоянии MOVING).
+ */
+bool hintUpdate(hint_t *hint, const engine_t *engine) {
+  if (engine->state != MOVING) return false;
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  unsigned long long hash = hintBoardHash(engine);
+  if (hint->valid && hint->engine == engine &&
+      hint->piece == engine->piece_count &&
+      hint->piece_id == fsm_addinfo->piece_id && hint->hash == hash) {
+    hint->cached++;
+  } else {
+    long long start = metricsNow();
+    botPlan(hint->bot, engine);
+    long long time = metricsNow() - start;
+    hint->engine = engine;
+    hint->piece = engine->piece_count;
+    hint->piece_id = fsm_addinfo->piece_id;
+    hint->hash = hash;
+    hint->valid = true;
+    hint->mask = hint->bot->target_mask;
+    hint->row = hint->bot->target_row;
+    hint->col = hint->bot->target_col;
+    hint->plans++;
+    hint->plan_ns += time;
+    if (time > hint->plan_max_ns) hint->plan_max_ns = time;
+  }
+  return true;
+}
+
+/**
+ * @brief Печать статистики подсказки: поиски и их время, кадры без поиска.
+ */
+void hintPrintStats(const hint_t *hint, FILE *file) {
+  fprintf(file, "hint: %lld plans, %.1f us avg, %.1f us max, %lld cached\n",
+          hint->plans, hint->plans ? hint->plan_ns / 1e3 / hint->plans : 0.,
+          hint->plan_max_ns / 1e3, hint->cached);
+}
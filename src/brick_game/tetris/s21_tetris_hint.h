@@ -0,0 +1,55 @@
+#ifndef TETRIS_HINT_H
+#define TETRIS_HINT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "s21_tetris_bot.h"
+
+// Время на поиск подсказки, нс: половина кадра 1 мс, остальное - отрисовка
+#define HINT_BUDGET 500000LL
+// Глубина поиска: текущая и следующая фигуры (ожидание по неизвестным
+// фигурам подсказке не нужно)
+#define HINT_DEPTH BOT_KNOWN
+
+/// @brief Подсказка: лучшее размещение текущей фигуры на поле игры.
+///
+/// Размещение ищется планировщиком бота (перебор поворотов и столбцов по
+/// битовым маскам строк) только при изменении поля или фигуры. Пока
+/// игрок двигает и вращает фигуру, используется найденное размещение.
+typedef struct {
+  /// Планировщик (бот с ограниченными глубиной и временем)
+  bot_t *bot;
+  /// Ключ размещения: игра, номер фигуры, фигура и хеш поля без нее
+  const engine_t *engine;
+  unsigned int piece;
+  int piece_id;
+  unsigned long long hash;
+  /// Размещение найдено
+  bool valid;
+  /// Размещение: маска шаблона фигуры piece_id, строка и столбец
+  int mask;
+  int row;
+  int col;
+  /// Статистика: поисков, запросов без поиска, время поисков, нс
+  long long plans;
+  long long cached;
+  long long plan_ns;
+  long long plan_max_ns;
+} hint_t;
+
+hint_t *hintCreate(long long budget_ns);
+void hintDestroy(hint_t *hint);
+bool hintUpdate(hint_t *hint, const engine_t *engine);
+void hintPrintStats(const hint_t *hint, FILE *file);
+
+/**
+ * @brief Клетка поля (row, col) занята фигурой подсказки.
+ */
+static inline bool hintCell(const hint_t *hint, int row, int col) {
+  int i = row - hint->row, j = col - hint->col;
+  return i >= 0 && i < PIECE_ROWS && j >= 0 && j < PIECE_COLUMNS &&
+         ((hint->mask >> (i * PIECE_COLUMNS + j)) & 1);
+}
+
+#endif  // TETRIS_HINT_H
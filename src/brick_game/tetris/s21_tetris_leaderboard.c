@@ -0,0 +1,533 @@
+/**
+ * @file s21_tetris_leaderboard.c
+ * @brief Локальное хранилище результатов игр (таблица рекордов).
+ *
+ * На диске два файла в каталоге хранилища:
+ * - журнал результатов (LB_LOG_FILE) - записи lb_result_t только
+ *   дописываются, пачками по LB_BATCH с fsync; это единственный источник
+ *   данных, недописанная при сбое последняя запись отбрасывается;
+ * - индекс (LB_INDEX_FILE) - отсортированные счета всех игр из первых
+ *   index_count записей журнала, переписывается целиком (через временный
+ *   файл и rename) при закрытии хранилища.
+ *
+ * В памяти:
+ * - куча LB_TOP_K лучших результатов - запрос лучших за K log K;
+ * - хеш-таблица игроков с лучшим результатом - запрос игрока за O(1);
+ * - отсортированный массив счетов и короткий хвост новых счетов, который
+ *   сливается с массивом каждые LB_TAIL_MAX игр - процентиль за
+ *   двоичный поиск и проход хвоста.
+ * При открытии индекс загружается с диска, а записи журнала после него
+ * досчитываются (без сортировки всех счетов заново); журнал читается
+ * целиком один раз для кучи и таблицы игроков.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "s21_tetris_leaderboard.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../gui/cli/s21_define.h"
+
+// Записей журнала, читаемых за один read() при открытии
+#define LB_READ_CHUNK 4096
+// Начальный размер таблицы игроков (степень двойки)
+#define LB_PLAYERS_MIN 64
+
+/// @brief Заголовок файла индекса
+typedef struct {
+  unsigned long long magic;
+  /// Записей журнала, учтенных в индексе
+  long long records;
+  /// Счетов в индексе (следуют за заголовком, по возрастанию)
+  long long count;
+} lb_index_header_t;
+
+/**
+ * @brief Путь файла name в каталоге dir (память выделяется).
+ */
+static char *lbPath(const char *dir, const char *name) {
+  size_t len = strlen(dir) + strlen(name) + 2;
+  char *path = malloc(len);
+  if (path != NULL) snprintf(path, len, "%s/%s", dir, name);
+  return path;
+}
+
+/**
+ * @brief Добавление результата в кучу лучших: пока куча не заполнена -
+ * всегда, затем - если счет больше худшего из лучших (вершины кучи).
+ */
+static void lbTopPush(leaderboard_t *lb, const lb_result_t *result) {
+  lb_result_t *top = lb->top;
+  int i;
+  if (lb->top_count < LB_TOP_K) {
+    // Подъем нового элемента от конца кучи
+    i = lb->top_count++;
+    while (i > 0 && top[(i - 1) / 2].score > result->score) {
+      top[i] = top[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    top[i] = *result;
+  } else if (result->score > top[0].score) {
+    // Замена вершины и спуск
+    i = 0;
+    for (int child = 1; child < LB_TOP_K; child = 2 * i + 1) {
+      if (child + 1 < LB_TOP_K && top[child + 1].score < top[child].score)
+        child++;
+      if (top[child].score >= result->score) break;
+      top[i] = top[child];
+      i = child;
+    }
+    top[i] = *result;
+  }
+}
+
+/**
+ * @brief Хеш FNV-1a имени игрока.
+ */
+static unsigned int lbNameHash(const char *name) {
+  unsigned int hash = 2166136261u;
+  for (int i = 0; i < LB_NAME_SIZE && name[i]; i++)
+    hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+  return hash;
+}
+
+/**
+ * @brief Поиск игрока в таблице.
+ * @return Ячейка игрока или пустая ячейка, куда его можно добавить.
+ */
+static lb_player_t *lbPlayerSlot(lb_player_t *players, int size,
+                                 const char *name) {
+  unsigned int i = lbNameHash(name) & (size - 1);
+  while (players[i].used &&
+         strncmp(players[i].best.player, name, LB_NAME_SIZE) != 0)
+    i = (i + 1) & (size - 1);
+  return &players[i];
+}
+
+/**
+ * @brief Увеличение таблицы игроков вдвое (заполнение не больше половины).
+ */
+static int lbPlayersGrow(leaderboard_t *lb) {
+  int size = lb->players_size ? lb->players_size * 2 : LB_PLAYERS_MIN;
+  lb_player_t *players = calloc(size, sizeof(lb_player_t));
+  if (players == NULL) return FAILURE_EXIT;
+  for (int i = 0; i < lb->players_size; i++) {
+    if (lb->players[i].used)
+      *lbPlayerSlot(players, size, lb->players[i].best.player) =
+          lb->players[i];
+  }
+  free(lb->players);
+  lb->players = players;
+  lb->players_size = size;
+  return SUCCESSFUL_EXIT;
+}
+
+/**
+ * @brief Сравнение счетов для qsort (по возрастанию).
+ */
+static int lbCompareScores(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Слияние хвоста новых счетов с отсортированным массивом.
+ */
+static int lbMerge(leaderboard_t *lb) {
+  if (lb->tail_count == 0) return SUCCESSFUL_EXIT;
+  long long need = lb->sorted_count + lb->tail_count;
+  if (need > lb->sorted_size) {
+    long long size = lb->sorted_size ? lb->sorted_size : LB_TAIL_MAX;
+    while (size < need) size *= 2;
+    int *sorted = realloc(lb->sorted, size * sizeof(int));
+    if (sorted == NULL) return FAILURE_EXIT;
+    lb->sorted = sorted;
+    lb->sorted_size = size;
+  }
+  qsort(lb->tail, lb->tail_count, sizeof(int), lbCompareScores);
+  // Слияние с конца, на месте
+  long long i = lb->sorted_count - 1, k = need - 1;
+  int j = lb->tail_count - 1;
+  while (j >= 0) {
+    if (i >= 0 && lb->sorted[i] > lb->tail[j])
+      lb->sorted[k--] = lb->sorted[i--];
+    else
+      lb->sorted[k--] = lb->tail[j--];
+  }
+  lb->sorted_count = need;
+  lb->tail_count = 0;
+  return SUCCESSFUL_EXIT;
+}
+
+/**
+ * @brief Учет результата в памяти: куча лучших, игрок, счета.
+ *
+ * Память (таблица игроков, место в хвосте счетов) выделяется до изменения
+ * данных: при ошибке результат не учтен нигде.
+ * @param indexed Счет уже есть в загруженном индексе.
+ */
+static int lbInsert(leaderboard_t *lb, const lb_result_t *result,
+                    bool indexed) {
+  int res = SUCCESSFUL_EXIT;
+  if ((lb->players_count + 1) * 2 > lb->players_size) res = lbPlayersGrow(lb);
+  if (!res && !indexed && lb->tail_count == LB_TAIL_MAX) res = lbMerge(lb);
+  if (!res) {
+    lbTopPush(lb, result);
+    lb_player_t *player =
+        lbPlayerSlot(lb->players, lb->players_size, result->player);
+    if (!player->used) {
+      player->used = true;
+      player->best = *result;
+      lb->players_count++;
+    } else if (result->score > player->best.score) {
+      player->best = *result;
+    }
+    player->games++;
+    if (!indexed) lb->tail[lb->tail_count++] = result->score;
+  }
+  return res;
+}
+
+/**
+ * @brief Загрузка индекса, если он согласован с журналом.
+ * @param records Записей в журнале.
+ */
+static void lbLoadIndex(leaderboard_t *lb, long long records) {
+  FILE *file = fopen(lb->index_path, "rb");
+  if (file == NULL) return;
+  lb_index_header_t header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            header.magic == LB_INDEX_MAGIC && header.records >= 0 &&
+            header.records <= records && header.count == header.records;
+  if (ok && header.count > 0) {
+    lb->sorted = malloc(header.count * sizeof(int));
+    ok = lb->sorted != NULL &&
+         fread(lb->sorted, sizeof(int), header.count, file) ==
+             (size_t)header.count;
+    for (long long i = 1; ok && i < header.count; i++)
+      ok = lb->sorted[i - 1] <= lb->sorted[i];
+  }
+  if (ok) {
+    lb->sorted_count = lb->sorted_size = header.count;
+    lb->index_count = header.records;
+  } else {
+    free(lb->sorted);
+    lb->sorted = NULL;
+  }
+  fclose(file);
+}
+
+/**
+ * @brief Чтение журнала: недописанная последняя запись отрезается, все
+ * записи учитываются в памяти (счета - только не вошедшие в индекс).
+ */
+static int lbLoadLog(leaderboard_t *lb) {
+  struct stat st;
+  if (fstat(lb->log_fd, &st) != 0) return FAILURE_EXIT;
+  long long records = st.st_size / (long long)sizeof(lb_result_t);
+  if (records * (long long)sizeof(lb_result_t) != st.st_size &&
+      ftruncate(lb->log_fd, records * sizeof(lb_result_t)) != 0)
+    return FAILURE_EXIT;
+  lbLoadIndex(lb, records);
+  lb_result_t *chunk = malloc(LB_READ_CHUNK * sizeof(lb_result_t));
+  int res = chunk == NULL;
+  long long done = 0;
+  while (!res && done < records) {
+    long long n = records - done;
+    if (n > LB_READ_CHUNK) n = LB_READ_CHUNK;
+    ssize_t bytes = pread(lb->log_fd, chunk, n * sizeof(lb_result_t),
+                          done * sizeof(lb_result_t));
+    if (bytes < (ssize_t)sizeof(lb_result_t)) {
+      res = FAILURE_EXIT;
+    } else {
+      n = bytes / sizeof(lb_result_t);
+      for (long long i = 0; i < n && !res; i++) {
+        chunk[i].player[LB_NAME_SIZE - 1] = '\0';
+        res = lbInsert(lb, &chunk[i], done + i < lb->index_count);
+      }
+      done += n;
+    }
+  }
+  free(chunk);
+  lb->count = records;
+  return res;
+}
+
+/**
+ * @brief Открытие (или создание) хранилища в каталоге dir.
+ *
+ * Каталог создается, если его нет. Журнал и индекс загружаются в память.
+ * Функции хранилища (кроме lbClose) можно вызывать из разных потоков.
+ * @return Хранилище или NULL при ошибке.
+ */
+leaderboard_t *lbOpen(const char *dir) {
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) return NULL;
+  leaderboard_t *lb = calloc(1, sizeof(leaderboard_t));
+  if (lb == NULL) return NULL;
+  lb->log_fd = -1;
+  lb->log_path = lbPath(dir, LB_LOG_FILE);
+  lb->index_path = lbPath(dir, LB_INDEX_FILE);
+  int res = lb->log_path == NULL || lb->index_path == NULL;
+  if (!res) {
+    lb->log_fd = open(lb->log_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    res = lb->log_fd < 0;
+  }
+  if (!res) res = lbLoadLog(lb);
+  if (!res) res = pthread_mutex_init(&lb->lock, NULL) != 0;
+  if (res) {
+    if (lb->log_fd >= 0) close(lb->log_fd);
+    free(lb->log_path);
+    free(lb->index_path);
+    free(lb->players);
+    free(lb->sorted);
+    free(lb);
+    lb = NULL;
+  }
+  return lb;
+}
+
+/**
+ * @brief Поток открытия хранилища.
+ */
+static void *lbOpenThread(void *arg) {
+  lb_pending_t *pending = (lb_pending_t *)arg;
+  pending->lb = lbOpen(pending->dir);
+  return NULL;
+}
+
+/**
+ * @brief Запуск открытия хранилища (загрузки журнала) в отдельном потоке,
+ * чтобы чтение с диска шло параллельно с инициализацией интерфейса.
+ * Результат забирает lbOpenWait. Если поток не создается, хранилище
+ * открывается в lbOpenWait.
+ */
+void lbOpenStart(lb_pending_t *pending, const char *dir) {
+  pending->dir = dir;
+  pending->lb = NULL;
+  pending->started =
+      pthread_create(&pending->thread, NULL, lbOpenThread, pending) == 0;
+}
+
+/**
+ * @brief Ожидание открытия хранилища, запущенного lbOpenStart.
+ * @return Хранилище или NULL при ошибке.
+ */
+leaderboard_t *lbOpenWait(lb_pending_t *pending) {
+  if (pending->started) {
+    pthread_join(pending->thread, NULL);
+    pending->started = false;
+  } else {
+    pending->lb = lbOpen(pending->dir);
+  }
+  return pending->lb;
+}
+
+/**
+ * @brief Запись накопленных результатов в журнал и fsync (под блокировкой).
+ *
+ * После неполной или неудачной записи следующий вызов продолжает с первого
+ * незаписанного байта пачки, чтобы записи в журнале не повторялись.
+ */
+static int lbFlushLocked(leaderboard_t *lb) {
+  const char *data = (const char *)lb->batch;
+  size_t size = lb->batch_count * sizeof(lb_result_t);
+  int res = SUCCESSFUL_EXIT;
+  while (!res && lb->batch_written < size) {
+    ssize_t bytes = write(lb->log_fd, data + lb->batch_written,
+                          size - lb->batch_written);
+    if (bytes > 0)
+      lb->batch_written += bytes;
+    else if (bytes < 0 && errno != EINTR)
+      res = FAILURE_EXIT;
+  }
+  if (!res && size > 0) res = fsync(lb->log_fd) != 0;
+  if (!res) {
+    lb->batch_count = 0;
+    lb->batch_written = 0;
+  }
+  return res;
+}
+
+/**
+ * @brief Добавление результата законченной игры.
+ *
+ * Результат сразу учитывается в запросах, на диск записывается пачкой из
+ * LB_BATCH результатов (или при lbFlush / lbClose).
+ * @return 0 - успешно, 1 - ошибка записи или выделения памяти.
+ */
+int lbAdd(leaderboard_t *lb, const lb_result_t *result) {
+  lb_result_t copy = *result;
+  copy.player[LB_NAME_SIZE - 1] = '\0';
+  pthread_mutex_lock(&lb->lock);
+  int res = SUCCESSFUL_EXIT;
+  if (lb->batch_count == LB_BATCH) res = lbFlushLocked(lb);
+  if (!res) res = lbInsert(lb, &copy, false);
+  if (!res) {
+    lb->batch[lb->batch_count++] = copy;
+    lb->count++;
+    if (lb->batch_count == LB_BATCH) res = lbFlushLocked(lb);
+  }
+  pthread_mutex_unlock(&lb->lock);
+  return res;
+}
+
+/**
+ * @brief Запись на диск всех добавленных результатов (с fsync).
+ */
+int lbFlush(leaderboard_t *lb) {
+  pthread_mutex_lock(&lb->lock);
+  int res = lbFlushLocked(lb);
+  pthread_mutex_unlock(&lb->lock);
+  return res;
+}
+
+/**
+ * @brief Сравнение результатов для qsort (по убыванию счета).
+ */
+static int lbCompareResults(const void *a, const void *b) {
+  int x = ((const lb_result_t *)a)->score, y = ((const lb_result_t *)b)->score;
+  return (x < y) - (x > y);
+}
+
+/**
+ * @brief Лучшие результаты по убыванию счета.
+ * @param out Буфер на k результатов.
+ * @param k Сколько результатов нужно (не больше LB_TOP_K учитывается).
+ * @return Количество записанных результатов.
+ */
+int lbTop(leaderboard_t *lb, lb_result_t *out, int k) {
+  lb_result_t top[LB_TOP_K];
+  pthread_mutex_lock(&lb->lock);
+  int count = lb->top_count;
+  memcpy(top, lb->top, count * sizeof(lb_result_t));
+  pthread_mutex_unlock(&lb->lock);
+  qsort(top, count, sizeof(lb_result_t), lbCompareResults);
+  if (k > count) k = count;
+  if (k < 0) k = 0;
+  memcpy(out, top, k * sizeof(lb_result_t));
+  return k;
+}
+
+/**
+ * @brief Лучший результат игрока.
+ * @param best Результат. Заполняется, если игрок найден.
+ * @param games Количество игр игрока или NULL.
+ * @return 0 - игрок найден, 1 - нет.
+ */
+int lbPlayerBest(leaderboard_t *lb, const char *player, lb_result_t *best,
+                 long long *games) {
+  int res = FAILURE_EXIT;
+  pthread_mutex_lock(&lb->lock);
+  if (lb->players_size > 0) {
+    const lb_player_t *slot =
+        lbPlayerSlot(lb->players, lb->players_size, player);
+    if (slot->used) {
+      *best = slot->best;
+      if (games != NULL) *games = slot->games;
+      res = SUCCESSFUL_EXIT;
+    }
+  }
+  pthread_mutex_unlock(&lb->lock);
+  return res;
+}
+
+/**
+ * @brief Процентиль счета: доля игр (в процентах) со счетом меньше score.
+ */
+double lbPercentile(leaderboard_t *lb, int score) {
+  pthread_mutex_lock(&lb->lock);
+  long long lo = 0, hi = lb->sorted_count;
+  while (lo < hi) {
+    long long mid = lo + (hi - lo) / 2;
+    if (lb->sorted[mid] < score)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (int i = 0; i < lb->tail_count; i++) lo += lb->tail[i] < score;
+  long long count = lb->count;
+  pthread_mutex_unlock(&lb->lock);
+  return count > 0 ? 100.0 * lo / count : 0;
+}
+
+/**
+ * @brief Количество результатов в хранилище.
+ */
+long long lbCount(leaderboard_t *lb) {
+  pthread_mutex_lock(&lb->lock);
+  long long count = lb->count;
+  pthread_mutex_unlock(&lb->lock);
+  return count;
+}
+
+/**
+ * @brief Запись индекса счетов: временный файл, fsync, rename.
+ */
+static int lbWriteIndex(leaderboard_t *lb) {
+  int res = lbMerge(lb);
+  size_t len = strlen(lb->index_path) + 5;
+  char *tmp = malloc(len);
+  if (tmp == NULL) res = FAILURE_EXIT;
+  FILE *file = NULL;
+  if (!res) {
+    snprintf(tmp, len, "%s.tmp", lb->index_path);
+    file = fopen(tmp, "wb");
+    res = file == NULL;
+  }
+  if (!res) {
+    lb_index_header_t header = {LB_INDEX_MAGIC, lb->count, lb->sorted_count};
+    res = fwrite(&header, sizeof(header), 1, file) != 1 ||
+          fwrite(lb->sorted, sizeof(int), lb->sorted_count, file) !=
+              (size_t)lb->sorted_count ||
+          fflush(file) != 0 || fsync(fileno(file)) != 0;
+  }
+  if (file != NULL && fclose(file) != 0) res = FAILURE_EXIT;
+  if (!res) res = rename(tmp, lb->index_path) != 0;
+  if (!res) lb->index_count = lb->count;
+  free(tmp);
+  return res;
+}
+
+/**
+ * @brief Закрытие хранилища: запись оставшихся результатов и индекса,
+ * освобождение памяти.
+ * @return 0 - успешно, 1 - ошибка записи (память освобождается в любом
+ * случае).
+ */
+int lbClose(leaderboard_t *lb) {
+  if (lb == NULL) return SUCCESSFUL_EXIT;
+  int res = lbFlushLocked(lb);
+  if (!res && lb->index_count != lb->count) res = lbWriteIndex(lb);
+  if (close(lb->log_fd) != 0) res = FAILURE_EXIT;
+  pthread_mutex_destroy(&lb->lock);
+  free(lb->log_path);
+  free(lb->index_path);
+  free(lb->players);
+  free(lb->sorted);
+  free(lb);
+  return res;
+}
+
+/**
+ * @brief Результат игры, которая только что закончилась.
+ * @param engine Игра в состоянии GAMEOVER.
+ * @param player Имя игрока (обрезается до LB_NAME_SIZE - 1 символов).
+ * @param result Результат. Заполняется.
+ */
+void lbResultFromEngine(const engine_t *engine, const char *player,
+                        lb_result_t *result) {
+  memset(result, 0, sizeof(lb_result_t));
+  snprintf(result->player, LB_NAME_SIZE, "%s", player);
+  result->seed = engine->game_seed;
+  result->score = engine->game_info.score;
+  result->lines = engine->lines;
+  result->level = engine->game_info.level;
+  result->duration_ms =
+      (metricsNow() - engine->metrics.game_start_ns) / 1000000;
+}
@@ -0,0 +1,102 @@
+#ifndef TETRIS_LEADERBOARD_H
+#define TETRIS_LEADERBOARD_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "s21_tetris_backend.h"
+
+// Размер имени игрока с завершающим нулем
+#define LB_NAME_SIZE 16
+// Размер таблицы лучших результатов (top-K)
+#define LB_TOP_K 100
+// Результатов в одной записи на диск (write + fsync)
+#define LB_BATCH 64
+// Новых счетов до слияния с отсортированным индексом
+#define LB_TAIL_MAX 4096
+// Файлы хранилища в его каталоге: журнал результатов и индекс счетов
+#define LB_LOG_FILE "results.log"
+#define LB_INDEX_FILE "scores.idx"
+// Признак файла индекса
+#define LB_INDEX_MAGIC 0x31584449424c3132ULL
+
+/// @brief Результат законченной игры (запись журнала)
+typedef struct {
+  /// Имя игрока
+  char player[LB_NAME_SIZE];
+  /// Начальное состояние генератора фигур
+  unsigned int seed;
+  /// Очки, удаленные строки, уровень
+  int score;
+  int lines;
+  int level;
+  /// Длительность игры, мс
+  long long duration_ms;
+} lb_result_t;
+
+/// @brief Игрок: лучший результат и количество игр
+typedef struct {
+  lb_result_t best;
+  long long games;
+  bool used;
+} lb_player_t;
+
+/// @brief Хранилище результатов
+typedef struct {
+  /// Пути журнала и индекса
+  char *log_path;
+  char *index_path;
+  /// Журнал, открытый на дозапись
+  int log_fd;
+  /// Защита всех полей (хранилище общее для потоков сервера)
+  pthread_mutex_t lock;
+  /// Результатов в журнале, включая еще не записанные
+  long long count;
+  /// Результаты, ожидающие записи на диск
+  lb_result_t batch[LB_BATCH];
+  int batch_count;
+  /// Байт пачки, уже записанных в журнал (при ошибке записи)
+  size_t batch_written;
+  /// Лучшие результаты: куча с минимальным счетом в вершине
+  lb_result_t top[LB_TOP_K];
+  int top_count;
+  /// Игроки: хеш-таблица с открытой адресацией по имени
+  lb_player_t *players;
+  int players_size;
+  int players_count;
+  /// Счета всех игр: отсортированная часть и новые (не отсортированные)
+  int *sorted;
+  long long sorted_count;
+  long long sorted_size;
+  int tail[LB_TAIL_MAX];
+  int tail_count;
+  /// Результатов журнала, учтенных в индексе на диске
+  long long index_count;
+} leaderboard_t;
+
+/// @brief Открытие хранилища в отдельном потоке (lbOpenStart, lbOpenWait)
+typedef struct {
+  /// Каталог хранилища
+  const char *dir;
+  /// Открытое хранилище или NULL
+  leaderboard_t *lb;
+  /// Поток открытия и признак его запуска
+  pthread_t thread;
+  bool started;
+} lb_pending_t;
+
+leaderboard_t *lbOpen(const char *dir);
+void lbOpenStart(lb_pending_t *pending, const char *dir);
+leaderboard_t *lbOpenWait(lb_pending_t *pending);
+int lbAdd(leaderboard_t *lb, const lb_result_t *result);
+int lbFlush(leaderboard_t *lb);
+int lbTop(leaderboard_t *lb, lb_result_t *out, int k);
+int lbPlayerBest(leaderboard_t *lb, const char *player, lb_result_t *best,
+                 long long *games);
+double lbPercentile(leaderboard_t *lb, int score);
+long long lbCount(leaderboard_t *lb);
+int lbClose(leaderboard_t *lb);
+void lbResultFromEngine(const engine_t *engine, const char *player,
+                        lb_result_t *result);
+
+#endif  // TETRIS_LEADERBOARD_H
@@ -0,0 +1,276 @@
+/**
+ * @file s21_tetris_lib.c
+ * @brief Реализация C ABI библиотеки libtetris.so поверх engine_t.
+ */
+#include "s21_tetris_lib.h"
+
+#include "s21_tetris_board.h"
+#include "s21_tetris_bot.h"
+#include "s21_tetris_fsm.h"
+
+_Static_assert(TETRIS_ROWS == FIELD_ROWS, "TETRIS_ROWS != FIELD_ROWS");
+_Static_assert(TETRIS_COLUMNS == FIELD_COLUMNS,
+               "TETRIS_COLUMNS != FIELD_COLUMNS");
+_Static_assert(TETRIS_NEXT_CELLS == PIECE_ROWS * PIECE_COLUMNS,
+               "TETRIS_NEXT_CELLS != PIECE_ROWS * PIECE_COLUMNS");
+_Static_assert(TETRIS_ACTION_ACTION == Action &&
+                   TETRIS_ACTION_ACTION_CCW == ActionCCW &&
+                   TETRIS_ACTION_HOLD == Hold,
+               "TETRIS_ACTION_* != UserAction_t");
+_Static_assert(TETRIS_STATE_GAMEOVER == GAMEOVER &&
+                   TETRIS_STATE_EXIT == EXIT_STATE,
+               "TETRIS_STATE_* != tetris_state");
+_Static_assert(TETRIS_BOARD_GENERIC == BOARD_GENERIC &&
+                   TETRIS_BOARD_STANDARD == BOARD_STANDARD,
+               "TETRIS_BOARD_* != board_kind");
+
+/// @brief Игра, доступная снаружи библиотеки только по указателю
+struct TetrisEngine {
+  /// Состояние игры
+  engine_t engine;
+  /// Бот (создается при первом tetrisEngineBotStep)
+  bot_t *bot;
+};
+
+/**
+ * @brief Создание новой игры. Игра сразу запускается (как после Enter).
+ * Реализация операций с полем выбирается как для TETRIS_BOARD_AUTO.
+ * @param seed Начальное значение генератора фигур.
+ * @return Указатель на игру или NULL при ошибке выделения памяти.
+ */
+TetrisEngine_t *tetrisEngineCreate(unsigned int seed) {
+  TetrisEngine_t *res = (TetrisEngine_t *)calloc(1, sizeof(TetrisEngine_t));
+  if (res != NULL) {
+    tetrisAllocate(&res->engine.game_info, &res->engine.addinfo);
+    if (res->engine.game_info.pause == EXIT_MODE) {
+      tetrisDestroy(&res->engine.game_info, &res->engine.addinfo);
+      free(res);
+      res = NULL;
+    } else {
+      res->engine.board = boardSelect(BOARD_AUTO);
+      metricsRegister(&res->engine.metrics);
+      tetrisEngineReset(res, seed);
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Сброс игры в начало и запуск новой партии.
+ *
+ * Из любого состояния игра переводится в START и запускается как по Enter:
+ * значения новой партии сбрасывает переход START -> SPAWN (tetrisInit).
+ * @param engine Игра.
+ * @param seed Начальное значение генератора фигур. При одинаковом seed
+ * одинаковые последовательности действий дают одинаковые партии.
+ * @return Состояние FSM после запуска (tetris_state).
+ */
+int tetrisEngineReset(TetrisEngine_t *engine, unsigned int seed) {
+  engine->engine.addinfo.seed = seed;
+  engine->engine.state = START;
+  engineInput(&engine->engine, Start, false);
+  return engine->engine.state;
+}
+
+/**
+ * @brief Выбор реализации операций с полем (горячего цикла игры).
+ *
+ * Реализации дают одинаковые партии, поэтому выбор возможен в любой момент
+ * (например, для сравнения их скорости на одной нагрузке).
+ * @param engine Игра.
+ * @param board TETRIS_BOARD_AUTO - специализированная для поля 10x20, если
+ * она собрана и в окружении нет TETRIS_BOARD=generic; TETRIS_BOARD_GENERIC
+ * - общая; TETRIS_BOARD_STANDARD - специализированная, если собрана.
+ * @return Выбранная реализация (TETRIS_BOARD_GENERIC или
+ * TETRIS_BOARD_STANDARD) или -1 для неизвестного значения.
+ */
+int tetrisEngineSetBoard(TetrisEngine_t *engine, int board) {
+  int res = -1;
+  if (board >= BOARD_AUTO && board <= BOARD_STANDARD) {
+    engine->engine.board = boardSelect((board_kind)board);
+    res = engine->engine.board == &board_generic ? BOARD_GENERIC
+                                                 : BOARD_STANDARD;
+  }
+  return res;
+}
+
+/**
+ * @brief Адаптивная сложность: скорость падения и веса выбора фигур
+ * подстраиваются по навыку игрока. Действует со следующей игры
+ * (tetrisEngineReset или Start после конца игры).
+ * @param engine Игра.
+ * @param enabled 0 - выключена (по умолчанию), иначе включена.
+ * @return 0.
+ */
+int tetrisEngineSetAdaptive(TetrisEngine_t *engine, int enabled) {
+  engine->engine.adaptive.enabled = enabled != 0;
+  return SUCCESSFUL_EXIT;
+}
+
+/**
+ * @brief Один шаг игры.
+ * @param engine Игра.
+ * @param action Действие (TETRIS_ACTION_*).
+ * @param hold Для TETRIS_ACTION_DOWN: 0 - сдвиг по таймеру, иначе падение.
+ * Для остальных действий игнорируется (создание и удаление массивов
+ * выполняются только через Create / Destroy).
+ * @return Состояние FSM после шага или -1 для неизвестного действия.
+ */
+int tetrisEngineStep(TetrisEngine_t *engine, int action, int hold) {
+  int res = -1;
+  if (action >= Start && action <= Hold) {
+    engineInput(&engine->engine, (UserAction_t)action,
+                action == Down && hold);
+    res = engine->engine.state;
+  }
+  return res;
+}
+
+/**
+ * @brief Выполнение последовательности шагов за один вызов.
+ *
+ * Останавливается, если игра перешла в GAMEOVER или EXIT_STATE.
+ * @param engine Игра.
+ * @param actions Массив действий длины count.
+ * @param holds Массив уточнений длины count или NULL (все 0).
+ * @param count Количество шагов.
+ * @return Количество выполненных шагов.
+ */
+int tetrisEngineStepBatch(TetrisEngine_t *engine, const int *actions,
+                          const int *holds, int count) {
+  int done = 0;
+  int stop = 0;
+  while (done < count && !stop) {
+    int state =
+        tetrisEngineStep(engine, actions[done], holds ? holds[done] : 0);
+    done++;
+    if (state == GAMEOVER || state == EXIT_STATE) stop = 1;
+  }
+  return done;
+}
+
+/**
+ * @brief Нажатие или отпускание клавиши с автоповтором.
+ * @param engine Игра.
+ * @param action TETRIS_ACTION_LEFT / RIGHT - сдвиг с автоповтором,
+ * TETRIS_ACTION_DOWN - мягкое падение; остальные действия выполняются при
+ * нажатии (Start, Terminate - без создания и удаления массивов).
+ * @param pressed 0 - отпускание, иначе нажатие.
+ * @return Состояние FSM после нажатия или -1 для неизвестного действия.
+ */
+int tetrisEngineKey(TetrisEngine_t *engine, int action, int pressed) {
+  int res = -1;
+  if (action >= Start && action <= Hold) {
+    engineKey(&engine->engine, (UserAction_t)action, pressed != 0);
+    res = engine->engine.state;
+  }
+  return res;
+}
+
+/**
+ * @brief Шаги времени игры (1/60 с каждый): автоповтор нажатых клавиш,
+ * мягкое падение, гравитация по скорости игры, задержка фиксации.
+ * @param engine Игра.
+ * @param ticks Количество шагов.
+ * @return Состояние FSM после шагов.
+ */
+int tetrisEngineTick(TetrisEngine_t *engine, int ticks) {
+  engineTick(&engine->engine, ticks);
+  return engine->engine.state;
+}
+
+/**
+ * @brief Один шаг игры, действие для которого выбирает бот.
+ * @param engine Игра.
+ * @param budget_us Время бота на планирование новой фигуры, мкс.
+ * @return Состояние FSM после шага (если игра не в MOVING - без изменений)
+ * или -1 при ошибке выделения памяти под бота.
+ */
+int tetrisEngineBotStep(TetrisEngine_t *engine, int budget_us) {
+  int res = -1;
+  if (engine->bot == NULL) engine->bot = botCreate(0);
+  if (engine->bot != NULL) {
+    bool hold;
+    engine->bot->budget_ns = budget_us * 1000LL;
+    UserAction_t action = botAction(engine->bot, &engine->engine, &hold);
+    if (action != Up) engineInput(&engine->engine, action, hold);
+    res = engine->engine.state;
+  }
+  return res;
+}
+
+/**
+ * @brief Копирование состояния игры в буферы вызывающей стороны.
+ * @param engine Игра.
+ * @param field Буфер на TETRIS_FIELD_CELLS int (по строкам) или NULL.
+ * @param next Буфер на TETRIS_NEXT_CELLS int (по строкам) или NULL.
+ * @param stats Буфер на TETRIS_STAT_COUNT int или NULL.
+ */
+void tetrisEngineObserve(const TetrisEngine_t *engine, int *field, int *next,
+                         int *stats) {
+  const GameInfo_t *game_info = &engine->engine.game_info;
+  // Массивы матриц непрерывные (createMatrix), копируются целиком
+  if (field != NULL) {
+    const cell_t *src = game_info->field[0];
+    for (int i = 0; i < TETRIS_FIELD_CELLS; i++) field[i] = src[i];
+  }
+  if (next != NULL) {
+    // Следующая фигура хранится id, шаблон берется из таблицы фигур
+    const addinfo_t *fsm_addinfo = &engine->engine.addinfo;
+    int mask = pieceMask(fsm_addinfo->next_id, fsm_addinfo->next_rot_id);
+    for (int i = 0; i < TETRIS_NEXT_CELLS; i++)
+      next[i] = (mask >> i) & 1 ? fsm_addinfo->next_id + 1 : 0;
+  }
+  if (stats != NULL) {
+    stats[TETRIS_STAT_SCORE] = game_info->score;
+    stats[TETRIS_STAT_HIGH_SCORE] = game_info->high_score;
+    stats[TETRIS_STAT_LEVEL] = game_info->level;
+    stats[TETRIS_STAT_SPEED] = game_info->speed;
+    stats[TETRIS_STAT_PAUSE] = game_info->pause;
+    stats[TETRIS_STAT_STATE] = engine->engine.state;
+  }
+}
+
+/**
+ * @brief Хеш Зобриста заполнения поля (включая текущую фигуру).
+ *
+ * Дешевый отпечаток поля для сверки повторов и обнаружения расхождений:
+ * одинаковые поля дают одинаковый хеш в любом процессе.
+ */
+unsigned long long tetrisEngineHash(const TetrisEngine_t *engine) {
+  return engine->engine.game_info.hash;
+}
+
+/**
+ * @brief Память одной игры без бота: структура игры и массивы поля и
+ * фигур, байт.
+ */
+int tetrisEngineMemory(void) {
+  return (int)(sizeof(TetrisEngine_t) - sizeof(engine_t) + engineMemory());
+}
+
+/**
+ * @brief Монотонное время, нс: те же часы, что у метрик и замеров игры,
+ * для замеров на стороне вызывающего (бенчмарки).
+ */
+long long tetrisNow(void) { return metricsNow(); }
+
+/**
+ * @brief Запись метрик всех игр процесса в файл (формат Prometheus).
+ * @return 0 - успешно, 1 - ошибка записи.
+ */
+int tetrisMetricsExport(const char *path) {
+  return metricsWritePrometheus(path);
+}
+
+/**
+ * @brief Удаление игры и освобождение памяти.
+ */
+void tetrisEngineDestroy(TetrisEngine_t *engine) {
+  if (engine != NULL) {
+    metricsUnregister(&engine->engine.metrics);
+    botDestroy(engine->bot);
+    tetrisDestroy(&engine->engine.game_info, &engine->engine.addinfo);
+    free(engine);
+  }
+}
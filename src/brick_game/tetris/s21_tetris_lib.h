@@ -0,0 +1,83 @@
+/**
+ * @file s21_tetris_lib.h
+ * @brief C ABI библиотеки libtetris.so для управления игрой извне (Python
+ * ctypes, стенды, бенчмарки).
+ *
+ * Заголовок самодостаточный: только int, unsigned int и указатели, без
+ * структур и enum, чтобы его можно было описать в ctypes один к одному.
+ * Игра доступна через непрозрачный указатель, наблюдения пишутся в буферы
+ * вызывающей стороны, поэтому на шаге игры нет выделений памяти и копий.
+ */
+#ifndef TETRIS_LIB_H
+#define TETRIS_LIB_H
+
+#if defined(__GNUC__)
+#define TETRIS_API __attribute__((visibility("default")))
+#else
+#define TETRIS_API
+#endif
+
+// Размеры буферов наблюдения (в int)
+#define TETRIS_ROWS 20
+#define TETRIS_COLUMNS 10
+#define TETRIS_FIELD_CELLS (TETRIS_ROWS * TETRIS_COLUMNS)
+#define TETRIS_NEXT_CELLS 16
+
+// Индексы в буфере статистики
+#define TETRIS_STAT_SCORE 0
+#define TETRIS_STAT_HIGH_SCORE 1
+#define TETRIS_STAT_LEVEL 2
+#define TETRIS_STAT_SPEED 3
+#define TETRIS_STAT_PAUSE 4
+#define TETRIS_STAT_STATE 5
+#define TETRIS_STAT_COUNT 6
+
+// Действия (совпадают с UserAction_t)
+#define TETRIS_ACTION_START 0
+#define TETRIS_ACTION_PAUSE 1
+#define TETRIS_ACTION_TERMINATE 2
+#define TETRIS_ACTION_LEFT 3
+#define TETRIS_ACTION_RIGHT 4
+#define TETRIS_ACTION_UP 5
+#define TETRIS_ACTION_DOWN 6
+#define TETRIS_ACTION_ACTION 7
+#define TETRIS_ACTION_ACTION_CCW 8
+#define TETRIS_ACTION_HOLD 9
+
+// Состояния FSM (совпадают с tetris_state)
+#define TETRIS_STATE_START 0
+#define TETRIS_STATE_SPAWN 1
+#define TETRIS_STATE_MOVING 2
+#define TETRIS_STATE_ATTACHING 3
+#define TETRIS_STATE_PAUSE 4
+#define TETRIS_STATE_GAMEOVER 5
+#define TETRIS_STATE_EXIT 6
+
+// Реализации операций с полем (совпадают с board_kind)
+#define TETRIS_BOARD_AUTO 0
+#define TETRIS_BOARD_GENERIC 1
+#define TETRIS_BOARD_STANDARD 2
+
+/// Непрозрачный указатель на игру
+typedef struct TetrisEngine TetrisEngine_t;
+
+TETRIS_API TetrisEngine_t *tetrisEngineCreate(unsigned int seed);
+TETRIS_API int tetrisEngineReset(TetrisEngine_t *engine, unsigned int seed);
+TETRIS_API int tetrisEngineSetBoard(TetrisEngine_t *engine, int board);
+TETRIS_API int tetrisEngineSetAdaptive(TetrisEngine_t *engine, int enabled);
+TETRIS_API int tetrisEngineStep(TetrisEngine_t *engine, int action, int hold);
+TETRIS_API int tetrisEngineStepBatch(TetrisEngine_t *engine, const int *actions,
+                                     const int *holds, int count);
+TETRIS_API int tetrisEngineKey(TetrisEngine_t *engine, int action,
+                               int pressed);
+TETRIS_API int tetrisEngineTick(TetrisEngine_t *engine, int ticks);
+TETRIS_API int tetrisEngineBotStep(TetrisEngine_t *engine, int budget_us);
+TETRIS_API void tetrisEngineObserve(const TetrisEngine_t *engine, int *field,
+                                    int *next, int *stats);
+TETRIS_API unsigned long long tetrisEngineHash(const TetrisEngine_t *engine);
+TETRIS_API int tetrisEngineMemory(void);
+TETRIS_API long long tetrisNow(void);
+TETRIS_API void tetrisEngineDestroy(TetrisEngine_t *engine);
+TETRIS_API int tetrisMetricsExport(const char *path);
+
+#endif  // TETRIS_LIB_H
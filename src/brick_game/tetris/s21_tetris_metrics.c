@@ -0,0 +1,265 @@
+/**
+ * @file s21_tetris_metrics.c
+ * @brief Метрики игр: счетчики удалений строк, фигур, уровней, длительности
+ * игр, ввода и задержки шага FSM. Экспорт в текстовом формате Prometheus.
+ *
+ * Счетчики хранятся в каждой игре (engine_t) и обновляются без блокировок.
+ * Игры регистрируются в общем списке, по запросу счетчики суммируются.
+ * Мьютекс защищает только список игр (регистрация, суммирование), но не
+ * обновление счетчиков.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include "s21_tetris_metrics.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// Верхние границы интервалов задержки шага FSM, нс
+static const long long latency_bounds[METRICS_LATENCY_BUCKETS - 1] = {
+    250, 500, 1000, 2500, 5000, 10000, 25000, 100000};
+/// Верхние границы интервалов длительности игры, с
+static const long long duration_bounds[METRICS_DURATION_BUCKETS - 1] = {
+    15, 30, 60, 120, 300, 600, 1800};
+/// Названия типов удаления строк
+static const char *clear_names[PIECE_ROWS + 1] = {"", "single", "double",
+                                                  "triple", "tetris"};
+/// Названия фигур по id
+static const char *piece_names[PIECE_TYPES] = {"O", "I", "Z", "S",
+                                               "J", "L", "T"};
+
+/// Список зарегистрированных игр (растет по мере необходимости)
+static metrics_t **registry = NULL;
+static int registry_count = 0;
+static int registry_capacity = 0;
+/// Игры, не попавшие в список (нет памяти на его рост)
+static unsigned long long registry_dropped = 0;
+/// Счетчики уже удаленных игр (чтобы суммы не уменьшались)
+static metrics_t retired;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+/// Для расчета ввода в секунду между экспортами
+static unsigned long long last_inputs = 0;
+static long long last_export_ns = 0;
+
+/**
+ * @brief Монотонное время в наносекундах.
+ */
+long long metricsNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Номер интервала гистограммы для значения.
+ */
+static int bucketIndex(const long long *bounds, int count, long long value) {
+  int i = 0;
+  while (i < count && value > bounds[i]) i++;
+  return i;
+}
+
+/**
+ * @brief Прибавление всех счетчиков src к dst.
+ */
+static void metricsAccumulate(metrics_t *dst, metrics_t *src) {
+  for (int i = 0; i <= PIECE_ROWS; i++)
+    metricsAdd(&dst->clears[i], src->clears[i]);
+  for (int i = 0; i < PIECE_TYPES; i++)
+    metricsAdd(&dst->pieces[i], src->pieces[i]);
+  metricsAdd(&dst->level_ups, src->level_ups);
+  metricsAdd(&dst->games_started, src->games_started);
+  for (int i = 0; i < METRICS_DURATION_BUCKETS; i++)
+    metricsAdd(&dst->game_duration[i], src->game_duration[i]);
+  metricsAdd(&dst->game_duration_ms, src->game_duration_ms);
+  metricsAdd(&dst->inputs, src->inputs);
+  for (int i = 0; i < METRICS_LATENCY_BUCKETS; i++)
+    metricsAdd(&dst->step_latency[i], src->step_latency[i]);
+  metricsAdd(&dst->step_latency_ns, src->step_latency_ns);
+}
+
+/**
+ * @brief Добавление игры в общий список. Если памяти на рост списка нет,
+ * счетчики игры ведутся, но в сумму не попадают (такие игры считаются в
+ * tetris_metrics_dropped_engines_total).
+ */
+void metricsRegister(metrics_t *metrics) {
+  pthread_mutex_lock(&registry_lock);
+  if (registry_count == registry_capacity) {
+    int capacity =
+        registry_capacity ? 2 * registry_capacity : METRICS_REGISTRY_MIN;
+    metrics_t **grown =
+        (metrics_t **)realloc(registry, capacity * sizeof(metrics_t *));
+    if (grown != NULL) {
+      registry = grown;
+      registry_capacity = capacity;
+    }
+  }
+  if (registry_count < registry_capacity) {
+    registry[registry_count++] = metrics;
+    metrics->registry_slot = registry_count;
+  } else {
+    metrics->registry_slot = 0;
+    registry_dropped++;
+  }
+  pthread_mutex_unlock(&registry_lock);
+}
+
+/**
+ * @brief Удаление игры из общего списка. Ее счетчики переносятся в сумму
+ * удаленных игр, место в списке занимает последняя игра.
+ */
+void metricsUnregister(metrics_t *metrics) {
+  pthread_mutex_lock(&registry_lock);
+  int i = metrics->registry_slot - 1;
+  if (i >= 0 && i < registry_count && registry[i] == metrics) {
+    registry[i] = registry[--registry_count];
+    registry[i]->registry_slot = i + 1;
+    metrics->registry_slot = 0;
+    metricsAccumulate(&retired, metrics);
+  }
+  pthread_mutex_unlock(&registry_lock);
+}
+
+/**
+ * @brief Начало новой игры.
+ */
+void metricsGameStart(metrics_t *metrics) {
+  metrics->game_start_ns = metricsNow();
+  metricsAdd(&metrics->games_started, 1);
+}
+
+/**
+ * @brief Окончание игры: учет ее длительности.
+ */
+void metricsGameEnd(metrics_t *metrics) {
+  long long ms = (metricsNow() - metrics->game_start_ns) / 1000000;
+  int i = bucketIndex(duration_bounds, METRICS_DURATION_BUCKETS - 1,
+                      ms / 1000);
+  metricsAdd(&metrics->game_duration[i], 1);
+  metricsAdd(&metrics->game_duration_ms, (unsigned long long)ms);
+}
+
+/**
+ * @brief Учет задержки одного шага FSM.
+ */
+void metricsStepLatency(metrics_t *metrics, long long ns) {
+  int i = bucketIndex(latency_bounds, METRICS_LATENCY_BUCKETS - 1, ns);
+  metricsAdd(&metrics->step_latency[i], 1);
+  metricsAdd(&metrics->step_latency_ns, (unsigned long long)ns);
+}
+
+/**
+ * @brief Сумма счетчиков всех игр, включая уже удаленные.
+ * @param total Результат (перезаписывается).
+ * @return Количество зарегистрированных игр.
+ */
+int metricsAggregate(metrics_t *total) {
+  memset(total, 0, sizeof(metrics_t));
+  pthread_mutex_lock(&registry_lock);
+  metricsAccumulate(total, &retired);
+  for (int i = 0; i < registry_count; i++)
+    metricsAccumulate(total, registry[i]);
+  int engines = registry_count;
+  pthread_mutex_unlock(&registry_lock);
+  return engines;
+}
+
+/**
+ * @brief Печать гистограммы в формате Prometheus (интервалы накопительные).
+ */
+static void printHistogram(FILE *file, const char *name,
+                           const long long *bounds, double scale,
+                           atomic_ullong *buckets, int count, double sum) {
+  unsigned long long cumulative = 0;
+  for (int i = 0; i < count; i++) {
+    cumulative += buckets[i];
+    if (i < count - 1) {
+      fprintf(file, "%s_bucket{le=\"%g\"} %llu\n", name, bounds[i] * scale,
+              cumulative);
+    } else {
+      fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", name, cumulative);
+    }
+  }
+  fprintf(file, "%s_sum %g\n%s_count %llu\n", name, sum, name, cumulative);
+}
+
+/**
+ * @brief Запись суммы метрик всех игр в файл в текстовом формате Prometheus.
+ *
+ * Файл пишется во временный и затем переименовывается, чтобы читатель
+ * (node_exporter textfile collector и т.п.) не увидел его частично.
+ * @param path Путь к файлу метрик.
+ * @return 0 - успешно, 1 - ошибка записи.
+ */
+int metricsWritePrometheus(const char *path) {
+  int res = SUCCESSFUL_EXIT;
+  metrics_t total;
+  int engines = metricsAggregate(&total);
+  long long now = metricsNow();
+  double inputs_rate = 0;
+  pthread_mutex_lock(&registry_lock);
+  if (last_export_ns != 0 && now > last_export_ns) {
+    inputs_rate = (total.inputs - last_inputs) * 1e9 / (now - last_export_ns);
+  }
+  last_inputs = total.inputs;
+  last_export_ns = now;
+  unsigned long long dropped = registry_dropped;
+  pthread_mutex_unlock(&registry_lock);
+
+  char tmp_path[4096];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  FILE *file = fopen(tmp_path, "w");
+  if (file == NULL) {
+    res = FAILURE_EXIT;
+  } else {
+    fprintf(file, "# HELP tetris_engines Games currently running.\n");
+    fprintf(file, "# TYPE tetris_engines gauge\ntetris_engines %d\n", engines);
+    fprintf(file, "# HELP tetris_metrics_dropped_engines_total Games left "
+                  "out of the metrics (out of memory).\n");
+    fprintf(file, "# TYPE tetris_metrics_dropped_engines_total counter\n");
+    fprintf(file, "tetris_metrics_dropped_engines_total %llu\n", dropped);
+    fprintf(file, "# HELP tetris_line_clears_total Line clears by type.\n");
+    fprintf(file, "# TYPE tetris_line_clears_total counter\n");
+    for (int i = 1; i <= PIECE_ROWS; i++)
+      fprintf(file, "tetris_line_clears_total{type=\"%s\"} %llu\n",
+              clear_names[i], (unsigned long long)total.clears[i]);
+    fprintf(file, "# HELP tetris_pieces_spawned_total Pieces by type.\n");
+    fprintf(file, "# TYPE tetris_pieces_spawned_total counter\n");
+    for (int i = 0; i < PIECE_TYPES; i++)
+      fprintf(file, "tetris_pieces_spawned_total{piece=\"%s\"} %llu\n",
+              piece_names[i], (unsigned long long)total.pieces[i]);
+    fprintf(file, "# HELP tetris_level_ups_total Level increases.\n");
+    fprintf(file, "# TYPE tetris_level_ups_total counter\n");
+    fprintf(file, "tetris_level_ups_total %llu\n",
+            (unsigned long long)total.level_ups);
+    fprintf(file, "# HELP tetris_games_started_total Games started.\n");
+    fprintf(file, "# TYPE tetris_games_started_total counter\n");
+    fprintf(file, "tetris_games_started_total %llu\n",
+            (unsigned long long)total.games_started);
+    fprintf(file, "# HELP tetris_game_duration_seconds Finished games.\n");
+    fprintf(file, "# TYPE tetris_game_duration_seconds histogram\n");
+    printHistogram(file, "tetris_game_duration_seconds", duration_bounds, 1,
+                   total.game_duration, METRICS_DURATION_BUCKETS,
+                   total.game_duration_ms / 1e3);
+    fprintf(file, "# HELP tetris_inputs_total Inputs accepted by the FSM.\n");
+    fprintf(file, "# TYPE tetris_inputs_total counter\n");
+    fprintf(file, "tetris_inputs_total %llu\n",
+            (unsigned long long)total.inputs);
+    fprintf(file, "# HELP tetris_inputs_per_second Since previous export.\n");
+    fprintf(file, "# TYPE tetris_inputs_per_second gauge\n");
+    fprintf(file, "tetris_inputs_per_second %.3f\n", inputs_rate);
+    fprintf(file, "# HELP tetris_fsm_step_latency_seconds FSM step latency "
+                  "(every %d-th step).\n",
+            METRICS_SAMPLE_PERIOD);
+    fprintf(file, "# TYPE tetris_fsm_step_latency_seconds histogram\n");
+    printHistogram(file, "tetris_fsm_step_latency_seconds", latency_bounds,
+                   1e-9, total.step_latency, METRICS_LATENCY_BUCKETS,
+                   total.step_latency_ns / 1e9);
+    if (fclose(file) != 0 || rename(tmp_path, path) != 0) res = FAILURE_EXIT;
+  }
+  return res;
+}
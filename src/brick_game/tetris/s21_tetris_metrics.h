@@ -0,0 +1,63 @@
+#ifndef TETRIS_METRICS_H
+#define TETRIS_METRICS_H
+
+#include <stdatomic.h>
+
+#include "../../gui/cli/s21_define.h"
+
+// Количество типов фигур
+#define PIECE_TYPES 7
+// Начальный размер списка игр (дальше список растет вдвое)
+#define METRICS_REGISTRY_MIN 64
+// Замер задержки шага FSM - каждый METRICS_SAMPLE_PERIOD-й шаг
+#define METRICS_SAMPLE_PERIOD 64
+// Количество интервалов гистограмм (последний - +Inf)
+#define METRICS_LATENCY_BUCKETS 9
+#define METRICS_DURATION_BUCKETS 8
+
+/// @brief Счетчики одной игры.
+///
+/// Пишет только поток, который ведет игру (атомарно, без блокировок),
+/// читать можно из любого потока через metricsAggregate.
+typedef struct {
+  /// Удаления строк по типу: [1] - single ... [4] - tetris
+  atomic_ullong clears[PIECE_ROWS + 1];
+  /// Появившиеся фигуры по id
+  atomic_ullong pieces[PIECE_TYPES];
+  /// Повышения уровня
+  atomic_ullong level_ups;
+  /// Начатые игры
+  atomic_ullong games_started;
+  /// Длительность законченных игр: интервалы, сумма в мс
+  atomic_ullong game_duration[METRICS_DURATION_BUCKETS];
+  atomic_ullong game_duration_ms;
+  /// Действия пользователя (и таймера), принятые FSM
+  atomic_ullong inputs;
+  /// Задержка шага FSM (выборка): интервалы, сумма в нс
+  atomic_ullong step_latency[METRICS_LATENCY_BUCKETS];
+  atomic_ullong step_latency_ns;
+  /// Время начала текущей игры, нс (только для потока игры)
+  long long game_start_ns;
+  /// Номер игры в общем списке + 1, 0 - не в списке (под блокировкой
+  /// списка)
+  int registry_slot;
+} metrics_t;
+
+/// @brief Добавление к счетчику. Писатель у счетчика один, поэтому
+/// достаточно атомарных чтения и записи без блокирующих операций.
+static inline void metricsAdd(atomic_ullong *counter, unsigned long long n) {
+  atomic_store_explicit(
+      counter, atomic_load_explicit(counter, memory_order_relaxed) + n,
+      memory_order_relaxed);
+}
+
+long long metricsNow();
+void metricsRegister(metrics_t *metrics);
+void metricsUnregister(metrics_t *metrics);
+void metricsGameStart(metrics_t *metrics);
+void metricsGameEnd(metrics_t *metrics);
+void metricsStepLatency(metrics_t *metrics, long long ns);
+int metricsAggregate(metrics_t *total);
+int metricsWritePrometheus(const char *path);
+
+#endif  // TETRIS_METRICS_H
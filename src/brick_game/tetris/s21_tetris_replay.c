@@ -0,0 +1,238 @@
+/**
+ * @file s21_tetris_replay.c
+ * @brief Журнал ввода игр: запись на границе userInput / userKey /
+ * userTick, чтение через отображение файла в память и повтор игры.
+ *
+ * Журнал - последовательность записей игр: заголовок replay_game_t (seed
+ * и количество событий) и события replay_event_t. Игра определяется seed и
+ * событиями полностью, поэтому повтор на новой игре (replayStart,
+ * replayApply) дает те же фигуры, поле и счет. Запись игры дописывается в
+ * файл целиком по ее окончании; недописанная запись в конце файла (падение
+ * процесса) при чтении пропускается.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "s21_tetris_replay.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "s21_tetris_fsm.h"
+
+/**
+ * @brief Открытие журнала на дозапись.
+ * @return Запись журнала или NULL при ошибке.
+ */
+replay_recorder_t *replayRecorderOpen(const char *path) {
+  replay_recorder_t *recorder = calloc(1, sizeof(replay_recorder_t));
+  if (recorder != NULL) {
+    recorder->file = fopen(path, "ab");
+    recorder->events = malloc(REPLAY_EVENTS_INIT * sizeof(replay_event_t));
+    recorder->size = REPLAY_EVENTS_INIT;
+    if (recorder->file == NULL || recorder->events == NULL) {
+      if (recorder->file != NULL) fclose(recorder->file);
+      free(recorder->events);
+      free(recorder);
+      recorder = NULL;
+    }
+  }
+  return recorder;
+}
+
+/**
+ * @brief Запись текущей игры в файл.
+ */
+static void replayWriteGame(replay_recorder_t *recorder) {
+  size_t count = recorder->game.count;
+  if (fwrite(&recorder->game, sizeof(replay_game_t), 1, recorder->file) != 1 ||
+      fwrite(recorder->events, sizeof(replay_event_t), count,
+             recorder->file) != count ||
+      fflush(recorder->file) != 0)
+    recorder->error = true;
+  recorder->active = false;
+}
+
+/**
+ * @brief Добавление события в текущую игру. При ошибке выделения памяти
+ * игра не записывается (без части событий ее нельзя повторить).
+ */
+static void replayAppend(replay_recorder_t *recorder, replay_kind kind,
+                         UserAction_t action, int value) {
+  // Подряд идущие шаги времени записываются одним событием
+  replay_event_t *last =
+      recorder->game.count ? &recorder->events[recorder->game.count - 1] : NULL;
+  if (kind == REPLAY_TICK && last != NULL && last->kind == REPLAY_TICK &&
+      last->value + value <= 0xFFFF) {
+    last->value += value;
+    return;
+  }
+  if (recorder->game.count == recorder->size) {
+    replay_event_t *events = realloc(
+        recorder->events, 2 * recorder->size * sizeof(replay_event_t));
+    if (events == NULL) {
+      recorder->error = true;
+      recorder->active = false;
+      return;
+    }
+    recorder->events = events;
+    recorder->size *= 2;
+  }
+  replay_event_t *event = &recorder->events[recorder->game.count++];
+  long long elapsed = metricsNow() - recorder->start_ns;
+  event->time_ms = (unsigned int)(elapsed / 1000000);
+  event->kind = (unsigned char)kind;
+  event->action = (unsigned char)action;
+  event->value = (unsigned short)value;
+}
+
+/**
+ * @brief Запись события, уже переданного игре engine.
+ *
+ * Запись игры начинается с ее старта (Start в START) и заканчивается
+ * переходом в GAMEOVER (или выходом из игры). Сам Start не записывается:
+ * повтор начинается с уже запущенной игры (replayStart).
+ * @param recorder Запись журнала или NULL (ничего не делается).
+ * @param engine Игра после обработки события.
+ * @param kind Тип события.
+ * @param action Действие (клавиша).
+ * @param value hold / pressed / количество шагов времени.
+ */
+void replayRecord(replay_recorder_t *recorder, const engine_t *engine,
+                  replay_kind kind, UserAction_t action, int value) {
+  if (recorder == NULL) return;
+  if (recorder->active) replayAppend(recorder, kind, action, value);
+  bool playing = engine->state != START && engine->state != GAMEOVER &&
+                 engine->state != EXIT_STATE;
+  if (recorder->active && !playing) {
+    if (engine->state == GAMEOVER) recorder->game.flags |= REPLAY_FINISHED;
+    replayWriteGame(recorder);
+  } else if (!recorder->active && playing && kind == REPLAY_INPUT &&
+             action == Start) {
+    recorder->game.magic = REPLAY_MAGIC;
+    recorder->game.seed = engine->game_seed;
+    recorder->game.count = 0;
+    recorder->game.flags = engine->adaptive.active ? REPLAY_ADAPTIVE : 0;
+    recorder->start_ns = metricsNow();
+    recorder->active = true;
+  }
+}
+
+/**
+ * @brief Закрытие журнала. Незаконченная игра записывается без флага
+ * REPLAY_FINISHED.
+ * @return 0 - успешно, 1 - была ошибка записи.
+ */
+int replayRecorderClose(replay_recorder_t *recorder) {
+  int res = SUCCESSFUL_EXIT;
+  if (recorder != NULL) {
+    if (recorder->active) replayWriteGame(recorder);
+    if (fclose(recorder->file) != 0) recorder->error = true;
+    res = recorder->error ? FAILURE_EXIT : SUCCESSFUL_EXIT;
+    free(recorder->events);
+    free(recorder);
+  }
+  return res;
+}
+
+/**
+ * @brief Отображение журнала в память и построение индекса записей игр.
+ *
+ * Читаются только заголовки: запись следующей игры находится по количеству
+ * событий предыдущей. Разбор останавливается на недописанной или
+ * испорченной записи (log->truncated).
+ * @param path Файл журнала.
+ * @param log Журнал. Заполняется.
+ * @return 0 - успешно, 1 - ошибка открытия, отображения или памяти.
+ */
+int replayMap(const char *path, replay_log_t *log) {
+  *log = (replay_log_t){0};
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return FAILURE_EXIT;
+  struct stat st;
+  int res = fstat(fd, &st) != 0 ? FAILURE_EXIT : SUCCESSFUL_EXIT;
+  if (!res && st.st_size > 0) {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      res = FAILURE_EXIT;
+    } else {
+      log->data = data;
+      log->size = st.st_size;
+    }
+  }
+  close(fd);
+  size_t offset = 0, capacity = 0;
+  while (!res && offset < log->size && !log->truncated) {
+    const replay_game_t *game = (const replay_game_t *)(log->data + offset);
+    size_t left = log->size - offset;
+    if (left < sizeof(replay_game_t) || game->magic != REPLAY_MAGIC ||
+        (left - sizeof(replay_game_t)) / sizeof(replay_event_t) <
+            game->count) {
+      log->truncated = true;
+    } else {
+      if ((size_t)log->games == capacity) {
+        capacity = capacity ? 2 * capacity : REPLAY_EVENTS_INIT;
+        size_t *offsets = realloc(log->offsets, capacity * sizeof(size_t));
+        if (offsets == NULL) res = FAILURE_EXIT;
+        if (offsets != NULL) log->offsets = offsets;
+      }
+      if (!res) {
+        log->offsets[log->games++] = offset;
+        offset += sizeof(replay_game_t) + game->count * sizeof(replay_event_t);
+      }
+    }
+  }
+  if (res) replayUnmap(log);
+  return res;
+}
+
+/**
+ * @brief Запись игры index журнала.
+ * @param events События игры. Заполняется.
+ * @return Заголовок игры.
+ */
+const replay_game_t *replayGame(const replay_log_t *log, long long index,
+                                const replay_event_t **events) {
+  const unsigned char *record = log->data + log->offsets[index];
+  *events = (const replay_event_t *)(record + sizeof(replay_game_t));
+  return (const replay_game_t *)record;
+}
+
+/**
+ * @brief Освобождение журнала.
+ */
+void replayUnmap(replay_log_t *log) {
+  if (log->data != NULL) munmap((void *)log->data, log->size);
+  free(log->offsets);
+  *log = (replay_log_t){0};
+}
+
+/**
+ * @brief Начало повтора: новая партия с seed и режимом сложности записи
+ * game на созданной игре (engineInput(Start, true)), как после Start в
+ * START.
+ */
+void replayStart(engine_t *engine, const replay_game_t *game) {
+  engine->state = START;
+  engine->addinfo.seed = game->seed;
+  engine->adaptive.enabled = (game->flags & REPLAY_ADAPTIVE) != 0;
+  engineInput(engine, Start, false);
+}
+
+/**
+ * @brief Повтор события. События с неизвестным действием пропускаются,
+ * создание и удаление массивов игры (hold у Start / Terminate) не
+ * повторяются.
+ */
+void replayApply(engine_t *engine, const replay_event_t *event) {
+  UserAction_t action = (UserAction_t)event->action;
+  if (event->action > Hold) return;
+  if (event->kind == REPLAY_INPUT)
+    engineInput(engine, action, action == Down && event->value);
+  else if (event->kind == REPLAY_KEY)
+    engineKey(engine, action, event->value != 0);
+  else if (event->kind == REPLAY_TICK)
+    engineTick(engine, event->value);
+}
@@ -0,0 +1,89 @@
+#ifndef TETRIS_REPLAY_H
+#define TETRIS_REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "s21_tetris_backend.h"
+
+// Признак записи игры в журнале ("TLG1")
+#define REPLAY_MAGIC 0x31474C54u
+// Флаг игры: дошла до GAMEOVER (иначе журнал закрыт посреди игры)
+#define REPLAY_FINISHED 1u
+// Флаг игры: включена адаптивная сложность (engine_t.adaptive)
+#define REPLAY_ADAPTIVE 2u
+// Начальный размер буфера событий игры
+#define REPLAY_EVENTS_INIT 1024
+
+/// @brief Тип события журнала (вызов на границе userInput)
+typedef enum {
+  /// userInput(action, value)
+  REPLAY_INPUT = 0,
+  /// userKey(action, value): нажатие (1) или отпускание (0)
+  REPLAY_KEY,
+  /// userTick() value раз
+  REPLAY_TICK
+} replay_kind;
+
+/// @brief Заголовок записи одной игры, за ним - count событий
+typedef struct {
+  unsigned int magic;
+  /// Начальное состояние генератора фигур (engine_t.game_seed)
+  unsigned int seed;
+  /// Количество событий
+  unsigned int count;
+  /// REPLAY_FINISHED, REPLAY_ADAPTIVE
+  unsigned int flags;
+} replay_game_t;
+
+/// @brief Событие игры
+typedef struct {
+  /// Время от начала игры, мс
+  unsigned int time_ms;
+  /// replay_kind
+  unsigned char kind;
+  /// UserAction_t
+  unsigned char action;
+  /// hold / pressed / количество шагов времени
+  unsigned short value;
+} replay_event_t;
+
+/// @brief Запись журнала игр одного процесса
+typedef struct {
+  FILE *file;
+  /// Идет запись игры
+  bool active;
+  replay_game_t game;
+  /// События текущей игры (записываются в файл по окончании игры)
+  replay_event_t *events;
+  unsigned int size;
+  /// Время начала текущей игры, нс
+  long long start_ns;
+  /// Была ошибка записи или выделения памяти
+  bool error;
+} replay_recorder_t;
+
+/// @brief Журнал, отображенный в память (только чтение)
+typedef struct {
+  const unsigned char *data;
+  size_t size;
+  /// Смещения записей игр
+  size_t *offsets;
+  long long games;
+  /// В конце файла недописанная запись (пропускается)
+  bool truncated;
+} replay_log_t;
+
+replay_recorder_t *replayRecorderOpen(const char *path);
+void replayRecord(replay_recorder_t *recorder, const engine_t *engine,
+                  replay_kind kind, UserAction_t action, int value);
+int replayRecorderClose(replay_recorder_t *recorder);
+int replayMap(const char *path, replay_log_t *log);
+const replay_game_t *replayGame(const replay_log_t *log, long long index,
+                                const replay_event_t **events);
+void replayUnmap(replay_log_t *log);
+void replayStart(engine_t *engine, const replay_game_t *game);
+void replayApply(engine_t *engine, const replay_event_t *event);
+
+#endif  // TETRIS_REPLAY_H
@@ -0,0 +1,256 @@
+/**
+ * @file s21_tetris_snapshot.c
+ * @brief Снимки поля с общими строками для пробных размещений фигур (бот,
+ * подсказки, анализ) без изменения игры.
+ *
+ * Игра изменяет поле на месте (placePieceOnField, removePieceFromField),
+ * поэтому для перебора размещений на нем пришлось бы копировать все поле
+ * на каждый узел. Снимок - неизменяемый массив указателей на неизменяемые
+ * строки: размещение создает заново только строки с клетками фигуры (до
+ * PIECE_ROWS), удаление заполненных строк сдвигает указатели, остальные
+ * строки общие с исходным снимком. Пустые строки - одна общая строка без
+ * учета ссылок.
+ *
+ * Счетчики ссылок атомарные: поток может продолжать общий снимок своими
+ * размещениями и освобождать свои ветви, не мешая другим потокам.
+ */
+#include "s21_tetris_snapshot.h"
+
+#include <string.h>
+
+/// Общая пустая строка (ссылки не считаются, не освобождается)
+static snapshot_row_t snapshot_empty = {.mask = SNAPSHOT_EMPTY_ROW};
+
+/**
+ * @brief Новая ссылка на строку.
+ */
+static void snapshotRowRetain(snapshot_row_t *row) {
+  if (row != &snapshot_empty)
+    atomic_fetch_add_explicit(&row->refs, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Освобождение ссылки на строку, строка без ссылок удаляется.
+ */
+static void snapshotRowRelease(snapshot_row_t *row) {
+  if (row != &snapshot_empty &&
+      atomic_fetch_sub_explicit(&row->refs, 1, memory_order_acq_rel) == 1)
+    free(row);
+}
+
+/**
+ * @brief Новая строка с одной ссылкой.
+ * @param src Строка, клетки которой копируются.
+ * @return Строка или NULL при ошибке выделения памяти.
+ */
+static snapshot_row_t *snapshotRowCopy(const snapshot_row_t *src) {
+  snapshot_row_t *row = malloc(sizeof(snapshot_row_t));
+  if (row != NULL) {
+    atomic_init(&row->refs, 1);
+    row->mask = src->mask;
+    memcpy(row->cells, src->cells, sizeof(row->cells));
+  }
+  return row;
+}
+
+/**
+ * @brief Новый снимок с одной ссылкой, все строки пустые.
+ */
+static snapshot_t *snapshotCreate() {
+  snapshot_t *snapshot = malloc(sizeof(snapshot_t));
+  if (snapshot != NULL) {
+    atomic_init(&snapshot->refs, 1);
+    for (int i = 0; i < FIELD_ROWS; i++) snapshot->rows[i] = &snapshot_empty;
+    snapshot->hash = 0;
+    snapshot->lines = 0;
+  }
+  return snapshot;
+}
+
+/**
+ * @brief Хеш Зобриста снимка, посчитанный по всем клеткам.
+ */
+static unsigned long long snapshotHash(const snapshot_t *snapshot) {
+  unsigned long long hash = 0;
+  for (int i = 0; i < FIELD_ROWS; i++) {
+    unsigned int cells =
+        (snapshot->rows[i]->mask & SNAPSHOT_FIELD_BITS) >> KICK_MARGIN;
+    while (cells) {
+      hash ^= zobrist_keys[i][__builtin_ctz(cells)];
+      cells &= cells - 1;
+    }
+  }
+  return hash;
+}
+
+/**
+ * @brief Снимок поля без клеток фигуры.
+ * @param mask Маска шаблона фигуры (0 - без фигуры), row, col - ее позиция.
+ */
+static snapshot_t *snapshotBuild(cell_t **field, int mask, int row,
+                                 int col) {
+  zobristInit();
+  snapshot_t *snapshot = snapshotCreate();
+  bool ok = snapshot != NULL;
+  for (int i = 0; i < FIELD_ROWS && ok; i++) {
+    snapshot_row_t row_value = {.mask = SNAPSHOT_EMPTY_ROW};
+    int piece_row = i - row;
+    unsigned int piece = piece_row >= 0 && piece_row < PIECE_ROWS
+                             ? (mask >> (piece_row * PIECE_COLUMNS)) & 0xF
+                             : 0;
+    for (int j = 0; j < FIELD_COLUMNS; j++) {
+      bool in_piece = j >= col && j < col + PIECE_COLUMNS &&
+                      ((piece >> (j - col)) & 1);
+      if (field[i][j] && !in_piece) {
+        row_value.mask |= 1u << (j + KICK_MARGIN);
+        row_value.cells[j] = field[i][j];
+        snapshot->hash ^= zobrist_keys[i][j];
+      }
+    }
+    if (row_value.mask != SNAPSHOT_EMPTY_ROW) {
+      snapshot->rows[i] = snapshotRowCopy(&row_value);
+      if (snapshot->rows[i] == NULL) {
+        snapshot->rows[i] = &snapshot_empty;
+        ok = false;
+      }
+    }
+  }
+  if (!ok) {
+    snapshotRelease(snapshot);
+    snapshot = NULL;
+  }
+  return snapshot;
+}
+
+/**
+ * @brief Снимок поля.
+ * @return Снимок (одна ссылка) или NULL при ошибке выделения памяти.
+ */
+snapshot_t *snapshotFromField(cell_t **field) {
+  return snapshotBuild(field, 0, 0, 0);
+}
+
+/**
+ * @brief Снимок поля игры без текущей фигуры (в MOVING и PAUSE она
+ * нарисована на поле).
+ * @return Снимок (одна ссылка) или NULL при ошибке выделения памяти.
+ */
+snapshot_t *snapshotFromEngine(const engine_t *engine) {
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  int mask = 0;
+  if (engine->state == MOVING || engine->state == PAUSE)
+    mask = pieceMask(fsm_addinfo->piece_id, fsm_addinfo->piece_rot_id);
+  return snapshotBuild(engine->game_info.field, mask, fsm_addinfo->row_pos,
+                       fsm_addinfo->col_pos);
+}
+
+/**
+ * @brief Новая ссылка на снимок (например, для другого потока).
+ */
+snapshot_t *snapshotRetain(snapshot_t *snapshot) {
+  atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+  return snapshot;
+}
+
+/**
+ * @brief Освобождение ссылки на снимок. Снимок без ссылок удаляется вместе
+ * со строками, на которые больше нет ссылок. NULL игнорируется.
+ */
+void snapshotRelease(snapshot_t *snapshot) {
+  if (snapshot != NULL &&
+      atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) ==
+          1) {
+    for (int i = 0; i < FIELD_ROWS; i++) snapshotRowRelease(snapshot->rows[i]);
+    free(snapshot);
+  }
+}
+
+/**
+ * @brief Проверка, помещается ли фигура (маска шаблона) в позицию.
+ */
+bool snapshotFits(const snapshot_t *snapshot, int mask, int row, int col) {
+  bool fits = true;
+  for (int i = 0; i < PIECE_ROWS && fits; i++) {
+    unsigned int cells = (mask >> (i * PIECE_COLUMNS)) & 0xF;
+    if (cells)
+      fits = row + i >= 0 && row + i < FIELD_ROWS &&
+             !(snapshot->rows[row + i]->mask & (cells << (col + KICK_MARGIN)));
+  }
+  return fits;
+}
+
+/**
+ * @brief Строка, на которой остановится фигура, падающая из позиции
+ * (row, col).
+ * @return Строка или -1, если фигура не помещается в исходную позицию.
+ */
+int snapshotDropRow(const snapshot_t *snapshot, int mask, int row, int col) {
+  if (!snapshotFits(snapshot, mask, row, col)) return -1;
+  while (snapshotFits(snapshot, mask, row + 1, col)) row++;
+  return row;
+}
+
+/**
+ * @brief Размещение фигуры и удаление заполненных строк - новый снимок.
+ *
+ * Исходный снимок не изменяется. Новыми создаются только строки с клетками
+ * фигуры, остальные строки общие с исходным снимком. Фигура должна
+ * помещаться в позицию (snapshotFits).
+ * @param id, rot_id Фигура и ее вращение (значение клеток - id + 1).
+ * @param row, col Позиция шаблона фигуры.
+ * @return Снимок (одна ссылка) или NULL при ошибке выделения памяти.
+ */
+snapshot_t *snapshotPlace(const snapshot_t *snapshot, int id, int rot_id,
+                          int row, int col) {
+  int mask = pieceMask(id, rot_id);
+  snapshot_row_t *rows[FIELD_ROWS];
+  bool fresh[FIELD_ROWS] = {false};
+  bool ok = true;
+  unsigned long long hash = snapshot->hash;
+  memcpy(rows, snapshot->rows, sizeof(rows));
+  for (int i = 0; i < PIECE_ROWS && ok; i++) {
+    unsigned int cells = (mask >> (i * PIECE_COLUMNS)) & 0xF;
+    if (!cells) continue;
+    snapshot_row_t *copy = snapshotRowCopy(rows[row + i]);
+    ok = copy != NULL;
+    if (ok) {
+      copy->mask |= cells << (col + KICK_MARGIN);
+      for (; cells; cells &= cells - 1) {
+        int j = col + __builtin_ctz(cells);
+        copy->cells[j] = (cell_t)(id + 1);
+        hash ^= zobrist_keys[row + i][j];
+      }
+      rows[row + i] = copy;
+      fresh[row + i] = true;
+    }
+  }
+  snapshot_t *res = ok ? snapshotCreate() : NULL;
+  if (res == NULL) {
+    for (int i = 0; i < FIELD_ROWS; i++)
+      if (fresh[i]) free(rows[i]);
+    return NULL;
+  }
+  // Заполненные строки удаляются, строки выше сдвигаются вниз
+  int k = FIELD_ROWS;
+  for (int i = FIELD_ROWS - 1; i >= 0; i--) {
+    if ((rows[i]->mask & SNAPSHOT_FIELD_BITS) == SNAPSHOT_FIELD_BITS) {
+      res->lines++;
+      if (fresh[i]) free(rows[i]);
+    } else {
+      if (!fresh[i]) snapshotRowRetain(rows[i]);
+      res->rows[--k] = rows[i];
+    }
+  }
+  res->hash = res->lines ? snapshotHash(res) : hash;
+  return res;
+}
+
+/**
+ * @brief Количество общих строк двух снимков (одна и та же строка на одном
+ * месте), включая пустые.
+ */
+int snapshotShared(const snapshot_t *a, const snapshot_t *b) {
+  int shared = 0;
+  for (int i = 0; i < FIELD_ROWS; i++) shared += a->rows[i] == b->rows[i];
+  return shared;
+}
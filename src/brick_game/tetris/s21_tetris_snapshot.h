@@ -0,0 +1,61 @@
+#ifndef TETRIS_SNAPSHOT_H
+#define TETRIS_SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "../../gui/cli/s21_define.h"
+#include "s21_tetris_backend.h"
+
+/// Занятые клетки строки: столбец j - бит j + KICK_MARGIN, клетки за
+/// стенами заняты (как в битовых масках поворота и бота)
+#define SNAPSHOT_FIELD_BITS (((1u << FIELD_COLUMNS) - 1) << KICK_MARGIN)
+#define SNAPSHOT_EMPTY_ROW (~SNAPSHOT_FIELD_BITS)
+
+/// @brief Строка снимка поля: не изменяется после создания, общая для всех
+/// снимков, в которых не менялась
+typedef struct {
+  /// Ссылок из снимков (у общей пустой строки не считаются)
+  atomic_int refs;
+  /// Маска занятых клеток (SNAPSHOT_EMPTY_ROW - пустая строка)
+  unsigned int mask;
+  /// Значения клеток: 0 - пустая, 1-7 - цвет фигуры
+  cell_t cells[FIELD_COLUMNS];
+} snapshot_row_t;
+
+/// @brief Снимок поля: неизменяемое значение для пробных размещений.
+///
+/// Размещение фигуры (snapshotPlace) дает новый снимок, в котором заново
+/// создаются только строки с клетками фигуры, остальные строки общие с
+/// исходным снимком (при удалении строк сдвигаются только указатели).
+/// Снимки и строки освобождаются по счетчику ссылок, поэтому один снимок
+/// можно читать и продолжать из нескольких потоков без блокировок.
+typedef struct {
+  /// Ссылок на снимок (snapshotRetain, snapshotRelease)
+  atomic_int refs;
+  /// Строки поля сверху вниз
+  snapshot_row_t *rows[FIELD_ROWS];
+  /// Хеш Зобриста заполненных клеток (как fieldHash)
+  unsigned long long hash;
+  /// Строк удалено размещением, которым получен снимок
+  int lines;
+} snapshot_t;
+
+snapshot_t *snapshotFromField(cell_t **field);
+snapshot_t *snapshotFromEngine(const engine_t *engine);
+snapshot_t *snapshotRetain(snapshot_t *snapshot);
+void snapshotRelease(snapshot_t *snapshot);
+bool snapshotFits(const snapshot_t *snapshot, int mask, int row, int col);
+int snapshotDropRow(const snapshot_t *snapshot, int mask, int row, int col);
+snapshot_t *snapshotPlace(const snapshot_t *snapshot, int id, int rot_id,
+                          int row, int col);
+int snapshotShared(const snapshot_t *a, const snapshot_t *b);
+
+/**
+ * @brief Значение клетки снимка.
+ */
+static inline int snapshotCell(const snapshot_t *snapshot, int row, int col) {
+  return snapshot->rows[row]->cells[col];
+}
+
+#endif  // TETRIS_SNAPSHOT_H
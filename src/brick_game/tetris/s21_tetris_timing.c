@@ -0,0 +1,187 @@
+/**
+ * @file s21_tetris_timing.c
+ * @brief Управление по времени игры: автоповтор сдвига (DAS / ARR), мягкое
+ * падение, гравитация и задержка фиксации фигуры.
+ *
+ * Время игры идет шагами (TICK_SIG, TIMING_TICK_NS), клавиши с автоповтором
+ * передаются нажатием и отпусканием (PRESS_SIG / RELEASE_SIG). Все сдвиги и
+ * падения выполняются обычными действиями FSM, поэтому таблица переходов
+ * не меняется: фигура на опоре фиксируется сдвигом вниз (EV_DOWN), который
+ * отправляется только по окончании задержки фиксации. Скорость повтора не
+ * зависит от терминала, а при шагах в виртуальном времени игра выполняется
+ * без ожидания.
+ */
+#include "s21_tetris_timing.h"
+
+#include "s21_tetris_board.h"
+
+/**
+ * @brief Настройки по умолчанию: DAS 10 шагов (167 мс), ARR 2 шага
+ * (33 мс), мягкое падение - строка за 2 шага, задержка фиксации 30 шагов
+ * (0.5 с) и не больше 15 ее сбросов.
+ */
+void timingDefaultConfig(timing_config_t *config) {
+  config->das = TIMING_DAS;
+  config->arr = TIMING_ARR;
+  config->soft_drop = TIMING_SOFT_DROP;
+  config->lock_delay = TIMING_LOCK_DELAY;
+  config->lock_resets = TIMING_LOCK_RESETS;
+}
+
+/**
+ * @brief Сброс состояния (отпускание клавиш, таймеры) без изменения
+ * настроек. Выполняется при старте каждой игры.
+ */
+void timingReset(timing_t *timing) {
+  timing->held = 0;
+  timing->shift = Up;
+  timing->shift_timer = 0;
+  timing->soft_drop = false;
+  timing->soft_timer = 0;
+  timing->gravity_ns = 0;
+  timing->lock_timer = 0;
+  timing->lock_resets = 0;
+  timing->lock_row = 0;
+  timing->piece = 0;
+}
+
+/**
+ * @brief Текущая фигура стоит на опоре (сдвиг вниз невозможен).
+ */
+static bool timingGrounded(engine_t *engine) {
+  GameInfo_t *game_info = &engine->game_info;
+  addinfo_t *fsm_addinfo = &engine->addinfo;
+  const board_ops_t *board = engineBoard(engine);
+  board->remove(game_info, fsm_addinfo);
+  fsm_addinfo->row_pos++;
+  bool res = board->check(game_info, fsm_addinfo);
+  fsm_addinfo->row_pos--;
+  board->place(game_info, fsm_addinfo);
+  return res;
+}
+
+/**
+ * @brief Задержка фиксации после действия FSM (любого: клавиши с
+ * автоповтором, шаги времени и userInput выполняются одним путем fsmStep).
+ *
+ * Новая фигура получает новую задержку и все сбросы. Сдвиг или вращение
+ * фигуры на опоре сбрасывает задержку, пока не исчерпаны сбросы; спуск
+ * ниже прежней самой нижней строки возвращает сбросы.
+ * @param col Столбец фигуры до действия.
+ * @param rot_id Поворот фигуры до действия.
+ */
+void timingMoved(engine_t *engine, int col, int rot_id) {
+  timing_t *timing = &engine->timing;
+  addinfo_t *fsm_addinfo = &engine->addinfo;
+  if (engine->piece_count != timing->piece) {
+    timing->piece = engine->piece_count;
+    timing->lock_timer = 0;
+    timing->lock_resets = 0;
+    timing->lock_row = fsm_addinfo->row_pos;
+  } else if (fsm_addinfo->row_pos > timing->lock_row) {
+    timing->lock_row = fsm_addinfo->row_pos;
+    timing->lock_resets = 0;
+  } else if (timing->lock_timer > 0 &&
+             (col != fsm_addinfo->col_pos ||
+              rot_id != fsm_addinfo->piece_rot_id) &&
+             timing->lock_resets < timing->config.lock_resets) {
+    timing->lock_timer = 0;
+    timing->lock_resets++;
+  }
+}
+
+/**
+ * @brief Сдвиг фигуры автоповтором: один или, при ARR 0, до препятствия.
+ */
+static void timingShift(engine_t *engine) {
+  timing_t *timing = &engine->timing;
+  int repeat = timing->config.arr > 0 ? 1 : FIELD_COLUMNS;
+  for (int i = 0; i < repeat && engine->state == MOVING; i++)
+    engineInput(engine, timing->shift, false);
+  timing->shift_timer = timing->config.arr > 0 ? timing->config.arr : 1;
+}
+
+/**
+ * @brief Нажатие или отпускание клавиши.
+ *
+ * Left / Right: сдвиг сразу при нажатии, затем автоповтор после DAS, пока
+ * клавиша нажата. Из двух нажатых направлений действует последнее нажатое.
+ * Down: мягкое падение, пока клавиша нажата (падение фигуры - по-прежнему
+ * Down с DROP_SIG). Остальные действия выполняются при нажатии.
+ * @param engine Игра.
+ * @param action Клавиша (действие).
+ * @param pressed true - нажатие, false - отпускание.
+ */
+void timingKey(engine_t *engine, UserAction_t action, bool pressed) {
+  timing_t *timing = &engine->timing;
+  if (action == Left || action == Right) {
+    unsigned int bit = 1u << action;
+    if (pressed) {
+      timing->held |= bit;
+      timing->shift = action;
+      timing->shift_timer = timing->config.das;
+      if (engine->state == MOVING) engineInput(engine, action, false);
+    } else {
+      timing->held &= ~bit;
+      if (timing->shift == action) {
+        UserAction_t other = action == Left ? Right : Left;
+        timing->shift = (timing->held & (1u << other)) ? other : Up;
+        timing->shift_timer = timing->config.das;
+      }
+    }
+  } else if (action == Down) {
+    timing->soft_drop = pressed;
+    timing->soft_timer = timing->config.soft_drop;
+    if (pressed && engine->state == MOVING && !timingGrounded(engine)) {
+      engineInput(engine, Down, false);
+      timing->gravity_ns = 0;
+    }
+  } else if (pressed) {
+    engineInput(engine, action, false);
+  }
+}
+
+/**
+ * @brief Один шаг времени игры.
+ *
+ * В состоянии MOVING по очереди: автоповтор сдвига, мягкое падение,
+ * гравитация (период зависит от скорости игры), задержка фиксации. Фигура
+ * на опоре не фиксируется гравитацией: она фиксируется, когда задержка
+ * проходит без сброса. В остальных состояниях шаг только считается.
+ */
+void timingTick(engine_t *engine) {
+  timing_t *timing = &engine->timing;
+  timing->ticks++;
+  if (engine->state != MOVING) return;
+  if (engine->piece_count != timing->piece) {
+    timing->piece = engine->piece_count;
+    timing->lock_timer = 0;
+    timing->lock_resets = 0;
+    timing->lock_row = engine->addinfo.row_pos;
+  }
+  if (timing->shift != Up && --timing->shift_timer <= 0) timingShift(engine);
+  bool fell = false;
+  if (timing->soft_drop && engine->state == MOVING &&
+      --timing->soft_timer <= 0) {
+    timing->soft_timer = timing->config.soft_drop;
+    if (!timingGrounded(engine)) {
+      engineInput(engine, Down, false);
+      fell = true;
+    }
+  }
+  long long period = engine->game_info.speed * TIMING_SPEED_NS;
+  timing->gravity_ns += TIMING_TICK_NS;
+  if (fell || period <= 0) {
+    timing->gravity_ns = 0;
+  } else if (timing->gravity_ns >= period) {
+    timing->gravity_ns -= period;
+    if (engine->state == MOVING && !timingGrounded(engine))
+      engineInput(engine, Down, false);
+  }
+  if (engine->state == MOVING && timingGrounded(engine)) {
+    if (++timing->lock_timer > timing->config.lock_delay)
+      engineInput(engine, Down, false);
+  } else {
+    timing->lock_timer = 0;
+  }
+}
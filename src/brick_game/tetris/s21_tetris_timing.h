@@ -0,0 +1,24 @@
+#ifndef TETRIS_TIMING_H
+#define TETRIS_TIMING_H
+
+#include "s21_tetris_fsm.h"
+
+// Шаг времени игры, нс (60 шагов в секунду)
+#define TIMING_TICK_NS 16666667LL
+// Период гравитации на единицу скорости game_info.speed, нс
+// (START_SPEED - 0.84 с на строку, 10 уровень - 0.12 с)
+#define TIMING_SPEED_NS 100000LL
+// Настройки по умолчанию, в шагах времени
+#define TIMING_DAS 10
+#define TIMING_ARR 2
+#define TIMING_SOFT_DROP 2
+#define TIMING_LOCK_DELAY 30
+#define TIMING_LOCK_RESETS 15
+
+void timingDefaultConfig(timing_config_t *config);
+void timingReset(timing_t *timing);
+void timingKey(engine_t *engine, UserAction_t action, bool pressed);
+void timingTick(engine_t *engine);
+void timingMoved(engine_t *engine, int col, int rot_id);
+
+#endif  // TETRIS_TIMING_H
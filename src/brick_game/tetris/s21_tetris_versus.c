@@ -0,0 +1,348 @@
+/**
+ * @file s21_tetris_versus.c
+ * @brief Режим versus: матчи из нескольких игр с обменом строками мусора.
+ *
+ * Игры матча выполняются шагами одновременно (versusStep): за шаг каждый
+ * игрок выполняет не больше одного действия из своей очереди ввода, затем
+ * (раз в gravity_ticks шагов) фигуры опускаются. Строки, удаленные
+ * закрепленной фигурой (fsmAttach, engine_t.last_clear), по таблице атаки
+ * превращаются в мусор: сначала гасят входящий мусор игрока, остаток
+ * уходит случайному сопернику. Мусор поднимается на поле соперника после
+ * закрепления им фигуры без удаления строк.
+ *
+ * Координатор выполняет шаги всех своих матчей в одном рабочем потоке:
+ * матч - обычная структура без своего потока и без выделения памяти на
+ * шаге, поэтому на один поток приходятся тысячи матчей.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "s21_tetris_versus.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "s21_tetris_fsm.h"
+
+/**
+ * @brief Правила по умолчанию: атака 0/0/1/2/4 строки за 0-4 удаленные,
+ * бонусы за серию 0,0,1,1,2,2,3,3,4,4,4,5; дыра меняется в 30% строк,
+ * фигура опускается каждые 30 шагов (раз в 0.5 с при 60 шагах в секунду).
+ */
+void versusDefaultConfig(versus_config_t *config) {
+  static const int attack[PIECE_ROWS + 1] = {0, 0, 1, 2, 4};
+  static const int combo[VERSUS_COMBO_LEVELS] = {0, 0, 1, 1, 2, 2,
+                                                 3, 3, 4, 4, 4, 5};
+  memcpy(config->attack, attack, sizeof(attack));
+  memcpy(config->combo, combo, sizeof(combo));
+  config->hole_change = 30;
+  config->gravity_ticks = 30;
+}
+
+/**
+ * @brief Следующее случайное число генератора матча (0 - 32767).
+ */
+static int versusRandom(versus_match_t *match) {
+  match->rng = match->rng * 1103515245u + 12345u;
+  return (int)((match->rng >> 16) & 0x7FFF);
+}
+
+/**
+ * @brief Создание матча и запуск игр всех игроков.
+ *
+ * Память выделяется только под заданное количество игроков. Все игры
+ * получают одинаковый seed, т.е. одинаковую последовательность фигур.
+ * @param config Правила. NULL - правила по умолчанию.
+ * @param players Количество игроков, от 2 до VERSUS_MAX_PLAYERS.
+ * @param seed Начальное значение генераторов фигур и мусора.
+ * @return SUCCESSFUL_EXIT или FAILURE_EXIT при неверных параметрах или
+ * ошибке выделения памяти.
+ */
+int versusCreate(versus_match_t *match, const versus_config_t *config,
+                 int players, unsigned int seed) {
+  if (players < 2 || players > VERSUS_MAX_PLAYERS) return FAILURE_EXIT;
+  match->players = (versus_player_t *)calloc(players, sizeof(*match->players));
+  if (match->players == NULL) return FAILURE_EXIT;
+  if (config != NULL) {
+    match->config = *config;
+  } else {
+    versusDefaultConfig(&match->config);
+  }
+  match->players_count = 0;
+  match->alive = players;
+  match->rng = seed;
+  match->ticks = 0;
+  match->next = NULL;
+  match->coordinator = NULL;
+  int res = SUCCESSFUL_EXIT;
+  for (int i = 0; i < players && !res; i++) {
+    versus_player_t *player = &match->players[i];
+    player->engine.state = START;
+    // Массивы создаются без инициализации партии, ее выполняет Start
+    engineInput(&player->engine, Start, true);
+    if (player->engine.game_info.pause == EXIT_MODE) {
+      engineInput(&player->engine, Terminate, true);
+      res = FAILURE_EXIT;
+    } else {
+      match->players_count++;
+      player->engine.addinfo.seed = seed;
+      engineInput(&player->engine, Start, false);
+      atomic_init(&player->input_head, 0);
+      atomic_init(&player->input_tail, 0);
+      player->alive = true;
+      player->combo = 0;
+      player->sent = 0;
+      player->received = 0;
+    }
+  }
+  if (res) versusDestroy(match);
+  return res;
+}
+
+/**
+ * @brief Удаление игр матча. Матч не должен быть у координатора.
+ */
+void versusDestroy(versus_match_t *match) {
+  for (int i = 0; i < match->players_count; i++)
+    engineInput(&match->players[i].engine, Terminate, true);
+  free(match->players);
+  match->players = NULL;
+  match->players_count = 0;
+  match->alive = 0;
+}
+
+/**
+ * @brief Действие игрока в очередь ввода. Можно вызывать из другого потока,
+ * но для одного игрока - только из одного.
+ * @return SUCCESSFUL_EXIT или FAILURE_EXIT, если очередь заполнена или
+ * нет такого игрока.
+ */
+int versusInput(versus_match_t *match, int player, UserAction_t action,
+                bool hold) {
+  if (player < 0 || player >= match->players_count) return FAILURE_EXIT;
+  versus_player_t *p = &match->players[player];
+  unsigned int tail =
+      atomic_load_explicit(&p->input_tail, memory_order_relaxed);
+  unsigned int head =
+      atomic_load_explicit(&p->input_head, memory_order_acquire);
+  if (tail - head == VERSUS_INPUT_QUEUE) return FAILURE_EXIT;
+  p->input[tail % VERSUS_INPUT_QUEUE] =
+      (unsigned char)(action | (hold ? 0x80 : 0));
+  atomic_store_explicit(&p->input_tail, tail + 1, memory_order_release);
+  return SUCCESSFUL_EXIT;
+}
+
+/**
+ * @brief Случайный соперник в игре.
+ * @return Номер игрока или -1, если соперников не осталось.
+ */
+static int versusTarget(versus_match_t *match, int from) {
+  int others = match->alive - (match->players[from].alive ? 1 : 0);
+  int res = -1;
+  if (others > 0) {
+    int k = versusRandom(match) % others;
+    for (int i = 0; i < match->players_count && res < 0; i++) {
+      if (i != from && match->players[i].alive && k-- == 0) res = i;
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Добавление строк мусора в очередь игрока. Дыра первой строки
+ * выбирается случайно, следующие строки меняют столбец дыры с вероятностью
+ * hole_change %. Строки сверх FIELD_ROWS отбрасываются.
+ */
+static void versusSendGarbage(versus_match_t *match, int to, int rows) {
+  engine_t *engine = &match->players[to].engine;
+  int hole = versusRandom(match) % FIELD_COLUMNS;
+  for (int k = 0; k < rows && engine->garbage_count < FIELD_ROWS; k++) {
+    if (k > 0 && versusRandom(match) % 100 < match->config.hole_change)
+      hole = (hole + 1 + versusRandom(match) % (FIELD_COLUMNS - 1)) %
+             FIELD_COLUMNS;
+    engine->garbage[engine->garbage_count++] = (unsigned char)hole;
+    match->players[to].received++;
+  }
+}
+
+/**
+ * @brief Атака после закрепления фигуры игроком: удаленные строки гасят
+ * входящий мусор, остаток отправляется сопернику.
+ */
+static void versusAttack(versus_match_t *match, int from) {
+  versus_player_t *player = &match->players[from];
+  engine_t *engine = &player->engine;
+  int lines = engine->last_clear;
+  if (lines == 0) {
+    player->combo = 0;
+  } else {
+    int level = player->combo < VERSUS_COMBO_LEVELS ? player->combo
+                                                    : VERSUS_COMBO_LEVELS - 1;
+    int attack = match->config.attack[lines] + match->config.combo[level];
+    player->combo++;
+    int cancel =
+        attack < engine->garbage_count ? attack : engine->garbage_count;
+    if (cancel > 0) {
+      // Гасится мусор, пришедший раньше
+      engine->garbage_count -= cancel;
+      memmove(engine->garbage, engine->garbage + cancel,
+              engine->garbage_count);
+      attack -= cancel;
+    }
+    int target = attack > 0 ? versusTarget(match, from) : -1;
+    if (target >= 0) {
+      versusSendGarbage(match, target, attack);
+      player->sent += attack;
+    }
+  }
+}
+
+/**
+ * @brief Действие в игре игрока с учетом закрепления фигуры и проигрыша.
+ */
+static void versusAct(versus_match_t *match, int index, UserAction_t action,
+                      bool hold) {
+  versus_player_t *player = &match->players[index];
+  // Закрепление фигуры определяется по last_clear (отложение фигуры тоже
+  // выводит новую фигуру, но без закрепления)
+  player->engine.last_clear = -1;
+  engineInput(&player->engine, action, hold);
+  if (player->engine.last_clear >= 0) versusAttack(match, index);
+  if (player->engine.state == GAMEOVER) {
+    player->alive = false;
+    match->alive--;
+  }
+}
+
+/**
+ * @brief Один шаг матча для всех игроков.
+ *
+ * Каждый игрок в игре выполняет следующее действие из очереди (Start и
+ * Pause в матче игнорируются, Terminate - сдача), затем, если пришло время,
+ * фигура опускается. После окончания матча (в игре не больше одного
+ * игрока) шаг ничего не делает.
+ */
+void versusStep(versus_match_t *match) {
+  if (match->alive < 2) return;
+  bool gravity = match->config.gravity_ticks > 0 &&
+                 (match->ticks + 1) % match->config.gravity_ticks == 0;
+  for (int i = 0; i < match->players_count; i++) {
+    versus_player_t *player = &match->players[i];
+    if (!player->alive) continue;
+    unsigned int head = atomic_load_explicit(&player->input_head,
+                                             memory_order_relaxed);
+    if (head != atomic_load_explicit(&player->input_tail,
+                                     memory_order_acquire)) {
+      unsigned char input = player->input[head % VERSUS_INPUT_QUEUE];
+      atomic_store_explicit(&player->input_head, head + 1,
+                            memory_order_release);
+      UserAction_t action = (UserAction_t)(input & 0x7f);
+      // hold имеет смысл только для падения (иначе это создание и
+      // удаление массивов игры)
+      if (action != Start && action != Pause && action <= Hold)
+        versusAct(match, i, action, action == Down && (input & 0x80));
+    }
+    if (gravity && player->alive && player->engine.state == MOVING)
+      versusAct(match, i, Down, false);
+  }
+  match->ticks++;
+}
+
+/**
+ * @brief Победитель матча.
+ * @return Номер последнего оставшегося игрока или -1, если матч не закончен
+ * или закончился вничью (последние игроки проиграли на одном шаге).
+ * Пока матч у координатора, состояние читается под его блокировкой.
+ */
+int versusWinner(const versus_match_t *match) {
+  versus_coordinator_t *coordinator = match->coordinator;
+  if (coordinator != NULL) pthread_mutex_lock(&coordinator->lock);
+  int res = -1;
+  if (match->alive == 1) {
+    for (int i = 0; i < match->players_count; i++)
+      if (match->players[i].alive) res = i;
+  }
+  if (coordinator != NULL) pthread_mutex_unlock(&coordinator->lock);
+  return res;
+}
+
+/**
+ * @brief Рабочий поток координатора: шаги всех матчей раз в tick_ns.
+ */
+static void *coordinatorLoop(void *arg) {
+  versus_coordinator_t *coordinator = (versus_coordinator_t *)arg;
+  long long next = metricsNow();
+  while (atomic_load(&coordinator->running)) {
+    pthread_mutex_lock(&coordinator->lock);
+    for (versus_match_t *match = coordinator->matches; match != NULL;
+         match = match->next)
+      versusStep(match);
+    pthread_mutex_unlock(&coordinator->lock);
+    atomic_fetch_add(&coordinator->ticks, 1);
+    if (coordinator->tick_ns > 0) {
+      // Отставание не накапливается: после долгого шага отсчет заново
+      long long now = metricsNow();
+      next += coordinator->tick_ns;
+      if (next < now) next = now;
+      struct timespec ts = {next / 1000000000LL, next % 1000000000LL};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Запуск координатора без матчей.
+ * @param tick_ns Интервал шага, нс. 0 - шаги без ожидания (для замеров).
+ * @return SUCCESSFUL_EXIT или FAILURE_EXIT, если поток не создан.
+ */
+int coordinatorStart(versus_coordinator_t *coordinator, long long tick_ns) {
+  coordinator->matches = NULL;
+  coordinator->tick_ns = tick_ns;
+  atomic_init(&coordinator->running, true);
+  atomic_init(&coordinator->ticks, 0);
+  int res = pthread_mutex_init(&coordinator->lock, NULL) ? FAILURE_EXIT
+                                                          : SUCCESSFUL_EXIT;
+  if (!res && pthread_create(&coordinator->thread, NULL, coordinatorLoop,
+                             coordinator)) {
+    pthread_mutex_destroy(&coordinator->lock);
+    res = FAILURE_EXIT;
+  }
+  return res;
+}
+
+/**
+ * @brief Передача матча координатору. До удаления (coordinatorRemove)
+ * игры матча меняет только поток координатора.
+ */
+void coordinatorAdd(versus_coordinator_t *coordinator, versus_match_t *match) {
+  pthread_mutex_lock(&coordinator->lock);
+  match->next = coordinator->matches;
+  match->coordinator = coordinator;
+  coordinator->matches = match;
+  pthread_mutex_unlock(&coordinator->lock);
+}
+
+/**
+ * @brief Удаление матча у координатора. После возврата матч больше не
+ * выполняется.
+ */
+void coordinatorRemove(versus_coordinator_t *coordinator,
+                       versus_match_t *match) {
+  pthread_mutex_lock(&coordinator->lock);
+  versus_match_t **link = &coordinator->matches;
+  while (*link != NULL && *link != match) link = &(*link)->next;
+  if (*link != NULL) *link = match->next;
+  match->next = NULL;
+  match->coordinator = NULL;
+  pthread_mutex_unlock(&coordinator->lock);
+}
+
+/**
+ * @brief Остановка потока координатора. Матчи не удаляются.
+ */
+void coordinatorStop(versus_coordinator_t *coordinator) {
+  atomic_store(&coordinator->running, false);
+  pthread_join(coordinator->thread, NULL);
+  pthread_mutex_destroy(&coordinator->lock);
+}
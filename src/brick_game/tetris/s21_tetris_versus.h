@@ -0,0 +1,98 @@
+#ifndef TETRIS_VERSUS_H
+#define TETRIS_VERSUS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "../../gui/cli/s21_define.h"
+#include "s21_tetris_backend.h"
+
+// Максимум игроков в одном матче
+#define VERSUS_MAX_PLAYERS 16
+// Длина таблицы бонусов за серию удалений подряд (дальше - последний)
+#define VERSUS_COMBO_LEVELS 12
+// Размер очереди ввода игрока (степень двойки)
+#define VERSUS_INPUT_QUEUE 16
+// Шаг координатора по умолчанию, нс (60 шагов в секунду)
+#define VERSUS_TICK_NS 16666667LL
+
+/// @brief Правила матча
+typedef struct {
+  /// Строки мусора за удаление 0-4 строк одной фигурой
+  int attack[PIECE_ROWS + 1];
+  /// Дополнительные строки за серию: [n] - n-е удаление подряд
+  int combo[VERSUS_COMBO_LEVELS];
+  /// Вероятность (%) смены столбца дыры между соседними строками мусора
+  int hole_change;
+  /// Каждые gravity_ticks шагов фигура опускается (0 - без гравитации)
+  int gravity_ticks;
+} versus_config_t;
+
+/// @brief Игрок матча
+typedef struct {
+  /// Игра игрока
+  engine_t engine;
+  /// Очередь ввода (один писатель, читает координатор): action | hold << 7
+  unsigned char input[VERSUS_INPUT_QUEUE];
+  atomic_uint input_head;
+  atomic_uint input_tail;
+  /// Игрок еще в игре
+  bool alive;
+  /// Текущая серия удалений подряд
+  int combo;
+  /// Отправлено и получено строк мусора
+  int sent;
+  int received;
+} versus_player_t;
+
+/// @brief Матч: игры игроков, которые выполняются шагами одновременно
+typedef struct versus_match {
+  /// Правила
+  versus_config_t config;
+  /// Игроки (память на players_count выделяет versusCreate)
+  versus_player_t *players;
+  int players_count;
+  /// Игроков в игре
+  int alive;
+  /// Генератор для дыр мусора и выбора цели
+  unsigned int rng;
+  /// Выполнено шагов
+  unsigned long long ticks;
+  /// Следующий матч координатора
+  struct versus_match *next;
+  /// Координатор, выполняющий матч (coordinatorAdd), или NULL
+  struct versus_coordinator *coordinator;
+} versus_match_t;
+
+/// @brief Координатор: поток, выполняющий шаги всех своих матчей
+typedef struct versus_coordinator {
+  /// Матчи координатора (список через next)
+  versus_match_t *matches;
+  /// Защита списка матчей
+  pthread_mutex_t lock;
+  /// Поток координатора
+  pthread_t thread;
+  /// Интервал шага, нс (0 - без ожидания)
+  long long tick_ns;
+  /// Поток должен работать
+  atomic_bool running;
+  /// Выполнено шагов
+  atomic_ullong ticks;
+} versus_coordinator_t;
+
+void versusDefaultConfig(versus_config_t *config);
+int versusCreate(versus_match_t *match, const versus_config_t *config,
+                 int players, unsigned int seed);
+void versusDestroy(versus_match_t *match);
+int versusInput(versus_match_t *match, int player, UserAction_t action,
+                bool hold);
+void versusStep(versus_match_t *match);
+int versusWinner(const versus_match_t *match);
+int coordinatorStart(versus_coordinator_t *coordinator, long long tick_ns);
+void coordinatorAdd(versus_coordinator_t *coordinator, versus_match_t *match);
+void coordinatorRemove(versus_coordinator_t *coordinator,
+                       versus_match_t *match);
+void coordinatorStop(versus_coordinator_t *coordinator);
+
+#endif  // TETRIS_VERSUS_H
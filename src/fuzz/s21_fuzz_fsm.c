@@ -0,0 +1,244 @@
+/**
+ * @file s21_fuzz_fsm.c
+ * @brief Фаззинг FSM: случайные последовательности (UserAction_t, hold),
+ * нажатий клавиш с автоповтором и шагов времени с проверкой инвариантов
+ * игры после каждого шага.
+ *
+ * Инварианты:
+ * - клетки текущей фигуры в MOVING / PAUSE находятся на поле и записаны в нем;
+ * - после ATTACHING на поле (без текущей фигуры) нет заполненных строк;
+ * - счет в пределах игры не уменьшается, рекорд не меньше счета;
+ * - уровень и скорость соответствуют формуле от счета;
+ * - хеш поля совпадает с посчитанным заново.
+ * При нарушении печатается описание и вызывается abort(), чтобы фаззер
+ * сохранил вход.
+ *
+ * Сборка (make fuzz) - с ASan и UBSan. Режимы запуска:
+ * - fuzz_fsm --random N [seed] - N шагов случайного ввода (стресс-тест);
+ * - fuzz_fsm FILE... - прогон входов из файлов (воспроизведение);
+ * - fuzz_fsm < FILE - вход из stdin (AFL);
+ * - с -DTETRIS_LIBFUZZER main не собирается, точка входа для libFuzzer -
+ *   LLVMFuzzerTestOneInput (make fuzz_libfuzzer, нужен clang).
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../brick_game/tetris/s21_tetris_bot.h"
+#include "../brick_game/tetris/s21_tetris_fsm.h"
+#include "../brick_game/tetris/s21_tetris_timing.h"
+
+// Количество вариантов действия (Start ... Hold)
+#define FUZZ_ACTIONS (Hold + 1)
+// Варианты байта: действия, нажатие / отпускание Left, Right, Down, шаги
+// времени
+#define FUZZ_CODES (FUZZ_ACTIONS + 4)
+// В стресс-тесте в среднем каждый FUZZ_ANY_BYTE-й байт произвольный
+#define FUZZ_ANY_BYTE 64
+// Размер буфера для входа из файла / stdin
+#define FUZZ_MAX_INPUT (1 << 20)
+
+/// @brief Состояние проверки инвариантов между шагами
+typedef struct {
+  /// Счет после предыдущего шага
+  int score;
+  /// Количество выполненных шагов
+  long long steps;
+} fuzz_check_t;
+
+/**
+ * @brief Сообщение о нарушении инварианта и аварийное завершение.
+ */
+static void fuzzFail(const engine_t *engine, const fuzz_check_t *check,
+                     const char *what) {
+  fprintf(stderr, "invariant violated after step %lld: %s (state %d)\n",
+          check->steps, what, engine->state);
+  abort();
+}
+
+/**
+ * @brief Проверка инвариантов после шага FSM.
+ * @param engine Игра после шага.
+ * @param check Состояние проверки. Обновляется.
+ * @param new_game Шаг мог начать новую игру (счет сбрасывается).
+ */
+static void fuzzCheck(const engine_t *engine, fuzz_check_t *check,
+                      bool new_game) {
+  const GameInfo_t *game_info = &engine->game_info;
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  check->steps++;
+  if (game_info->field == NULL) return;
+  if (engine->state == SPAWN || engine->state == ATTACHING)
+    fuzzFail(engine, check, "step ended in an automatic state");
+  // Клетки текущей фигуры на поле; для проверки строк они исключаются
+  int piece_cells[FIELD_ROWS] = {0};
+  if (engine->state == MOVING || engine->state == PAUSE) {
+    for (int i = 0; i < PIECE_ROWS; i++) {
+      for (int j = 0; j < PIECE_COLUMNS; j++) {
+        if (!fsm_addinfo->piece[i][j]) continue;
+        int row = fsm_addinfo->row_pos + i, col = fsm_addinfo->col_pos + j;
+        if (row < 0 || row >= FIELD_ROWS || col < 0 || col >= FIELD_COLUMNS)
+          fuzzFail(engine, check, "piece cell outside the field");
+        if (game_info->field[row][col] != fsm_addinfo->piece[i][j])
+          fuzzFail(engine, check, "piece cell missing on the field");
+        piece_cells[row]++;
+      }
+    }
+    for (int i = 0; i < FIELD_ROWS; i++) {
+      int filled = 0;
+      for (int j = 0; j < FIELD_COLUMNS; j++) filled += !!game_info->field[i][j];
+      if (filled - piece_cells[i] == FIELD_COLUMNS)
+        fuzzFail(engine, check, "filled row survived ATTACHING");
+    }
+  }
+  // Очередь и отложенная фигура - допустимые id фигур
+  for (int i = 0; i < PREVIEW_MAX - 1; i++)
+    if (fsm_addinfo->queue[i] >= PIECE_TYPES * 4)
+      fuzzFail(engine, check, "invalid piece in the preview queue");
+  if (fsm_addinfo->has_hold &&
+      (fsm_addinfo->hold_id < 0 || fsm_addinfo->hold_id >= PIECE_TYPES))
+    fuzzFail(engine, check, "invalid hold piece");
+  // Счет сбрасывается только при старте новой игры
+  if (game_info->score < check->score && !new_game)
+    fuzzFail(engine, check, "score decreased");
+  check->score = game_info->score;
+  if (game_info->high_score < game_info->score)
+    fuzzFail(engine, check, "high score below score");
+  if (engine->state == MOVING || engine->state == PAUSE ||
+      engine->state == GAMEOVER) {
+    int level = 1 + game_info->score / 600;
+    if (level > 10) level = 10;
+    if (game_info->level != level)
+      fuzzFail(engine, check, "level does not match score");
+    if (game_info->speed != START_SPEED - (level - 1) * STEP_SPEED)
+      fuzzFail(engine, check, "speed does not match level");
+  }
+  if (game_info->hash != fieldHash(game_info->field))
+    fuzzFail(engine, check, "field hash out of sync");
+}
+
+/**
+ * @brief Один шаг из байта входа: действие и hold, нажатие (hold) или
+ * отпускание клавиши с автоповтором, шаг времени (с hold - сразу на всю
+ * задержку фиксации).
+ */
+static void fuzzStep(engine_t *engine, fuzz_check_t *check, uint8_t byte) {
+  int code = (byte & 0x7f) % FUZZ_CODES;
+  bool hold = byte & 0x80;
+  // Старт из START и повторное создание массивов сбрасывают счет
+  bool new_game = engine->state == START || (code == Start && hold);
+  if (code < FUZZ_ACTIONS) {
+    engineInput(engine, (UserAction_t)code, hold);
+  } else if (code < FUZZ_CODES - 1) {
+    static const UserAction_t keys[3] = {Left, Right, Down};
+    engineKey(engine, keys[code - FUZZ_ACTIONS], hold);
+  } else {
+    engineTick(engine, hold ? TIMING_LOCK_DELAY + 1 : 1);
+  }
+  fuzzCheck(engine, check, new_game);
+}
+
+/**
+ * @brief Прогон одного входа: новая игра (seed - первые 4 байта), затем по
+ * одному шагу на каждый байт.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  engine_t engine = {.state = START};
+  fuzz_check_t check = {0};
+  engineInput(&engine, Start, true);
+  if (size >= 4) {
+    memcpy(&engine.addinfo.seed, data, 4);
+    data += 4;
+    size -= 4;
+  }
+  for (size_t i = 0; i < size; i++) fuzzStep(&engine, &check, data[i]);
+  engineInput(&engine, Terminate, true);
+  return 0;
+}
+
+#ifndef TETRIS_LIBFUZZER
+
+/**
+ * @brief Стресс-тест: steps шагов случайного ввода в одной игре.
+ *
+ * Чтобы партии были длинными и удаляли строки, в основном подаются
+ * движения фигуры: в основном от бота (глубина 1), 1/8 - случайные;
+ * из START, PAUSE и GAMEOVER игра сразу продолжается.
+ * Каждый FUZZ_ANY_BYTE-й (в среднем) байт - произвольный (пауза, выход,
+ * создание и удаление массивов и т.п.).
+ */
+static void fuzzRandom(long long steps, unsigned int seed) {
+  engine_t engine = {.state = START};
+  fuzz_check_t check = {0};
+  unsigned long long rnd = seed;
+  engineInput(&engine, Start, true);
+  engine.addinfo.seed = seed;
+  long long start = metricsNow();
+  static const uint8_t moves[8] = {Left,   Right, Action, ActionCCW,
+                                   Down,   Down,  Down,   Down | 0x80};
+  bot_t *bot = botCreate(0);
+  if (bot == NULL) return;
+  bot->max_depth = 1;
+  for (long long i = 0; i < steps; i++) {
+    rnd = rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint8_t byte = (uint8_t)(rnd >> 56);
+    bool hold = false;
+    UserAction_t action = Up;
+    if (engine.state == START || engine.state == GAMEOVER)
+      action = Start;
+    else if (engine.state == PAUSE)
+      action = Pause;
+    else if (engine.game_info.field != NULL && (rnd >> 32) & 7)
+      action = botAction(bot, &engine, &hold);
+    if ((rnd >> 40) % FUZZ_ANY_BYTE == 0) {
+      // произвольный байт
+    } else if (action != Up) {
+      byte = (uint8_t)(action | (hold ? 0x80 : 0));
+    } else {
+      byte = moves[(byte >> 3) % 8];
+    }
+    fuzzStep(&engine, &check, byte);
+  }
+  botDestroy(bot);
+  double sec = (metricsNow() - start) / 1e9;
+  unsigned long long lines = 0;
+  for (int i = 1; i <= PIECE_ROWS; i++) lines += engine.metrics.clears[i] * i;
+  printf("%lld steps, %.0f steps/min, %llu games, %llu lines, "
+         "invariants hold\n",
+         steps, sec > 0 ? steps / sec * 60 : 0,
+         (unsigned long long)engine.metrics.games_started, lines);
+  engineInput(&engine, Terminate, true);
+}
+
+/**
+ * @brief Прогон входа из открытого файла.
+ */
+static void fuzzFile(FILE *file) {
+  static uint8_t data[FUZZ_MAX_INPUT];
+  size_t size = fread(data, 1, sizeof(data), file);
+  LLVMFuzzerTestOneInput(data, size);
+}
+
+int main(int argc, char **argv) {
+  int res = 0;
+  if (argc > 2 && strcmp(argv[1], "--random") == 0) {
+    fuzzRandom(atoll(argv[2]), argc > 3 ? (unsigned int)atol(argv[3]) : 1);
+  } else if (argc > 1) {
+    for (int i = 1; i < argc && !res; i++) {
+      FILE *file = fopen(argv[i], "rb");
+      if (file == NULL) {
+        fprintf(stderr, "%s: cannot open\n", argv[i]);
+        res = 1;
+      } else {
+        fuzzFile(file);
+        fclose(file);
+      }
+    }
+  } else {
+    fuzzFile(stdin);
+  }
+  return res;
+}
+
+#endif  // TETRIS_LIBFUZZER
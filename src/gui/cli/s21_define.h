@@ -18,14 +18,29 @@
 // Коды некоторых клавиш
 #define ESCAPE_KEY 27
 #define ENTER_KEY 10
+// Клавиша с автоповтором считается удерживаемой, если ее первый повтор
+// терминала пришел не позже этого времени после нажатия, нс (задержка
+// автоповтора терминала - 250-600 мс)
+#define KEY_REPEAT_DELAY_NS 650000000LL
+// Удерживаемая клавиша считается отпущенной, если ее повторы терминала
+// (раз в 30-50 мс) не приходят дольше этого времени, нс
+#define KEY_RELEASE_NS 100000000LL
 
 // Начальные координаты для печати доп.инфо игры
 #define SCORE_ROW 1
 #define SCORE_COL FIELD_COLUMNS * 2 + 2
+// Панель отложенной фигуры и очереди: столбец разделителя и ширина
+#define HOLD_PANEL_COL (FIELD_COLUMNS * 2 + 21)
+#define HOLD_PANEL_WIDTH 11
+// Количество показываемых фигур очереди (включая следующую) по умолчанию
+#define PREVIEW_DEFAULT 3
 
 // Символы для печати фигур, каждый "пиксель" из двух символов
 #define LEFT_CHAR '['
 #define RIGHT_CHAR ']'
+// Символы клеток подсказки хода (--hint)
+#define HINT_LEFT_CHAR '('
+#define HINT_RIGHT_CHAR ')'
 
 // состояния для FSM
 typedef enum {
@@ -47,15 +62,24 @@ typedef enum {
   Right,
   Up,
   Down,
-  Action
+  Action,
+  // Вращение фигуры против часовой стрелки
+  ActionCCW,
+  // Отложить фигуру (hold) или обменять на отложенную
+  Hold
 } UserAction_t;
 
-/// @brief Структура данных для отрисовки в интерфейсе (по ТЗ)
+/// @brief Клетка поля и шаблона фигуры: 0 - пусто, 1-7 - цвет (id фигуры +
+/// 1). Байт вместо int: поле 10x20 занимает 200 байт (несколько строк кеша)
+typedef unsigned char cell_t;
+
+/// @brief Структура данных для отрисовки в интерфейсе (по ТЗ, клетки -
+/// cell_t)
 typedef struct {
   /// Игровое поле
-  int **field;
+  cell_t **field;
   /// Следующая фигура
-  int **next;
+  cell_t **next;
   /// Количество набранных очков
   int score;
   /// Текущий рекорд
@@ -66,8 +90,24 @@ typedef struct {
   int speed;
   /// Режим Паузы и другие режимы GUI
   int pause;
+  /// Хеш Зобриста заполнения поля (отпечаток поля для сравнения игр)
+  unsigned long long hash;
 } GameInfo_t;
 
+/**
+ * @brief Цвет клетки поля (0 - пусто).
+ */
+static inline int fieldCell(const GameInfo_t *game_info, int row, int col) {
+  return game_info->field[row][col];
+}
+
+/**
+ * @brief Цвет клетки шаблона следующей фигуры (0 - пусто).
+ */
+static inline int nextCell(const GameInfo_t *game_info, int row, int col) {
+  return game_info->next[row][col];
+}
+
 #define SUCCESSFUL_EXIT 0
 #define FAILURE_EXIT 1
 
@@ -0,0 +1,187 @@
+/**
+ * @file s21_headless.c
+ * @brief Игра без терминала (--headless): источник ввода и времени для
+ * игрового цикла tetrisGame.
+ *
+ * Клавиши берутся из сценария, после его конца игры запускаются
+ * автоматически: Enter в стартовом окне и после конца игры, фигурами
+ * управляет бот или каждая фигура сразу сбрасывается вниз; после --games
+ * игр - выход (Esc). Кадры собираются в памяти (SCREEN_MEMORY). Так весь
+ * цикл игры - определение действий по клавишам (defineAction), шаги
+ * времени, планировщик кадров и отрисовка - проверяется и замеряется без
+ * терминала и реального времени.
+ *
+ * Сценарий - текстовый файл, строка на клавишу: время от начала работы в мс
+ * и клавиша (left, right, up, down, enter, esc, space или один символ).
+ * Строки с # и пустые пропускаются. Удержание клавиши с автоповтором
+ * записывается повторами клавиши, как их присылает терминал.
+ */
+#include "s21_headless.h"
+
+#include <ncurses.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../brick_game/tetris/s21_tetris_fsm.h"
+#include "../../brick_game/tetris/s21_tetris_metrics.h"
+
+/**
+ * @brief Код клавиши по имени из сценария.
+ * @return Код клавиши или ERR для неизвестного имени.
+ */
+static int headlessKeyCode(const char *name) {
+  static const struct {
+    const char *name;
+    int key;
+  } names[] = {{"left", KEY_LEFT},   {"right", KEY_RIGHT}, {"up", KEY_UP},
+               {"down", KEY_DOWN},   {"enter", ENTER_KEY}, {"esc", ESCAPE_KEY},
+               {"space", ' '}};
+  int key = strlen(name) == 1 ? name[0] : ERR;
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    if (strcmp(name, names[i].name) == 0) key = names[i].key;
+  return key;
+}
+
+/**
+ * @brief Чтение сценария.
+ * @return 0 - успешно, 1 - ошибка чтения, памяти или формата (время
+ * убывает, неизвестная клавиша).
+ */
+static int headlessLoad(headless_t *headless, const char *script) {
+  FILE *file = fopen(script, "r");
+  int res = file == NULL ? FAILURE_EXIT : SUCCESSFUL_EXIT;
+  int size = 0;
+  char line[128];
+  while (!res && fgets(line, sizeof(line), file) != NULL) {
+    long long time_ms;
+    char name[16];
+    if (line[strspn(line, " \t\r\n")] == '\0' || line[0] == '#') continue;
+    if (sscanf(line, "%lld %15s", &time_ms, name) != 2) res = FAILURE_EXIT;
+    headless_key_t key = {time_ms * 1000000, ERR};
+    if (!res) key.key = headlessKeyCode(name);
+    const headless_key_t *last =
+        headless->count ? &headless->keys[headless->count - 1] : NULL;
+    if (key.key == ERR || (last != NULL && key.time < last->time))
+      res = FAILURE_EXIT;
+    if (!res && headless->count == size) {
+      size = size ? 2 * size : HEADLESS_KEYS_INIT;
+      headless_key_t *keys = realloc(headless->keys, size * sizeof(*keys));
+      if (keys == NULL) res = FAILURE_EXIT;
+      if (keys != NULL) headless->keys = keys;
+    }
+    if (!res) headless->keys[headless->count++] = key;
+  }
+  if (file != NULL) fclose(file);
+  return res;
+}
+
+/**
+ * @brief Начальная настройка.
+ * @param script Файл сценария или NULL - без сценария.
+ * @param games Игр после конца сценария.
+ * @param bot После конца сценария фигурами управляет бот игрового цикла.
+ * @return 0 - успешно, 1 - ошибка чтения сценария.
+ */
+int headlessInit(headless_t *headless, const char *script, long long games,
+                 bool bot) {
+  *headless = (headless_t){0};
+  headless->games = games;
+  headless->bot = bot;
+  headless->last_state = START;
+  headless->start_ns = metricsNow();
+  int res = script != NULL ? headlessLoad(headless, script) : SUCCESSFUL_EXIT;
+  if (res) headlessDestroy(headless);
+  return res;
+}
+
+/**
+ * @brief Учет законченных игр по состоянию игры GUI.
+ */
+static void headlessObserve(headless_t *headless, const engine_t *engine) {
+  if (engine->state == GAMEOVER && headless->last_state != GAMEOVER) {
+    int score = engine->game_info.score;
+    headless->finished++;
+    headless->score_sum += score;
+    if (score > headless->score_max) headless->score_max = score;
+  }
+  headless->last_state = engine->state;
+}
+
+/**
+ * @brief Клавиша после конца сценария: одна за опрос, затем опрос без
+ * нажатия (время идет).
+ */
+static int headlessAutoKey(headless_t *headless, tetris_state state) {
+  int key = ERR;
+  if (state == START && headless->started < headless->games) {
+    key = ENTER_KEY;
+    headless->started++;
+  } else if (state == START) {
+    key = ESCAPE_KEY;
+  } else if (state == GAMEOVER) {
+    key = ENTER_KEY;
+  } else if (state == PAUSE) {
+    key = 'p';
+  } else if (!headless->bot) {
+    key = KEY_DOWN;
+  }
+  return key;
+}
+
+/**
+ * @brief Следующая клавиша, замена getch() игрового цикла.
+ *
+ * Клавиша сценария возвращается, когда подошло ее время. Опрос без нажатия
+ * (ERR) сдвигает виртуальное время на HEADLESS_POLL_NS.
+ * @param context headless_t.
+ * @return Код клавиши или ERR.
+ */
+int headlessKey(void *context) {
+  headless_t *headless = context;
+  const engine_t *engine = fsmGuiEngine();
+  headlessObserve(headless, engine);
+  int key = ERR;
+  if (headless->next < headless->count) {
+    if (headless->keys[headless->next].time <= headless->now)
+      key = headless->keys[headless->next++].key;
+  } else if (!headless->auto_pressed) {
+    key = headlessAutoKey(headless, engine->state);
+  }
+  headless->auto_pressed = key != ERR && headless->next == headless->count;
+  if (key == ERR) headless->now += HEADLESS_POLL_NS;
+  return key;
+}
+
+/**
+ * @brief Виртуальное время, замена metricsNow() игрового цикла.
+ * @param context headless_t.
+ */
+long long headlessNow(void *context) {
+  return ((const headless_t *)context)->now;
+}
+
+/**
+ * @brief Печать итогов: игры, очки, виртуальное и реальное время.
+ */
+void headlessPrintStats(const headless_t *headless, FILE *file) {
+  double real = (metricsNow() - headless->start_ns) / 1e9;
+  double game = headless->now / 1e9;
+  fprintf(file, "headless games: %lld finished\n", headless->finished);
+  fprintf(file, "headless score: %.1f avg, %d max\n",
+          headless->finished ? (double)headless->score_sum / headless->finished
+                             : 0.,
+          headless->score_max);
+  fprintf(file, "headless time:  %.1f s game, %.3f s real (x%.0f)\n", game,
+          real, real > 0 ? game / real : 0.);
+  fprintf(file, "headless speed: %.0f games/s\n",
+          real > 0 ? headless->finished / real : 0.);
+}
+
+/**
+ * @brief Освобождение сценария.
+ */
+void headlessDestroy(headless_t *headless) {
+  free(headless->keys);
+  headless->keys = NULL;
+  headless->count = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef TETRIS_HEADLESS_H
+#define TETRIS_HEADLESS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "s21_define.h"
+
+// Период опроса клавиатуры без нажатий, нс (как timeout(10) ncurses)
+#define HEADLESS_POLL_NS 10000000LL
+// Начальный размер массива клавиш сценария
+#define HEADLESS_KEYS_INIT 256
+
+/// @brief Клавиша сценария
+typedef struct {
+  /// Время нажатия от начала работы, нс
+  long long time;
+  /// Код клавиши, как его возвращает getch()
+  int key;
+} headless_key_t;
+
+/// @brief Игра без терминала: клавиши из сценария и виртуальное время.
+///
+/// Время идет только в опросах клавиатуры без нажатий (на HEADLESS_POLL_NS,
+/// как ожидание getch()), поэтому цикл игры выполняется так быстро, как
+/// позволяет процессор, а его поведение не зависит от скорости машины.
+typedef struct {
+  /// Клавиши сценария по возрастанию времени и следующая из них
+  headless_key_t *keys;
+  int count;
+  int next;
+  /// Виртуальное время, нс
+  long long now;
+  /// Игр до выхода после конца сценария (0 - выход сразу)
+  long long games;
+  /// Ввод после конца сценария - бот (иначе каждая фигура сразу падает)
+  bool bot;
+  /// Начато игр после конца сценария
+  long long started;
+  /// Прошлый опрос вернул клавишу после конца сценария (следующий - без
+  /// нажатия)
+  bool auto_pressed;
+  /// Закончено игр (переходов в GAMEOVER), сумма и максимум очков
+  long long finished;
+  long long score_sum;
+  int score_max;
+  /// Состояние игры при прошлом опросе
+  int last_state;
+  /// Реальное время начала работы, нс
+  long long start_ns;
+} headless_t;
+
+int headlessInit(headless_t *headless, const char *script, long long games,
+                 bool bot);
+int headlessKey(void *context);
+long long headlessNow(void *context);
+void headlessPrintStats(const headless_t *headless, FILE *file);
+void headlessDestroy(headless_t *headless);
+
+#endif  // TETRIS_HEADLESS_H
@@ -0,0 +1,132 @@
+/**
+ * @file s21_render.c
+ * @brief Планировщик отрисовки с ограничением частоты кадров.
+ *
+ * Изменения состояния игры только помечают экран устаревшим, перерисовка
+ * выполняется не чаще frame_interval. Смена режима GUI (старт, пауза, конец
+ * игры) выводится сразу. Так объем вывода в терминал ограничен частотой
+ * кадров, а не частотой нажатий клавиш.
+ */
+#include "s21_render.h"
+
+#include "s21_screen.h"
+#include "s21_tetris_frontend.h"
+
+/**
+ * @brief Монотонное время в наносекундах (часы по умолчанию).
+ */
+static long long renderClock(void *context) {
+  (void)context;
+  return metricsNow();
+}
+
+/**
+ * @brief Вывод кадра с замером времени.
+ */
+static void renderFrame(render_t *render, GameInfo_t *game_info) {
+  long long start = metricsNow();
+  // Пауза выводит только надпись, поэтому отложенные изменения поля
+  // выводятся до нее
+  if (render->dirty && game_info->pause == PAUSE_MODE &&
+      render->last_mode == GAME_MODE) {
+    GameInfo_t last_game = *game_info;
+    last_game.pause = GAME_MODE;
+    printGameScreen(&last_game);
+  }
+  printGameScreen(game_info);
+  long long bytes = screenRefresh();
+  long long end = metricsNow();
+  if (bytes >= 0) {
+    render->bytes_sum += bytes;
+    if (bytes > render->bytes_max) render->bytes_max = bytes;
+    render->bytes_frames++;
+  }
+  render->frame_time_sum += end - start;
+  if (end - start > render->frame_time_max) {
+    render->frame_time_max = end - start;
+  }
+  render->frames++;
+  render->last_frame = render->clock(render->clock_context);
+  render->last_mode = game_info->pause;
+  render->dirty = false;
+}
+
+/**
+ * @brief Начальная настройка планировщика.
+ * @param fps Максимальная частота кадров. 0 и меньше - без ограничения.
+ */
+void renderInit(render_t *render, int fps) {
+  render->frame_interval = fps > 0 ? 1000000000LL / fps : 0;
+  render->last_frame = 0;
+  render->dirty = false;
+  render->last_mode = START_MODE;
+  render->frames = 0;
+  render->dropped = 0;
+  render->frame_time_sum = 0;
+  render->frame_time_max = 0;
+  render->bytes_sum = 0;
+  render->bytes_max = 0;
+  render->bytes_frames = 0;
+  render->clock = renderClock;
+  render->clock_context = NULL;
+}
+
+/**
+ * @brief Часы интервала кадров. Время вывода кадра (статистика) всегда
+ * замеряется монотонными часами.
+ * @param clock Текущее время, нс.
+ * @param context Передается в clock.
+ */
+void renderSetClock(render_t *render, long long (*clock)(void *context),
+                    void *context) {
+  render->clock = clock;
+  render->clock_context = context;
+}
+
+/**
+ * @brief Учет изменения состояния игры. При смене режима GUI кадр выводится
+ * сразу, иначе - при следующем renderTick, когда подойдет время кадра.
+ * @param game_info Инфо о текущем состоянии игры
+ */
+void renderUpdate(render_t *render, GameInfo_t *game_info) {
+  // Предыдущее изменение так и не попало на экран
+  if (render->dirty) render->dropped++;
+  render->dirty = true;
+  if (game_info->pause != render->last_mode) {
+    renderFrame(render, game_info);
+  } else {
+    renderTick(render, game_info);
+  }
+}
+
+/**
+ * @brief Вывод отложенных изменений, если прошел интервал кадра.
+ * @param game_info Инфо о текущем состоянии игры
+ */
+void renderTick(render_t *render, GameInfo_t *game_info) {
+  if (render->dirty) {
+    long long now = render->clock(render->clock_context);
+    if (now - render->last_frame >= render->frame_interval)
+      renderFrame(render, game_info);
+  }
+}
+
+/**
+ * @brief Печать статистики вывода кадров.
+ */
+void renderPrintStats(const render_t *render, FILE *file) {
+  double avg = render->frames
+                   ? (double)render->frame_time_sum / render->frames / 1000.
+                   : 0;
+  fprintf(file, "frames:         %llu\n", render->frames);
+  fprintf(file, "dropped frames: %llu\n", render->dropped);
+  fprintf(file, "frame time:     %.1f us avg, %.1f us max\n", avg,
+          render->frame_time_max / 1000.);
+  if (render->bytes_frames) {
+    fprintf(file, "frame bytes:    %.1f avg, %lld max, %lld total\n",
+            (double)render->bytes_sum / render->bytes_frames,
+            render->bytes_max, render->bytes_sum);
+  } else {
+    fprintf(file, "frame bytes:    n/a\n");
+  }
+}
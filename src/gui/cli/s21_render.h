@@ -0,0 +1,48 @@
+#ifndef TETRIS_RENDER_H
+#define TETRIS_RENDER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "s21_define.h"
+
+// Частота кадров по умолчанию, кадров в секунду
+#define RENDER_FPS 60
+
+/// @brief Планировщик отрисовки: объединяет изменения состояния игры и
+/// перерисовывает экран не чаще заданной частоты.
+typedef struct {
+  /// Минимальный интервал между кадрами, нс
+  long long frame_interval;
+  /// Время последнего кадра, нс
+  long long last_frame;
+  /// Есть изменения, еще не выведенные на экран
+  bool dirty;
+  /// Режим GUI (game_info.pause) последнего кадра
+  int last_mode;
+  /// Выведено кадров
+  unsigned long long frames;
+  /// Изменений состояния, объединенных с последующими (пропущенные кадры)
+  unsigned long long dropped;
+  /// Суммарное и максимальное время вывода кадра, нс
+  long long frame_time_sum;
+  long long frame_time_max;
+  /// Суммарное и максимальное количество байт кадра, выведенных в
+  /// терминал; bytes_frames - кадров с известным количеством байт
+  long long bytes_sum;
+  long long bytes_max;
+  unsigned long long bytes_frames;
+  /// Часы интервала кадров, нс, и их контекст (renderInit - монотонные,
+  /// для игры без терминала - виртуальные)
+  long long (*clock)(void *context);
+  void *clock_context;
+} render_t;
+
+void renderInit(render_t *render, int fps);
+void renderSetClock(render_t *render, long long (*clock)(void *context),
+                    void *context);
+void renderUpdate(render_t *render, GameInfo_t *game_info);
+void renderTick(render_t *render, GameInfo_t *game_info);
+void renderPrintStats(const render_t *render, FILE *file);
+
+#endif  // TETRIS_RENDER_H
@@ -0,0 +1,225 @@
+/**
+ * @file s21_screen.c
+ * @brief Вывод экрана игры: через ncurses или своим ANSI-рендерером.
+ *
+ * Функции отрисовки (printGameScreen и др.) рисуют через screenAddCh /
+ * screenPrintw. В режиме SCREEN_NCURSES это mvaddch / mvprintw. В режиме
+ * SCREEN_ANSI кадр собирается в массив символов с атрибутами, при
+ * screenRefresh сравнивается с выведенным ранее и изменения выводятся одной
+ * строкой управляющих последовательностей ANSI за один write(). Клавиатура
+ * в обоих режимах читается через ncurses. В режиме SCREEN_MEMORY кадр
+ * собирается так же, как в SCREEN_ANSI, но не выводится: ncurses не
+ * нужен.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "s21_screen.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Атрибуты, которые выводит ANSI-рендерер: цвет и набор символов рамки
+#define SCREEN_ATTRS (A_COLOR | A_ALTCHARSET)
+
+// Экран, на котором рисуют функции отрисовки (NULL - ncurses)
+static screen_t *current = NULL;
+
+/**
+ * @brief Начальная настройка экрана. Вызывается после инициализации
+ * ncurses (кроме SCREEN_MEMORY).
+ * @param backend Способ вывода.
+ * @param fd Дескриптор терминала для SCREEN_ANSI.
+ * @param count_bytes Для SCREEN_NCURSES считать байты вывода кадра.
+ */
+void screenInit(screen_t *screen, screen_backend_t backend, int fd,
+                bool count_bytes) {
+  screen->backend = backend;
+  screen->fd = fd;
+  screen->count_bytes = count_bytes;
+  for (int i = 0; i < SCREEN_ROWS; i++) {
+    for (int j = 0; j < SCREEN_COLS; j++) {
+      screen->cells[i][j] = ' ';
+      screen->shown[i][j] = ' ';
+    }
+  }
+  screen->shown_valid = false;
+  screen->attr = -1;
+  if (backend == SCREEN_ANSI) {
+    // Первый refresh ncurses очищает терминал - он должен пройти до
+    // вывода кадров; курсор ncurses больше не перемещает
+    leaveok(stdscr, TRUE);
+    refresh();
+  }
+}
+
+/**
+ * @brief Выбор экрана для функций отрисовки. NULL - напрямую ncurses.
+ */
+void screenUse(screen_t *screen) { current = screen; }
+
+/**
+ * @brief Символ с атрибутами в позицию (row, col).
+ */
+void screenAddCh(int row, int col, chtype ch) {
+  if (current == NULL || current->backend == SCREEN_NCURSES) {
+    mvaddch(row, col, ch);
+  } else if (row >= 0 && row < SCREEN_ROWS && col >= 0 && col < SCREEN_COLS) {
+    current->cells[row][col] = ch;
+  }
+}
+
+/**
+ * @brief Форматированная строка с позиции (row, col), как mvprintw.
+ */
+void screenPrintw(int row, int col, const char *format, ...) {
+  char text[SCREEN_COLS + 1];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (current == NULL || current->backend == SCREEN_NCURSES) {
+    mvaddstr(row, col, text);
+  } else {
+    for (int i = 0; text[i]; i++) screenAddCh(row, col + i, text[i]);
+  }
+}
+
+/**
+ * @brief Очистка экрана.
+ */
+void screenClear() {
+  if (current == NULL || current->backend == SCREEN_NCURSES) {
+    clear();
+  } else {
+    for (int i = 0; i < SCREEN_ROWS; i++)
+      for (int j = 0; j < SCREEN_COLS; j++) current->cells[i][j] = ' ';
+  }
+}
+
+/**
+ * @brief Счетчик байт, записанных процессом (wchar из /proc/self/io).
+ * @return Количество байт или -1, если счетчик недоступен.
+ */
+static long long screenWrittenBytes() {
+  long long bytes = -1;
+  FILE *file = fopen("/proc/self/io", "r");
+  if (file != NULL) {
+    char line[64];
+    while (bytes < 0 && fgets(line, sizeof(line), file) != NULL)
+      if (sscanf(line, "wchar: %lld", &bytes) != 1) bytes = -1;
+    fclose(file);
+  }
+  return bytes;
+}
+
+/**
+ * @brief Добавление в буфер кадра последовательности смены атрибутов.
+ * @param len Заполнено байт буфера.
+ * @param attr Нужные атрибуты (SCREEN_ATTRS).
+ * @return Новая длина буфера.
+ */
+static int screenSetAttr(screen_t *screen, int len, long long attr) {
+  if (attr == screen->attr) return len;
+  int size = SCREEN_OUT_SIZE;
+  if (screen->attr < 0 || ((attr ^ screen->attr) & A_ALTCHARSET)) {
+    // Набор символов DEC для линий рамки или обычный ASCII
+    len += snprintf(screen->out + len, size - len, "\033(%c",
+                    (attr & A_ALTCHARSET) ? '0' : 'B');
+  }
+  if (screen->attr < 0 || ((attr ^ screen->attr) & A_COLOR)) {
+    short fg = -1, bg = -1;
+    // Без ncurses (SCREEN_MEMORY) цвет - номер пары
+    if (PAIR_NUMBER(attr) != 0 && screen->backend == SCREEN_MEMORY)
+      fg = PAIR_NUMBER(attr) % 8;
+    else if (PAIR_NUMBER(attr) != 0)
+      pair_content(PAIR_NUMBER(attr), &fg, &bg);
+    if (fg < 0 && bg < 0) {
+      len += snprintf(screen->out + len, size - len, "\033[0m");
+    } else {
+      len += snprintf(screen->out + len, size - len, "\033[%d;%dm",
+                      fg < 0 ? 39 : 30 + fg, bg < 0 ? 49 : 40 + bg);
+    }
+  }
+  screen->attr = attr;
+  return len;
+}
+
+/**
+ * @brief Вывод разницы собранного и выведенного кадров одним write()
+ * (SCREEN_MEMORY - без вывода).
+ *
+ * Курсор перемещается только к измененным клеткам; короткий пропуск
+ * неизменных клеток в той же строке переписывается символами, если для
+ * этого не нужно менять атрибуты. Атрибуты меняются только при отличии от
+ * текущих.
+ * @return Количество выведенных байт.
+ */
+static long long screenFlush(screen_t *screen) {
+  int len = 0, cur_row = -1, cur_col = -1;
+  for (int i = 0; i < SCREEN_ROWS; i++) {
+    for (int j = 0; j < SCREEN_COLS; j++) {
+      chtype ch = screen->cells[i][j];
+      if (screen->shown_valid && ch == screen->shown[i][j]) continue;
+      if (i != cur_row || j != cur_col) {
+        bool rewrite = i == cur_row && j - cur_col < SCREEN_SKIP_REWRITE;
+        for (int k = cur_col; rewrite && k < j; k++)
+          rewrite = (screen->cells[i][k] & SCREEN_ATTRS) == screen->attr;
+        if (rewrite) {
+          for (int k = cur_col; k < j; k++)
+            screen->out[len++] = screen->cells[i][k] & A_CHARTEXT;
+        } else {
+          len += snprintf(screen->out + len, SCREEN_OUT_SIZE - len,
+                          "\033[%d;%dH", i + 1, j + 1);
+        }
+      }
+      len = screenSetAttr(screen, len, ch & SCREEN_ATTRS);
+      screen->out[len++] = ch & A_CHARTEXT;
+      screen->shown[i][j] = ch;
+      cur_row = i;
+      cur_col = j + 1;
+    }
+  }
+  screen->shown_valid = true;
+  int done = screen->backend == SCREEN_MEMORY ? len : 0;
+  while (done < len) {
+    ssize_t res = write(screen->fd, screen->out + done, len - done);
+    if (res < 0 && errno == EINTR) continue;
+    if (res <= 0) break;
+    done += res;
+  }
+  return len;
+}
+
+/**
+ * @brief Вывод кадра на терминал.
+ * @return Количество байт, выведенных в терминал, -1 - неизвестно (ncurses
+ * без подсчета).
+ */
+long long screenRefresh() {
+  long long bytes = -1;
+  if (current == NULL || current->backend == SCREEN_NCURSES) {
+    long long before =
+        current != NULL && current->count_bytes ? screenWrittenBytes() : -1;
+    refresh();
+    if (before >= 0) {
+      long long after = screenWrittenBytes();
+      if (after >= 0) bytes = after - before;
+    }
+  } else {
+    bytes = screenFlush(current);
+  }
+  return bytes;
+}
+
+/**
+ * @brief Завершение вывода: сброс атрибутов терминала перед endwin().
+ */
+void screenClose(screen_t *screen) {
+  if (screen->backend == SCREEN_ANSI && screen->attr != 0) {
+    static const char reset[] = "\033[0m\033(B";
+    if (write(screen->fd, reset, sizeof(reset) - 1) < 0) screen->attr = -1;
+  }
+  if (current == screen) current = NULL;
+}
@@ -0,0 +1,60 @@
+#ifndef TETRIS_SCREEN_H
+#define TETRIS_SCREEN_H
+
+#include <ncurses.h>
+#include <stdbool.h>
+
+#include "s21_define.h"
+
+// Размер экрана игры: поле с рамкой, панель доп.инфо и панель отложенной
+// фигуры и очереди
+#define SCREEN_ROWS (FIELD_ROWS + 2)
+#define SCREEN_COLS (HOLD_PANEL_COL + HOLD_PANEL_WIDTH + 1)
+// Буфер вывода кадра: худший случай - у каждой клетки своя позиция,
+// цвет и набор символов
+#define SCREEN_OUT_SIZE (SCREEN_ROWS * SCREEN_COLS * 32)
+// Пропуск неизменных клеток короче этого переписывается символами,
+// а не перемещением курсора
+#define SCREEN_SKIP_REWRITE 4
+
+/// @brief Способ вывода кадра на терминал
+typedef enum {
+  /// mvaddch / mvprintw и refresh() ncurses
+  SCREEN_NCURSES = 0,
+  /// Свой буфер кадра, разница с прошлым кадром одной строкой ANSI
+  SCREEN_ANSI,
+  /// Как SCREEN_ANSI, но кадр только собирается в памяти (игра без
+  /// терминала, --headless)
+  SCREEN_MEMORY
+} screen_backend_t;
+
+/// @brief Экран игры: куда рисуют функции printGameScreen
+typedef struct {
+  /// Способ вывода
+  screen_backend_t backend;
+  /// Дескриптор терминала (SCREEN_ANSI, не используется в SCREEN_MEMORY)
+  int fd;
+  /// Считать байты вывода ncurses (по /proc/self/io, SCREEN_NCURSES)
+  bool count_bytes;
+  /// Кадр, который рисуется сейчас (символ с атрибутами ncurses)
+  chtype cells[SCREEN_ROWS][SCREEN_COLS];
+  /// Кадр на терминале
+  chtype shown[SCREEN_ROWS][SCREEN_COLS];
+  /// Содержимое терминала известно (после первого кадра)
+  bool shown_valid;
+  /// Текущие атрибуты терминала (цвет и набор символов), -1 - неизвестны
+  long long attr;
+  /// Байты кадра для write()
+  char out[SCREEN_OUT_SIZE];
+} screen_t;
+
+void screenInit(screen_t *screen, screen_backend_t backend, int fd,
+                bool count_bytes);
+void screenUse(screen_t *screen);
+void screenAddCh(int row, int col, chtype ch);
+void screenPrintw(int row, int col, const char *format, ...);
+void screenClear();
+long long screenRefresh();
+void screenClose(screen_t *screen);
+
+#endif  // TETRIS_SCREEN_H
@@ -0,0 +1,295 @@
+/**
+ * @file s21_server.c
+ * @brief Сервер сессий (--server TTY ...): несколько игр в одном процессе,
+ * каждая на своем терминале (последовательная линия или псевдотерминал
+ * моста telnet, например socat).
+ *
+ * У каждой сессии свой экран ncurses (newterm, переключение set_term), своя
+ * игра (fsmGuiUse), экран кадров (ncurses или ANSI-рендерер, --ansi),
+ * планировщик кадров и игровой цикл (tetrisLoopStep). Один цикл событий
+ * ждет ввода со всех терминалов (poll) не дольше SERVER_POLL_MS, затем
+ * проходит все сессии: клавиши, шаги времени, кадры. Сессия закрывается
+ * выходом из игры (Esc в стартовом окне) или обрывом терминала; сервер
+ * завершается, когда закрыты все сессии.
+ *
+ * Для каждой сессии учитываются память (прирост кучи при открытии: экран
+ * ncurses, буферы кадров, матрицы игры) и процессорное время ее проходов
+ * цикла; после выхода печатается сводка.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "s21_tetris.h"
+
+// Ожидание ввода без нажатий, мс (как timeout(10) одиночной игры)
+#define SERVER_POLL_MS 10
+// Ожидание продолжения escape-последовательности, мс: одиночный Esc
+// задерживает цикл всех сессий
+#define SERVER_ESCDELAY_MS 5
+
+/// @brief Сессия сервера: терминал, игра и учет ресурсов
+typedef struct {
+  /// Путь терминала, имя игрока в таблице рекордов - без "/dev/"
+  const char *path;
+  FILE *out;
+  FILE *in;
+  SCREEN *terminal;
+  screen_t screen;
+  render_t render;
+  engine_t engine;
+  bot_t *bot;
+  /// Подсказка хода (--hint) или NULL
+  hint_t *hint;
+  game_io_t io;
+  game_loop_t loop;
+  /// Сессия открыта
+  bool active;
+  /// Прирост кучи при открытии сессии, байт (-1 - неизвестно)
+  long long memory;
+  /// Процессорное время проходов цикла сессии, нс
+  long long cpu_ns;
+  /// Время открытия и закрытия сессии, нс
+  long long open_ns;
+  long long close_ns;
+} session_t;
+
+/**
+ * @brief Занятая память кучи, байт.
+ * @return -1, если неизвестно (не glibc).
+ */
+static long long serverHeap() {
+  long long res = -1;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 info = mallinfo2();
+  res = (long long)(info.uordblks + info.hblkhd);
+#endif
+  return res;
+}
+
+/**
+ * @brief Процессорное время процесса, нс.
+ */
+static long long serverCpu() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Клавиша терминала сессии (экран ncurses текущий, без ожидания).
+ */
+static int serverKey(void *context) {
+  (void)context;
+  return getch();
+}
+
+/**
+ * @brief Монотонное время для игрового цикла сессии.
+ */
+static long long serverNow(void *context) {
+  (void)context;
+  return metricsNow();
+}
+
+/**
+ * @brief Переключение на сессию: экран ncurses, экран кадров, игра GUI и
+ * подсказка хода.
+ */
+static void serverUse(session_t *session) {
+  set_term(session->terminal);
+  screenUse(&session->screen);
+  fsmGuiUse(&session->engine);
+  setHint(session->hint);
+}
+
+/**
+ * @brief Открытие сессии: терминал, экран ncurses, стартовое окно, игра.
+ * @return Сессия или NULL при ошибке (терминал не открывается или не
+ * поддерживается ncurses, нет памяти).
+ */
+static session_t *serverOpen(options_t *options, leaderboard_t *lb,
+                             const char *path) {
+  long long heap = serverHeap();
+  session_t *session = calloc(1, sizeof(session_t));
+  if (session == NULL) return NULL;
+  int fd = open(path, O_RDWR | O_NOCTTY);
+  int in_fd = fd >= 0 ? dup(fd) : -1;
+  if (in_fd >= 0) {
+    session->out = fdopen(fd, "w");
+    session->in = fdopen(in_fd, "r");
+  }
+  if (session->out != NULL && session->in != NULL)
+    session->terminal = newterm(NULL, session->out, session->in);
+  if (session->terminal == NULL) {
+    if (session->out != NULL)
+      fclose(session->out);
+    else if (fd >= 0)
+      close(fd);
+    if (session->in != NULL)
+      fclose(session->in);
+    else if (in_fd >= 0)
+      close(in_fd);
+    free(session);
+    return NULL;
+  }
+  session->path = path;
+  session->engine.state = START;
+  if (options->hint) session->hint = hintCreate(HINT_BUDGET);
+  session->io = (game_io_t){serverKey, serverNow, NULL};
+  serverUse(session);
+  cbreak();
+  noecho();
+  curs_set(0);
+  nodelay(stdscr, TRUE);
+  keypad(stdscr, TRUE);
+  set_escdelay(SERVER_ESCDELAY_MS);
+  ncursesColors();
+  screenInit(&session->screen, options->ansi ? SCREEN_ANSI : SCREEN_NCURSES,
+             fd, options->render_stats);
+  printWelcome();
+  screenRefresh();
+  userInput(Start, true);
+  userAdaptive(options->adaptive);
+  if (options->bot) session->bot = botCreate(options->bot_budget);
+  tetrisLoopInit(&session->loop, options, &session->render, session->bot, lb,
+                 &session->io);
+  session->loop.player = strncmp(path, "/dev/", 5) == 0 ? path + 5 : path;
+  session->active = true;
+  session->open_ns = metricsNow();
+  session->memory = heap >= 0 ? serverHeap() - heap : -1;
+  return session;
+}
+
+/**
+ * @brief Закрытие сессии: игра и экран ncurses (endwin). Статистика
+ * сессии остается.
+ *
+ * delscreen ncurses освобождает окна всех экранов, а не только своего,
+ * поэтому экраны ncurses и терминалы закрытых сессий освобождаются только
+ * при завершении сервера (serverFree).
+ */
+static void serverClose(session_t *session) {
+  serverUse(session);
+  userInput(Terminate, true);
+  botDestroy(session->bot);
+  session->bot = NULL;
+  screenClose(&session->screen);
+  endwin();
+  fsmGuiUse(NULL);
+  setHint(NULL);
+  session->active = false;
+  session->close_ns = metricsNow();
+}
+
+/**
+ * @brief Освобождение закрытой сессии: экран ncurses, терминал, память.
+ */
+static void serverFree(session_t *session) {
+  hintDestroy(session->hint);
+  delscreen(session->terminal);
+  fclose(session->out);
+  fclose(session->in);
+  free(session);
+}
+
+/**
+ * @brief Печать сводки: по каждой сессии кадры, память, процессорное время
+ * (всего, на кадр и доля одного ядра), затем время цикла вне сессий и
+ * оценка сессий на одно ядро.
+ */
+static void serverPrintStats(session_t **sessions, int count, long long wall,
+                             long long cpu, FILE *file) {
+  long long sessions_cpu = 0, sessions_time = 0;
+  fprintf(file, "server: %d sessions, %.3f s\n", count, wall / 1e9);
+  fprintf(file, "%-16s %8s %10s %10s %10s %7s\n", "session", "frames",
+          "memory KiB", "cpu ms", "us/frame", "cpu %");
+  for (int i = 0; i < count; i++) {
+    const session_t *session = sessions[i];
+    long long time = session->close_ns - session->open_ns;
+    unsigned long long frames = session->render.frames;
+    sessions_cpu += session->cpu_ns;
+    sessions_time += time;
+    fprintf(file, "%-16s %8llu %10.1f %10.3f %10.2f %7.3f\n",
+            session->loop.player, frames,
+            session->memory >= 0 ? session->memory / 1024. : -1.,
+            session->cpu_ns / 1e6,
+            frames ? session->cpu_ns / 1e3 / frames : 0.,
+            time > 0 ? 100. * session->cpu_ns / time : 0.);
+  }
+  fprintf(file, "server loop: %.3f ms cpu outside sessions\n",
+          (cpu - sessions_cpu) / 1e6);
+  if (sessions_cpu > 0)
+    fprintf(file, "server capacity: %.0f sessions per core at this load\n",
+            (double)sessions_time / sessions_cpu);
+}
+
+/**
+ * @brief Сервер сессий: по сессии на каждый терминал options->server,
+ * общий цикл событий до закрытия всех сессий.
+ * @param lb Таблица рекордов (результаты всех сессий) или NULL.
+ * @return 0 - успешно, 1 - терминал не открыт (сессии не запускаются).
+ */
+int tetrisServer(options_t *options, leaderboard_t *lb) {
+  static session_t *sessions[SERVER_SESSIONS_MAX];
+  const char *metrics_path = getenv("TETRIS_METRICS_FILE");
+  long long metrics_time = 0;
+  int count = 0;
+  while (count < options->server_count &&
+         (sessions[count] = serverOpen(options, lb,
+                                       options->server[count])) != NULL)
+    count++;
+  int res = count < options->server_count ? FAILURE_EXIT : SUCCESSFUL_EXIT;
+  if (res)
+    fprintf(stderr, "server: cannot open terminal %s\n",
+            options->server[count]);
+  int active = res ? 0 : count;
+  long long start = metricsNow(), cpu_start = serverCpu();
+  while (active > 0) {
+    struct pollfd fds[SERVER_SESSIONS_MAX];
+    for (int i = 0; i < count; i++)
+      fds[i] = (struct pollfd){
+          sessions[i]->active ? fileno(sessions[i]->in) : -1, POLLIN, 0};
+    poll(fds, count, SERVER_POLL_MS);
+    for (int i = 0; i < count; i++) {
+      session_t *session = sessions[i];
+      if (!session->active) continue;
+      long long cpu = serverCpu();
+      serverUse(session);
+      bool hangup = fds[i].revents & (POLLHUP | POLLERR | POLLNVAL);
+      // Проход цикла и все клавиши, пришедшие с прошлого прохода (включая
+      // буфер ncurses)
+      int key = hangup ? ERR : tetrisLoopStep(&session->loop);
+      while (key != ERR && session->loop.game_info.pause != EXIT_MODE)
+        key = tetrisLoopStep(&session->loop);
+      if (hangup || session->loop.game_info.pause == EXIT_MODE) {
+        serverClose(session);
+        active--;
+      }
+      session->cpu_ns += serverCpu() - cpu;
+    }
+    if (metrics_path != NULL &&
+        metricsNow() - metrics_time > METRICS_EXPORT_PERIOD) {
+      metricsWritePrometheus(metrics_path);
+      metrics_time = metricsNow();
+    }
+  }
+  if (!res)
+    serverPrintStats(sessions, count, metricsNow() - start,
+                     serverCpu() - cpu_start, stderr);
+  for (int i = 0; i < count; i++) {
+    if (sessions[i]->active) serverClose(sessions[i]);
+    if (!res && options->render_stats) {
+      fprintf(stderr, "session %s:\n", sessions[i]->loop.player);
+      renderPrintStats(&sessions[i]->render, stderr);
+      if (sessions[i]->hint != NULL)
+        hintPrintStats(sessions[i]->hint, stderr);
+    }
+  }
+  for (int i = 0; i < count; i++) serverFree(sessions[i]);
+  return res;
+}
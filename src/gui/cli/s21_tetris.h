@@ -1,14 +1,106 @@
 #ifndef TETRIS_H
 #define TETRIS_H
 
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// Период записи метрик в файл TETRIS_METRICS_FILE, нс
+#define METRICS_EXPORT_PERIOD 1000000000LL
+// Максимум шагов времени игры за один проход цикла (после долгой задержки
+// время игры не догоняет реальное)
+#define TICKS_CATCH_UP 10
+// Лучших результатов в сводке таблицы рекордов после выхода
+#define LEADERBOARD_PRINT_TOP 5
+// Максимум сессий сервера (--server TTY)
+#define SERVER_SESSIONS_MAX 64
+
 #include "../../brick_game/tetris/s21_api.h"
+#include "../../brick_game/tetris/s21_tetris_bot.h"
+#include "../../brick_game/tetris/s21_tetris_fsm.h"
+#include "../../brick_game/tetris/s21_tetris_hint.h"
+#include "../../brick_game/tetris/s21_tetris_leaderboard.h"
+#include "../../brick_game/tetris/s21_tetris_metrics.h"
+#include "../../brick_game/tetris/s21_tetris_timing.h"
 #include "s21_define.h"
+#include "s21_headless.h"
+#include "s21_render.h"
+#include "s21_screen.h"
 #include "s21_tetris_frontend.h"
 
-void tetrisGame();
+/// @brief Параметры запуска из командной строки
+typedef struct {
+  /// Максимальная частота кадров (--fps N), 0 - без ограничения
+  int fps;
+  /// Печать статистики отрисовки после выхода (--render-stats)
+  bool render_stats;
+  /// Автоматическая игра (--bot)
+  bool bot;
+  /// Время бота на планирование одной фигуры (--bot-budget US), нс
+  long long bot_budget;
+  /// Печать времени запуска после выхода (--startup-time)
+  bool startup_time;
+  /// Вывод своим ANSI-рендерером вместо ncurses (--ansi)
+  bool ansi;
+  /// Количество показываемых фигур очереди, включая следующую (--preview N)
+  int preview;
+  /// Каталог таблицы рекордов (--leaderboard DIR) или NULL
+  const char *leaderboard;
+  /// Имя игрока в таблице рекордов (--player NAME, по умолчанию $USER)
+  const char *player;
+  /// Журнал ввода игр для офлайн-анализа (--record FILE) или NULL
+  const char *record;
+  /// Адаптивная сложность (--adaptive)
+  bool adaptive;
+  /// Подсказка хода на поле (--hint)
+  bool hint;
+  /// Игра без терминала в виртуальном времени (--headless)
+  bool headless;
+  /// Сценарий клавиш для --headless (--script FILE) или NULL
+  const char *script;
+  /// Игр для --headless после конца сценария (--games N)
+  long long games;
+  /// Терминалы сессий сервера (--server TTY, несколько раз)
+  const char *server[SERVER_SESSIONS_MAX];
+  int server_count;
+} options_t;
+
+/// @brief Источник клавиш и времени игрового цикла
+typedef struct {
+  /// Следующая нажатая клавиша или ERR, если нажатий нет (как getch())
+  int (*key)(void *context);
+  /// Текущее время, нс
+  long long (*now)(void *context);
+  void *context;
+} game_io_t;
+
+/// @brief Игровой цикл текущей игры GUI (tetrisLoopInit, tetrisLoopStep)
+typedef struct {
+  options_t *options;
+  render_t *render;
+  /// Бот или NULL
+  bot_t *bot;
+  /// Таблица рекордов или NULL и имя игрока в ней
+  leaderboard_t *lb;
+  const char *player;
+  const game_io_t *io;
+  /// Время следующего шага игры, нс
+  long long tick_time;
+  /// Клавиша с автоповтором, нажатая сейчас
+  held_key_t held;
+  /// Состояние игры после последнего изменения
+  GameInfo_t game_info;
+} game_loop_t;
+
+int parseOptions(int argc, char *argv[], options_t *options);
+void tetrisGame(options_t *options, render_t *render, bot_t *bot,
+                leaderboard_t *lb, const game_io_t *io);
+void tetrisLoopInit(game_loop_t *loop, options_t *options, render_t *render,
+                    bot_t *bot, leaderboard_t *lb, const game_io_t *io);
+int tetrisLoopStep(game_loop_t *loop);
+int tetrisServer(options_t *options, leaderboard_t *lb);
+void leaderboardPrint(leaderboard_t *lb, const char *player, FILE *out);
 void ncursesInitialisation();
 
 #endif  // TETRIS_H
\ No newline at end of file
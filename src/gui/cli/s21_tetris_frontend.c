@@ -5,16 +5,53 @@
 
 #include "s21_tetris.h"
 
+// Символы клеток по значению (0 - пустая, 1-7 - цвет фигуры):
+// [значение][0 - левый, 1 - правый символ], атрибуты цвета уже добавлены
+#define CELL_CHARS(n) {LEFT_CHAR | COLOR_PAIR(n), RIGHT_CHAR | COLOR_PAIR(n)}
+static const chtype cell_chars[PIECE_TYPES + 1][2] = {
+    {' ', '.'},     CELL_CHARS(1), CELL_CHARS(2), CELL_CHARS(3),
+    CELL_CHARS(4), CELL_CHARS(5), CELL_CHARS(6), CELL_CHARS(7)};
+// Символы клеток подсказки хода: [id фигуры][левый, правый]
+#define HINT_CHARS(n) \
+  {HINT_LEFT_CHAR | COLOR_PAIR(n), HINT_RIGHT_CHAR | COLOR_PAIR(n)}
+static const chtype hint_chars[PIECE_TYPES][2] = {
+    HINT_CHARS(1), HINT_CHARS(2), HINT_CHARS(3), HINT_CHARS(4),
+    HINT_CHARS(5), HINT_CHARS(6), HINT_CHARS(7)};
+
+// Строки панели отложенной фигуры и очереди
+#define HOLD_ROW 1
+#define QUEUE_ROW 7
+
+// Количество показываемых фигур очереди, включая следующую (--preview N)
+static int preview_count = PREVIEW_DEFAULT;
+// Подсказка хода (--hint) или NULL
+static hint_t *hint = NULL;
+
+/**
+ * @brief Настройка цветов для отображения фигур. Вызывается после первой
+ * отрисовки: стартовое окно цвета не использует.
+ */
+void ncursesColors() {
+  start_color();
+  init_pair(1, COLOR_MAGENTA, 0);
+  init_pair(2, COLOR_RED, 0);
+  init_pair(3, COLOR_CYAN, 0);
+  init_pair(4, COLOR_GREEN, 0);
+  init_pair(5, COLOR_WHITE, 0);
+  init_pair(6, COLOR_YELLOW, 0);
+  init_pair(7, COLOR_BLUE, 0);
+}
+
 /**
  * @brief Отрисовка окна игры в зависимости от режима
  * @param game_info Инфо о текущем состоянии игры
  */
 void printGameScreen(GameInfo_t *game_info) {
   if (game_info->pause == START_MODE) {
-    clear();
+    screenClear();
     printWelcome();
   } else if (game_info->pause == PAUSE_MODE) {
-    mvprintw(SCORE_ROW + 19, SCORE_COL + 6, "%s", "PAUSE");
+    screenPrintw(SCORE_ROW + 19, SCORE_COL + 6, "%s", "PAUSE");
   } else if (game_info->pause == GAME_MODE) {
     printGlass(game_info);
     printGameStat(game_info);
@@ -28,30 +65,31 @@ void printGameScreen(GameInfo_t *game_info) {
  * @brief Отрисовка стартового окна
  */
 void printWelcome() {
-  printBorders(FIELD_ROWS + 1, FIELD_COLUMNS * 2 + 21);
+  printBorders(FIELD_ROWS + 1, HOLD_PANEL_COL + HOLD_PANEL_WIDTH);
   printTLine(FIELD_ROWS + 1, FIELD_COLUMNS * 2 + 1);
+  printTLine(FIELD_ROWS + 1, HOLD_PANEL_COL);
   printAddInfo();
-  mvprintw(3, 6, "Welcome to");
-  mvprintw(5, 6, "s21_Tetris");
-  mvprintw(7, 8, "Press:");
-  mvprintw(9, 1, "\"Enter\" - Start game");
-  mvprintw(11, 5, "\"Esc\" - Exit");
+  screenPrintw(3, 6, "Welcome to");
+  screenPrintw(5, 6, "s21_Tetris");
+  screenPrintw(7, 8, "Press:");
+  screenPrintw(9, 1, "\"Enter\" - Start game");
+  screenPrintw(11, 5, "\"Esc\" - Exit");
 }
 
 /**
  * @brief Отрисовка внешней рамки
  */
 void printBorders(int height, int width) {
-  for (int i = 1; i < width; i++) mvaddch(0, i, ACS_HLINE);
-  for (int i = 1; i < width; i++) mvaddch(height, i, ACS_HLINE);
+  for (int i = 1; i < width; i++) screenAddCh(0, i, ACS_HLINE);
+  for (int i = 1; i < width; i++) screenAddCh(height, i, ACS_HLINE);
   for (int i = 1; i < height; i++) {
-    mvaddch(i, 0, ACS_VLINE);
-    mvaddch(i, width, ACS_VLINE);
+    screenAddCh(i, 0, ACS_VLINE);
+    screenAddCh(i, width, ACS_VLINE);
   }
-  mvaddch(0, 0, ACS_ULCORNER);
-  mvaddch(0, width, ACS_URCORNER);
-  mvaddch(height, 0, ACS_LLCORNER);
-  mvaddch(height, width, ACS_LRCORNER);
+  screenAddCh(0, 0, ACS_ULCORNER);
+  screenAddCh(0, width, ACS_URCORNER);
+  screenAddCh(height, 0, ACS_LLCORNER);
+  screenAddCh(height, width, ACS_LRCORNER);
 }
 
 /**
@@ -59,42 +97,47 @@ void printBorders(int height, int width) {
  */
 void printTLine(int height, int col) {
   for (int i = 1; i < height; i++) {
-    mvaddch(i, col, ACS_VLINE);
+    screenAddCh(i, col, ACS_VLINE);
   }
-  mvaddch(0, col, ACS_TTEE);
-  mvaddch(height, col, ACS_BTEE);
+  screenAddCh(0, col, ACS_TTEE);
+  screenAddCh(height, col, ACS_BTEE);
 }
 
 /**
  * @brief Печать заголовков доп.информации
  */
 void printAddInfo() {
-  mvprintw(SCORE_ROW, SCORE_COL, "%16s", "LEVEL     SCORE");
-  mvprintw(SCORE_ROW + 3, SCORE_COL, "%16s", "HI-SCORE");
-  mvprintw(SCORE_ROW + 6, SCORE_COL, "%16s", "NEXT");
-  mvprintw(SCORE_ROW + 13, SCORE_COL, "%16s", "Esc - Exit");
-  mvprintw(SCORE_ROW + 14, SCORE_COL, "%16s", "P - Pause");
-  mvprintw(SCORE_ROW + 15, SCORE_COL, "%16s", "ARROWS - Move");
-  mvprintw(SCORE_ROW + 16, SCORE_COL, "%16s", "and Drop Piece");
-  mvprintw(SCORE_ROW + 17, SCORE_COL, "%16s", "Space - Rotate");
+  screenPrintw(SCORE_ROW, SCORE_COL, "%16s", "LEVEL     SCORE");
+  screenPrintw(SCORE_ROW + 3, SCORE_COL, "%16s", "HI-SCORE");
+  screenPrintw(SCORE_ROW + 6, SCORE_COL, "%16s", "NEXT");
+  screenPrintw(SCORE_ROW + 13, SCORE_COL, "%16s", "Esc - Exit");
+  screenPrintw(SCORE_ROW + 14, SCORE_COL, "%16s", "P - Pause");
+  screenPrintw(SCORE_ROW + 15, SCORE_COL, "%16s", "ARROWS - Move");
+  screenPrintw(SCORE_ROW + 16, SCORE_COL, "%16s", "and Drop Piece");
+  screenPrintw(SCORE_ROW + 17, SCORE_COL, "%16s", "Space - Rotate");
+  screenPrintw(SCORE_ROW + 18, SCORE_COL, "%16s", "C - Hold");
+  screenPrintw(HOLD_ROW, HOLD_PANEL_COL + 1, "%7s", "HOLD");
+  if (preview_count > 1)
+    screenPrintw(QUEUE_ROW, HOLD_PANEL_COL + 1, "%8s", "QUEUE");
 }
 
 /**
- * @brief Отрисовка игрового поля
+ * @brief Отрисовка игрового поля. Если подсказка хода включена (setHint),
+ * во время игры в пустых клетках лучшего размещения текущей фигуры рисуется
+ * ее контур.
  * @param game_info Инфо о текущем состоянии игры
  */
 void printGlass(GameInfo_t *game_info) {
+  bool ghost = hint != NULL && game_info->pause == GAME_MODE &&
+               hintUpdate(hint, fsmGuiEngine());
   for (int i = 0; i < FIELD_ROWS; i++) {
     for (int j = 0; j < FIELD_COLUMNS; j++) {
-      if (game_info->field[i][j]) {
-        mvaddch(i + 1, j * 2 + 1,
-                LEFT_CHAR | COLOR_PAIR(game_info->field[i][j]));
-        mvaddch(i + 1, j * 2 + 2,
-                RIGHT_CHAR | COLOR_PAIR(game_info->field[i][j]));
-      } else {
-        mvaddch(i + 1, j * 2 + 1, ' ');
-        mvaddch(i + 1, j * 2 + 2, '.');
-      }
+      int value = fieldCell(game_info, i, j);
+      const chtype *cell = cell_chars[value];
+      if (ghost && !value && hintCell(hint, i, j))
+        cell = hint_chars[hint->piece_id];
+      screenAddCh(i + 1, j * 2 + 1, cell[0]);
+      screenAddCh(i + 1, j * 2 + 2, cell[1]);
     }
   }
 }
@@ -104,13 +147,16 @@ void printGlass(GameInfo_t *game_info) {
  * @param game_info Инфо о текущем состоянии игры
  */
 void printGameStat(GameInfo_t *game_info) {
-  mvprintw(SCORE_ROW + 1, FIELD_COLUMNS * 2 + 2, "%6.5d", game_info->level);
-  mvprintw(SCORE_ROW + 1, FIELD_COLUMNS * 2 + 12, "%6.5d", game_info->score);
-  mvprintw(SCORE_ROW + 4, FIELD_COLUMNS * 2 + 2, "%16.5d",
-           game_info->high_score);
+  screenPrintw(SCORE_ROW + 1, FIELD_COLUMNS * 2 + 2, "%6.5d",
+               game_info->level);
+  screenPrintw(SCORE_ROW + 1, FIELD_COLUMNS * 2 + 12, "%6.5d",
+               game_info->score);
+  screenPrintw(SCORE_ROW + 4, FIELD_COLUMNS * 2 + 2, "%16.5d",
+               game_info->high_score);
   printNext(game_info);
+  printHoldPanel();
   // Затирание пробелами места, где пишется PAUSE
-  mvprintw(SCORE_ROW + 19, SCORE_COL + 6, "%s", "     ");
+  screenPrintw(SCORE_ROW + 19, SCORE_COL + 6, "%s", "     ");
 }
 
 /**
@@ -120,43 +166,120 @@ void printGameStat(GameInfo_t *game_info) {
 void printNext(GameInfo_t *game_info) {
   for (int i = 0; i < PIECE_ROWS; i++) {
     for (int j = 0; j < PIECE_COLUMNS; j++) {
-      if (game_info->next[i][j]) {
-        mvaddch(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 6,
-                LEFT_CHAR | COLOR_PAIR(game_info->next[i][j]));
-        mvaddch(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 7,
-                RIGHT_CHAR | COLOR_PAIR(game_info->next[i][j]));
-      } else {
-        mvaddch(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 6, ' ');
-        mvaddch(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 7, ' ');
-      }
+      int value = nextCell(game_info, i, j);
+      // Пустые клетки без точки, в отличие от поля
+      screenAddCh(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 6,
+                  value ? cell_chars[value][0] : ' ');
+      screenAddCh(i + SCORE_ROW + 8, j * 2 + SCORE_COL + 7,
+                  value ? cell_chars[value][1] : ' ');
+    }
+  }
+}
+
+/**
+ * @brief Отрисовка фигуры по таблице шаблонов без пустых строк шаблона
+ * сверху и снизу.
+ * @param row, col Позиция левого верхнего угла.
+ * @param id, rot_id Фигура и ее вращение.
+ * @param max_rows Доступно строк экрана. Если фигура не помещается, она не
+ * рисуется.
+ * @return Количество нарисованных строк.
+ */
+int printPiece(int row, int col, int id, int rot_id, int max_rows) {
+  int mask = pieceMask(id, rot_id);
+  int top = 0, bottom = PIECE_ROWS - 1;
+  while (top < bottom && !((mask >> top * PIECE_COLUMNS) & 0xF)) top++;
+  while (bottom > top && !((mask >> bottom * PIECE_COLUMNS) & 0xF)) bottom--;
+  int rows = bottom - top + 1;
+  if (rows > max_rows) return 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < PIECE_COLUMNS; j++) {
+      bool filled = (mask >> ((top + i) * PIECE_COLUMNS + j)) & 1;
+      screenAddCh(row + i, col + j * 2, filled ? cell_chars[id + 1][0] : ' ');
+      screenAddCh(row + i, col + j * 2 + 1,
+                  filled ? cell_chars[id + 1][1] : ' ');
     }
   }
+  return rows;
+}
+
+/**
+ * @brief Отрисовка отложенной фигуры и очереди фигур после следующей.
+ *
+ * Фигуры хранятся в игре id, шаблоны берутся из таблицы фигур. Фигуры
+ * очереди выводятся одна под другой, пока помещаются.
+ */
+void printHoldPanel() {
+  const addinfo_t *fsm_addinfo = &fsmGuiEngine()->addinfo;
+  int col = HOLD_PANEL_COL + 2;
+  for (int i = HOLD_ROW + 1; i <= FIELD_ROWS; i++)
+    if (i != QUEUE_ROW) screenPrintw(i, col, "%8s", "");
+  if (fsm_addinfo->has_hold) {
+    printPiece(HOLD_ROW + 2, col, fsm_addinfo->hold_id,
+               fsm_addinfo->hold_rot_id, PIECE_ROWS);
+  }
+  int row = QUEUE_ROW + 2;
+  for (int k = 1; k < preview_count; k++) {
+    int rot_id, id = previewPiece(fsm_addinfo, k, &rot_id);
+    int rows = printPiece(row, col, id, rot_id, FIELD_ROWS + 1 - row);
+    if (rows == 0) break;
+    row += rows + 1;
+  }
 }
 
 /**
- * @brief Определение действия по таймингу (в приоритете) или нажатой клавише
+ * @brief Количество показываемых фигур очереди, включая следующую.
+ * @param count От 1 (только следующая) до PREVIEW_MAX.
+ */
+void setPreviewCount(int count) { preview_count = count; }
+
+/**
+ * @brief Подсказка хода, которую рисует printGlass.
+ * @param value Подсказка (своя для каждой игры) или NULL - без подсказки.
+ */
+void setHint(hint_t *value) { hint = value; }
+
+/**
+ * @brief Определение действия по нажатой клавише.
+ *
+ * Клавиши с автоповтором (getHeldAction) передаются через userHeldKey:
+ * нажатие - один сдвиг, удержание (повторы терминала) - нажатие и
+ * отпускание (userKey), повтор выполняет игра по шагам времени. Повторы
+ * терминала сами по себе фигуру не двигают.
+ * @param key Нажатая клавиша или ERR, если нажатий нет.
  * @param hold Устанавливается в true только для падения фигуры.
- * @param timer Последнее срабатываание таймера. Для проверки прошедшего периода
- * времени с прошлого сдвига по таймеру, обновляется при срабатывании таймера.
- * @param speed Скорость игры. От нее зависит период срабатывания таймера.
- * @return Вариант действий пользователя в формате для передачи в FSM.
+ * @param held Клавиша с автоповтором, нажатая сейчас. Обновляется.
+ * @param now Текущее время, нс (metricsNow).
+ * @return Вариант действий пользователя в формате для передачи в FSM (Up -
+ * действия нет).
  */
-UserAction_t defineAction(bool *hold, float *timer, int speed) {
-  UserAction_t action;
-  float curr_time = (unsigned)clock() * 1000. / CLOCKS_PER_SEC;
-  int key = 0;
+UserAction_t defineAction(int key, bool *hold, held_key_t *held,
+                          long long now) {
+  UserAction_t held_action = getHeldAction(key);
+  UserAction_t action = userHeldKey(held, held_action, key != ERR, now);
   *hold = false;
-  if (curr_time - *timer > speed / 1000 || curr_time < *timer) {
-    action = Down;
-    *timer = curr_time;
-  } else {
-    key = getch();
+  if (held_action == Up && key != ERR) {
     action = getAction(key);
     if (action == Down) *hold = true;
   }
   return action;
 }
 
+/**
+ * @brief Определение клавиши с автоповтором: стрелки влево и вправо, на
+ * NumPad - 4 и 6.
+ * @param key Нажатая клавиша.
+ * @return Left, Right или Up для остальных клавиш.
+ */
+UserAction_t getHeldAction(int key) {
+  UserAction_t res = Up;
+  if (key == KEY_LEFT || key == '4')
+    res = Left;
+  else if (key == KEY_RIGHT || key == '6')
+    res = Right;
+  return res;
+}
+
 /**
  * @brief Определение действия по нажатой клавише
  * @param key Нажатая клавиша. Для всех неиспользуемых клавиш - Up.
@@ -178,6 +301,10 @@ UserAction_t getAction(int key) {
     res = Pause;
   else if (key == ' ' || key == '5')
     res = Action;
+  else if (key == 'z' || key == 'Z')
+    res = ActionCCW;
+  else if (key == 'c' || key == 'C')
+    res = Hold;
   return res;
 }
 
@@ -185,8 +312,8 @@ UserAction_t getAction(int key) {
  * @brief Печать сообщения об окончании игры.
  */
 void printGameover(int score) {
-  mvprintw(6, 6, "GAME  OVER");
-  mvprintw(7, 6, "Your final");
-  mvprintw(8, 6, " Score is ");
-  mvprintw(9, 6, "%8.6d  ", score);
+  screenPrintw(6, 6, "GAME  OVER");
+  screenPrintw(7, 6, "Your final");
+  screenPrintw(8, 6, " Score is ");
+  screenPrintw(9, 6, "%8.6d  ", score);
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 
 #include <ncurses.h>
 
+#include "../../brick_game/tetris/s21_api.h"
+#include "../../brick_game/tetris/s21_tetris_hint.h"
+
+void ncursesColors();
 void printGameScreen(GameInfo_t *game_info);
 void printWelcome();
 void printBorders(int height, int width);
@@ -10,8 +14,14 @@ void printTLine(int height, int col);
 void printAddInfo();
 void printGlass(GameInfo_t *game_info);
 void printNext(GameInfo_t *game_info);
+int printPiece(int row, int col, int id, int rot_id, int max_rows);
+void printHoldPanel();
+void setPreviewCount(int count);
+void setHint(hint_t *value);
 UserAction_t getAction(int key);
-UserAction_t defineAction(bool *hold, float *timer, int speed);
+UserAction_t getHeldAction(int key);
+UserAction_t defineAction(int key, bool *hold, held_key_t *held,
+                          long long now);
 void printGameStat(GameInfo_t *game_info);
 void printGameover(int score);
 
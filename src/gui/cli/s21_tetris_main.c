@@ -3,35 +3,276 @@
  * @brief Стандартный Тетрис в поле 10 х 20 с 7 фигурами.
  *
  * Управление: Esc -выход, Enter -старт, P - пауза.
- * Движение фигуры - стрелками влево, вправо, вниз, пробел (вращение).
- * Дублировано на NumPad - 4, 6, 2 и 5 соответственно.
+ * Движение фигуры - стрелками влево, вправо, вниз (падение), пробел
+ * (вращение). Дублировано на NumPad - 4, 6, 2 и 5 соответственно. Сдвиг
+ * при удержании повторяется с задержкой (DAS) и периодом (ARR) игры, а не
+ * терминала; фигура на опоре фиксируется после задержки, которую
+ * сбрасывают сдвиги и вращения. Z - вращение против часовой стрелки. При
+ * вращении у стены или препятствия фигура смещается (wall kicks по схеме
+ * SRS). C - отложить фигуру (hold) или обменять на отложенную, не чаще раза
+ * на фигуру.
  * Подсчет очков: 100, 300, 700 и 1500 за 1, 2, 3 и 4 линии.
  * Повышение уровня с изменением скорости за каждые 600 набранных очков.
+ *
+ * Параметры: --fps N - ограничение частоты кадров (по умолчанию 60),
+ * --render-stats - печать статистики отрисовки после выхода,
+ * --bot - фигурами управляет бот (клавиши управления продолжают работать),
+ * --bot-budget US - время бота на планирование фигуры, мкс (по умолчанию
+ * 1000),
+ * --startup-time - печать времени запуска после выхода: от старта программы
+ * до первой отрисовки (стартовое окно) и до готовности игры, мс,
+ * --ansi - вывод своим рендерером: разница кадров одной строкой ANSI за один
+ * write() вместо refresh() ncurses (с --render-stats печатается количество
+ * байт на кадр для сравнения),
+ * --preview N - количество показываемых фигур очереди, включая следующую,
+ * от 1 до 6 (по умолчанию 3),
+ * --leaderboard DIR - результаты законченных игр записываются в таблицу
+ * рекордов в каталоге DIR, после выхода печатается сводка,
+ * --player NAME - имя игрока в таблице рекордов (по умолчанию $USER),
+ * --record FILE - ввод каждой игры (seed и события userInput, userKey,
+ * userTick) дописывается в журнал FILE для офлайн-анализа (tetris_analyze),
+ * --adaptive - адаптивная сложность: скорость падения и частота удобных
+ * фигур подстраиваются по навыку игрока,
+ * --hint - подсказка хода: контур лучшего размещения текущей фигуры на поле
+ * (s21_tetris_hint.c), с --render-stats печатается время поиска подсказок,
+ * --headless - игра без терминала в виртуальном времени (s21_headless.c):
+ * клавиши из сценария --script FILE, затем --games N игр (по умолчанию 1)
+ * с ботом (--bot) или со сбросом каждой фигуры, кадры собираются в памяти;
+ * после выхода печатаются итоги,
+ * --server TTY - сервер сессий (s21_server.c): игра на терминале TTY
+ * (последовательная линия, псевдотерминал моста telnet), параметр
+ * повторяется для каждого терминала, все сессии - в одном процессе; после
+ * выхода печатаются память и процессорное время каждой сессии.
  */
 
+#include <unistd.h>
+
 #include "s21_tetris.h"
 
 /**
  * @brief Запуск программы
  */
-int main() {
+int main(int argc, char *argv[]) {
+  long long start_time = metricsNow();
+  options_t options;
+  if (parseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--fps N] [--render-stats] [--bot] [--bot-budget US] "
+            "[--startup-time] [--ansi] [--preview N] [--leaderboard DIR] "
+            "[--player NAME] [--record FILE] [--adaptive] [--hint] "
+            "[--headless [--script FILE] [--games N]] [--server TTY]...\n",
+            argv[0]);
+    return FAILURE_EXIT;
+  }
+  setPreviewCount(options.preview);
+  if (options.server_count > 0) {
+    leaderboard_t *lb = NULL;
+    if (options.leaderboard != NULL) {
+      lb = lbOpen(options.leaderboard);
+      if (lb == NULL) {
+        fprintf(stderr, "%s: cannot open leaderboard %s\n", argv[0],
+                options.leaderboard);
+        return FAILURE_EXIT;
+      }
+    }
+    highScorePrefetch();
+    srand(time(0));
+    int res = tetrisServer(&options, lb);
+    if (lb != NULL) {
+      leaderboardPrint(lb, NULL, stderr);
+      if (lbClose(lb)) fprintf(stderr, "leaderboard: write error\n");
+    }
+    return res;
+  }
+  replay_recorder_t *recorder = NULL;
+  if (options.record != NULL) {
+    recorder = replayRecorderOpen(options.record);
+    if (recorder == NULL) {
+      fprintf(stderr, "%s: cannot open record %s\n", argv[0], options.record);
+      return FAILURE_EXIT;
+    }
+  }
+  headless_t headless;
+  if (options.headless && headlessInit(&headless, options.script,
+                                       options.games, options.bot)) {
+    fprintf(stderr, "%s: cannot read script %s\n", argv[0], options.script);
+    replayRecorderClose(recorder);
+    return FAILURE_EXIT;
+  }
+  // Рекорд и таблица рекордов читаются с диска параллельно с инициализацией
+  // интерфейса
+  highScorePrefetch();
+  lb_pending_t lb_pending;
+  if (options.leaderboard != NULL)
+    lbOpenStart(&lb_pending, options.leaderboard);
   srand(time(0));
-  ncursesInitialisation();
-  // Выделение памяти под массивы для игры
+  if (!options.headless) ncursesInitialisation();
+  static screen_t screen;
+  screen_backend_t backend = options.ansi ? SCREEN_ANSI : SCREEN_NCURSES;
+  if (options.headless) backend = SCREEN_MEMORY;
+  screenInit(&screen, backend, STDOUT_FILENO, options.render_stats);
+  screenUse(&screen);
+  // Стартовое окно рисуется до создания игры, бота и настройки цветов
+  printWelcome();
+  screenRefresh();
+  long long paint_time = metricsNow();
+  if (!options.headless) ncursesColors();
+  bot_t *bot = options.bot ? botCreate(options.bot_budget) : NULL;
+  hint_t *hint = options.hint ? hintCreate(HINT_BUDGET) : NULL;
+  // Таблица рекордов нужна к концу первой игры (lbAdd)
+  leaderboard_t *lb =
+      options.leaderboard != NULL ? lbOpenWait(&lb_pending) : NULL;
+  if ((options.bot && bot == NULL) || (options.hint && hint == NULL) ||
+      (options.leaderboard != NULL && lb == NULL)) {
+    screenClose(&screen);
+    if (options.headless) {
+      headlessDestroy(&headless);
+    } else {
+      endwin();
+    }
+    if (options.leaderboard != NULL && lb == NULL)
+      fprintf(stderr, "%s: cannot open leaderboard %s\n", argv[0],
+              options.leaderboard);
+    botDestroy(bot);
+    hintDestroy(hint);
+    replayRecorderClose(recorder);
+    lbClose(lb);
+    return FAILURE_EXIT;
+  }
+  setHint(hint);
+  // Выделение памяти под массивы для игры (дожидается чтения рекорда)
   userInput(Start, true);
+  userAdaptive(options.adaptive);
+  long long ready_time = metricsNow();
 
-  tetrisGame();
+  render_t render;
+  userRecord(recorder);
+  game_io_t io = {headlessKey, headlessNow, &headless};
+  tetrisGame(&options, &render, bot, lb, options.headless ? &io : NULL);
+  userRecord(NULL);
+  int record_error = replayRecorderClose(recorder);
 
   // Очистка памяти
   userInput(Terminate, true);
+  botDestroy(bot);
+  setHint(NULL);
 
-  endwin();
+  screenClose(&screen);
+  if (options.headless) {
+    headlessPrintStats(&headless, stderr);
+    headlessDestroy(&headless);
+  } else {
+    endwin();
+  }
+  if (options.render_stats) renderPrintStats(&render, stderr);
+  if (options.render_stats && hint != NULL) hintPrintStats(hint, stderr);
+  hintDestroy(hint);
+  if (options.startup_time)
+    fprintf(stderr, "startup: first paint %.3f ms, ready %.3f ms\n",
+            (paint_time - start_time) / 1e6, (ready_time - start_time) / 1e6);
+  if (lb != NULL) {
+    leaderboardPrint(lb, options.player, stderr);
+    if (lbClose(lb)) fprintf(stderr, "leaderboard: write error\n");
+  }
+  if (record_error) fprintf(stderr, "record: write error\n");
   return 0;
 }
 
+/**
+ * @brief Разбор параметров командной строки
+ * @param options Результат. Для не заданных параметров - значения по
+ * умолчанию.
+ * @return 0 - успешно, 1 - неизвестный или некорректный параметр.
+ */
+int parseOptions(int argc, char *argv[], options_t *options) {
+  int res = SUCCESSFUL_EXIT;
+  options->fps = RENDER_FPS;
+  options->render_stats = false;
+  options->bot = false;
+  options->bot_budget = BOT_BUDGET;
+  options->startup_time = false;
+  options->ansi = false;
+  options->preview = PREVIEW_DEFAULT;
+  options->leaderboard = NULL;
+  options->player = getenv("USER");
+  if (options->player == NULL) options->player = "player";
+  options->record = NULL;
+  options->adaptive = false;
+  options->hint = false;
+  options->headless = false;
+  options->script = NULL;
+  options->games = 1;
+  options->server_count = 0;
+  for (int i = 1; i < argc && !res; i++) {
+    if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      options->fps = atoi(argv[++i]);
+      if (options->fps < 0) res = FAILURE_EXIT;
+    } else if (strcmp(argv[i], "--render-stats") == 0) {
+      options->render_stats = true;
+    } else if (strcmp(argv[i], "--bot") == 0) {
+      options->bot = true;
+    } else if (strcmp(argv[i], "--bot-budget") == 0 && i + 1 < argc) {
+      options->bot_budget = atoll(argv[++i]) * 1000;
+      if (options->bot_budget <= 0) res = FAILURE_EXIT;
+    } else if (strcmp(argv[i], "--startup-time") == 0) {
+      options->startup_time = true;
+    } else if (strcmp(argv[i], "--ansi") == 0) {
+      options->ansi = true;
+    } else if (strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+      options->preview = atoi(argv[++i]);
+      if (options->preview < 1 || options->preview > PREVIEW_MAX)
+        res = FAILURE_EXIT;
+    } else if (strcmp(argv[i], "--leaderboard") == 0 && i + 1 < argc) {
+      options->leaderboard = argv[++i];
+    } else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+      options->player = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      options->record = argv[++i];
+    } else if (strcmp(argv[i], "--adaptive") == 0) {
+      options->adaptive = true;
+    } else if (strcmp(argv[i], "--hint") == 0) {
+      options->hint = true;
+    } else if (strcmp(argv[i], "--headless") == 0) {
+      options->headless = true;
+    } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+      options->script = argv[++i];
+    } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+      options->games = atoll(argv[++i]);
+      if (options->games < 0) res = FAILURE_EXIT;
+    } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc &&
+               options->server_count < SERVER_SESSIONS_MAX) {
+      options->server[options->server_count++] = argv[++i];
+    } else {
+      res = FAILURE_EXIT;
+    }
+  }
+  // Сервер не записывает журнал и не работает без терминала
+  if (options->server_count > 0 && (options->record || options->headless))
+    res = FAILURE_EXIT;
+  return res;
+}
+
+/**
+ * @brief Клавиша терминала для игрового цикла (io по умолчанию).
+ */
+static int terminalKey(void *context) {
+  (void)context;
+  return getch();
+}
+
+/**
+ * @brief Монотонное время для игрового цикла (io по умолчанию).
+ */
+static long long terminalNow(void *context) {
+  (void)context;
+  return metricsNow();
+}
+
 /**
  * @brief Игровой цикл от Старта до Завершения игры
  *
+ * Стартовое окно к моменту вызова уже нарисовано (main).
+ *
  * 4 режима интерфейса, связаны с состоянием FSM (через game_info.pause):
  * 1. Стартовый. Показывается перед началом каждой игры.
  * 2. Основной режим игры, управление фигурами.
@@ -39,46 +280,134 @@ int main() {
  * 4. Итоговый результат. С него переходит на Стартовый.
  * Дополнительно, EXIT_MODE - выход из игры
  *
- * В бэкэнд передаются либо данные о нажатой клавише либо
- * сигнал по таймеру о сдвиге фигуры вниз (периодичность зависит от скорости)
+ * В бэкэнд передаются данные о нажатых клавишах (клавиши с автоповтором -
+ * нажатием и отпусканием) и шаги времени игры (TIMING_TICK_NS) по
+ * прошедшему времени: гравитацию, автоповтор и задержку фиксации выполняет
+ * игра.
+ *
+ * Экран перерисовывается планировщиком render не чаще options->fps кадров в
+ * секунду, несколько изменений между кадрами объединяются в один кадр.
+ *
+ * Если задан бот (bot != NULL), то при отсутствии нажатий и сигнала таймера
+ * действие берется у бота: бот - альтернативный источник ввода для FSM.
+ *
+ * Если задана таблица рекордов (lb != NULL), результат каждой законченной
+ * игры записывается в нее.
+ *
+ * Если задана переменная окружения TETRIS_METRICS_FILE, метрики игры раз в
+ * секунду записываются в этот файл в формате Prometheus.
+ *
+ * Клавиши и время берутся из io: NULL - терминал (getch) и монотонные часы,
+ * для игры без терминала - сценарий и виртуальное время (s21_headless.c).
  */
-void tetrisGame() {
-  float timer = (unsigned)clock() * 1000. / CLOCKS_PER_SEC;
-  clear();
-  printWelcome();
-  refresh();
-  GameInfo_t game_info = updateCurrentState();
-  while (game_info.pause != EXIT_MODE) {
-    UserAction_t action;
-    bool hold;
-    action = defineAction(&hold, &timer, game_info.speed);
-    // Up - нажата любая кнопка, кроме управляющих. Игнорируется.
-    if (action != Up) {
-      userInput(action, hold);
-      game_info = updateCurrentState();
-      printGameScreen(&game_info);
-      refresh();
+void tetrisGame(options_t *options, render_t *render, bot_t *bot,
+                leaderboard_t *lb, const game_io_t *io) {
+  const char *metrics_path = getenv("TETRIS_METRICS_FILE");
+  long long metrics_time = 0;
+  game_loop_t loop;
+  tetrisLoopInit(&loop, options, render, bot, lb, io);
+  while (loop.game_info.pause != EXIT_MODE) {
+    tetrisLoopStep(&loop);
+    if (metrics_path != NULL &&
+        metricsNow() - metrics_time > METRICS_EXPORT_PERIOD) {
+      metricsWritePrometheus(metrics_path);
+      metrics_time = metricsNow();
     }
   }
 }
 
 /**
- * @brief Запуск и начальная настройка функций ncurses
+ * @brief Начало игрового цикла текущей игры GUI (tetrisGame, сервер
+ * сессий): планировщик кадров, отсчет шагов времени.
+ * @param io Источник клавиш и времени, NULL - терминал.
+ */
+void tetrisLoopInit(game_loop_t *loop, options_t *options, render_t *render,
+                    bot_t *bot, leaderboard_t *lb, const game_io_t *io) {
+  static const game_io_t terminal = {terminalKey, terminalNow, NULL};
+  loop->options = options;
+  loop->render = render;
+  loop->bot = bot;
+  loop->lb = lb;
+  loop->player = options->player;
+  loop->io = io != NULL ? io : &terminal;
+  loop->tick_time = loop->io->now(loop->io->context);
+  loop->held = (held_key_t){Up, 0, false};
+  renderInit(render, options->fps);
+  renderSetClock(render, loop->io->now, loop->io->context);
+  loop->game_info = updateCurrentState();
+}
+
+/**
+ * @brief Один проход игрового цикла текущей игры GUI: клавиша (или действие
+ * бота), шаги времени за прошедшее время, запись результата законченной
+ * игры и кадр по планировщику.
+ * @return Прочитанная клавиша или ERR, если нажатий не было. После выхода
+ * из игры loop->game_info.pause - EXIT_MODE.
+ */
+int tetrisLoopStep(game_loop_t *loop) {
+  const game_io_t *io = loop->io;
+  unsigned int steps = fsmGuiEngine()->step_count;
+  bool hold;
+  int key = io->key(io->context);
+  UserAction_t action =
+      defineAction(key, &hold, &loop->held, io->now(io->context));
+  if (action == Up && loop->bot != NULL)
+    action = botAction(loop->bot, fsmGuiEngine(), &hold);
+  // Up - нажата любая кнопка, кроме управляющих. Игнорируется.
+  if (action != Up) userInput(action, hold);
+  // Шаги времени игры за прошедшее время
+  long long now = io->now(io->context);
+  for (int i = 0; now - loop->tick_time >= TIMING_TICK_NS; i++) {
+    if (i == TICKS_CATCH_UP) {
+      loop->tick_time = now;
+    } else {
+      userTick();
+      loop->tick_time += TIMING_TICK_NS;
+    }
+  }
+  if (fsmGuiEngine()->step_count != steps) {
+    int mode = loop->game_info.pause;
+    loop->game_info = updateCurrentState();
+    if (loop->lb != NULL && loop->game_info.pause == GAMEOVER_MODE &&
+        mode != GAMEOVER_MODE) {
+      lb_result_t result;
+      lbResultFromEngine(fsmGuiEngine(), loop->player, &result);
+      lbAdd(loop->lb, &result);
+    }
+    renderUpdate(loop->render, &loop->game_info);
+  } else {
+    renderTick(loop->render, &loop->game_info);
+  }
+  return key;
+}
+
+/**
+ * @brief Запуск и начальная настройка функций ncurses. Цвета не
+ * настраиваются (ncursesColors), чтобы стартовое окно появилось быстрее.
  */
 void ncursesInitialisation() {
   initscr();
   noecho();
   curs_set(0);
   timeout(10);
-  // Настройка цветов для отображения фигур
-  start_color();
-  init_pair(1, COLOR_MAGENTA, 0);
-  init_pair(2, COLOR_RED, 0);
-  init_pair(3, COLOR_CYAN, 0);
-  init_pair(4, COLOR_GREEN, 0);
-  init_pair(5, COLOR_WHITE, 0);
-  init_pair(6, COLOR_YELLOW, 0);
-  init_pair(7, COLOR_BLUE, 0);
   // Для чтения функциональных клавиш (стрелки)
   keypad(stdscr, TRUE);
 }
+
+/**
+ * @brief Печать сводки таблицы рекордов: лучшие результаты и лучший
+ * результат игрока с его процентилем (player NULL - без игрока).
+ */
+void leaderboardPrint(leaderboard_t *lb, const char *player, FILE *out) {
+  lb_result_t top[LEADERBOARD_PRINT_TOP];
+  int count = lbTop(lb, top, LEADERBOARD_PRINT_TOP);
+  fprintf(out, "leaderboard: %lld games\n", lbCount(lb));
+  for (int i = 0; i < count; i++)
+    fprintf(out, "%2d. %-15s %8d  level %2d  lines %4d\n", i + 1,
+            top[i].player, top[i].score, top[i].level, top[i].lines);
+  lb_result_t best;
+  long long games;
+  if (player != NULL && !lbPlayerBest(lb, player, &best, &games))
+    fprintf(out, "%s: best %d in %lld games, better than %.1f%% of games\n",
+            player, best.score, games, lbPercentile(lb, best.score));
+}
@@ -0,0 +1,337 @@
+/**
+ * @file s21_soak.c
+ * @brief Длительный тест (soak): миллионы игр через API GUI (userInput,
+ * userTick, updateCurrentState) с проверкой, что занятая память процесса
+ * (RSS), открытые файловые дескрипторы и выделенная память кучи не растут.
+ *
+ * Игры идут циклами по SOAK_CYCLE: предзагрузка рекорда в потоке
+ * (highScorePrefetch), создание массивов игры (tetrisAllocate / createMatrix),
+ * игры случайными действиями до конца (запись рекорда - fopen в конце
+ * игры с новым рекордом), удаление массивов (tetrisDestroy). После каждого
+ * цикла игра удалена, поэтому замеры сравнимы между собой. Первые
+ * SOAK_WARMUP_PERCENT % игр, но не меньше SOAK_WARMUP_CYCLES циклов -
+ * прогрев (буферы stdio, стек потока, кэши аллокатора, карантин ASan),
+ * базовые значения - замер после прогрева; дальше рост любого показателя
+ * сверх допуска - ошибка.
+ *
+ * Кэш освобожденных блоков glibc (tcache) хранит до 7 блоков каждого
+ * размера, и mallinfo2 считает их выделенными: первые циклы куча растет на
+ * сотни байт за цикл, пока кэш не заполнится. Поэтому прогрев ограничен
+ * снизу числом циклов, а не только долей игр, и допуск роста кучи - 0.
+ *
+ * Выделенная память кучи: mallinfo2 (glibc), в сборках с ASan и TSan -
+ * счетчик аллокатора санитайзера; RSS в этих сборках только печатается.
+ * Утечки при выходе дополнительно ищут
+ * LeakSanitizer (BUILD=asan) или valgrind (make soak-valgrind).
+ *
+ * Запуск: soak [--games N] [--seed S] [--report FILE] [--rss-slack KIB]
+ * [--heap-slack BYTES]. Отчет (сборка, замеры, итог) печатается в stdout и
+ * при --report записывается в файл. Код возврата: 0 - показатели не
+ * растут, 1 - рост или ошибка параметров.
+ */
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../brick_game/tetris/s21_api.h"
+#include "../brick_game/tetris/s21_tetris_backend.h"
+#include "../brick_game/tetris/s21_tetris_fsm.h"
+
+// Игр по умолчанию и игр в одном цикле создания / удаления массивов
+#define SOAK_GAMES 1000000LL
+#define SOAK_CYCLE 100LL
+// Доля игр на прогрев, % и не меньше циклов на прогрев (заполнение tcache
+// glibc, 7 блоков каждого размера, с запасом)
+#define SOAK_WARMUP_PERCENT 10
+#define SOAK_WARMUP_CYCLES 10LL
+// Строк замеров в отчете
+#define SOAK_SAMPLES 20
+// Допуски роста после прогрева: RSS, КиБ, и выделенная память кучи, байт
+#define SOAK_RSS_SLACK 256LL
+#define SOAK_HEAP_SLACK 0LL
+// Ограничение действий в одной игре (игра заканчивается сбросом фигур)
+#define SOAK_GAME_ACTIONS 100000
+
+#ifndef SOAK_BUILD
+#define SOAK_BUILD "unknown"
+#endif
+#ifndef SOAK_FLAGS
+#define SOAK_FLAGS ""
+#endif
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define SOAK_SANITIZER_HEAP 1
+// Объявлен в sanitizer/allocator_interface.h, которого нет в поставке gcc
+size_t __sanitizer_get_current_allocated_bytes(void);
+#endif
+
+#ifdef __SANITIZE_ADDRESS__
+/**
+ * @brief Параметры ASan по умолчанию: небольшой карантин освобожденной
+ * памяти, чтобы RSS выходил на постоянный уровень за время прогрева.
+ */
+const char *__asan_default_options(void) { return "quarantine_size_mb=16"; }
+#endif
+
+/// @brief Замер ресурсов процесса
+typedef struct {
+  /// Сыграно игр к моменту замера
+  long long games;
+  /// Занятая физическая память, КиБ
+  long long rss;
+  /// Открытых файловых дескрипторов
+  int fds;
+  /// Выделенная память кучи, байт (-1 - неизвестно)
+  long long heap;
+} soak_sample_t;
+
+/// @brief Параметры и итоги прогона
+typedef struct {
+  long long games;
+  unsigned int seed;
+  const char *report;
+  long long rss_slack;
+  long long heap_slack;
+  /// Игр на прогрев
+  long long warmup;
+  /// Действий, фигур и удаленных строк за все игры
+  long long actions;
+  long long pieces;
+  long long lines;
+  /// Время прогона, с
+  double elapsed;
+  /// Замеры: базовый (после прогрева), наибольшие значения после него и
+  /// строки отчета
+  soak_sample_t base;
+  soak_sample_t max;
+  soak_sample_t samples[SOAK_SAMPLES];
+  int sample_count;
+} soak_t;
+
+/**
+ * @brief Замер RSS, дескрипторов и кучи процесса.
+ */
+static soak_sample_t soakMeasure(long long games) {
+  soak_sample_t sample = {games, -1, -1, -1};
+  long long pages;
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (file != NULL) {
+    if (fscanf(file, "%*d %lld", &pages) == 1)
+      sample.rss = pages * sysconf(_SC_PAGESIZE) / 1024;
+    fclose(file);
+  }
+  DIR *dir = opendir("/proc/self/fd");
+  if (dir != NULL) {
+    int entries = 0;
+    while (readdir(dir) != NULL) entries++;
+    // Без ".", ".." и дескриптора самого каталога
+    sample.fds = entries - 3;
+    closedir(dir);
+  }
+#ifdef SOAK_SANITIZER_HEAP
+  sample.heap = (long long)__sanitizer_get_current_allocated_bytes();
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 info = mallinfo2();
+  sample.heap = (long long)(info.uordblks + info.hblkhd);
+#endif
+  return sample;
+}
+
+/**
+ * @brief Следующее случайное действие: в основном сдвиги, вращения и
+ * падение, реже шаги времени, отложенная фигура и пауза.
+ * @return 0 - действие выполнено, 1 - шаг времени (userTick).
+ */
+static int soakAction(unsigned int *rnd, UserAction_t *action, bool *hold) {
+  static const UserAction_t mix[16] = {
+      Left,  Right, Left,   Right, Action, Action, Down, Down,
+      Down,  Down,  Down,   Hold,  Pause,  Up,     Up,   Up};
+  *rnd = *rnd * 1103515245u + 12345u;
+  unsigned int r = *rnd >> 16;
+  *action = mix[r & 15];
+  // Down: падение или сдвиг на строку вниз
+  *hold = *action == Down && (r & 0x30) == 0;
+  return *action == Up;
+}
+
+/**
+ * @brief Одна игра случайными действиями от старта до конца.
+ */
+static void soakGame(soak_t *soak, unsigned int *rnd) {
+  const engine_t *engine = fsmGuiEngine();
+  unsigned int pieces = engine->piece_count;
+  userInput(Start, false);
+  GameInfo_t game_info = updateCurrentState();
+  for (int i = 0; i < SOAK_GAME_ACTIONS && game_info.pause == GAME_MODE;
+       i++) {
+    UserAction_t action;
+    bool hold;
+    if (soakAction(rnd, &action, &hold)) {
+      userTick();
+    } else {
+      userInput(action, hold);
+      // Пауза снимается сразу
+      if (action == Pause) userInput(Pause, false);
+    }
+    soak->actions++;
+    game_info = updateCurrentState();
+  }
+  // Игра, не закончившаяся за SOAK_GAME_ACTIONS, завершается
+  if (game_info.pause == GAME_MODE) userInput(Terminate, false);
+  soak->pieces += engine->piece_count - pieces;
+  soak->lines += engine->lines;
+  // Из итогов игры - в стартовое окно, рекорд записывается в файл
+  userInput(Start, false);
+}
+
+/**
+ * @brief Все игры циклами создания и удаления массивов с замерами после
+ * каждого цикла.
+ * @return 0 - массивы игры создавались, 1 - ошибка выделения памяти.
+ */
+static int soakRun(soak_t *soak) {
+  unsigned int rnd = soak->seed;
+  long long period = soak->games / SOAK_SAMPLES;
+  long long next_sample = period;
+  int res = SUCCESSFUL_EXIT;
+  srand(soak->seed);
+  soak->base = soakMeasure(0);
+  soak->max = soak->base;
+  double start = metricsNow() / 1e9;
+  for (long long games = 0; games < soak->games && !res;) {
+    highScorePrefetch();
+    userInput(Start, true);
+    if (updateCurrentState().pause == EXIT_MODE) res = FAILURE_EXIT;
+    for (long long i = 0; i < SOAK_CYCLE && games < soak->games && !res;
+         i++, games++)
+      soakGame(soak, &rnd);
+    userInput(Terminate, true);
+    soak_sample_t sample = soakMeasure(games);
+    if (games <= soak->warmup) {
+      soak->base = sample;
+      soak->max = sample;
+    }
+    if (sample.rss > soak->max.rss) soak->max.rss = sample.rss;
+    if (sample.fds > soak->max.fds) soak->max.fds = sample.fds;
+    if (sample.heap > soak->max.heap) soak->max.heap = sample.heap;
+    if ((games >= next_sample || games == soak->games) &&
+        soak->sample_count < SOAK_SAMPLES) {
+      soak->samples[soak->sample_count++] = sample;
+      next_sample += period;
+    }
+  }
+  soak->elapsed = metricsNow() / 1e9 - start;
+  return res;
+}
+
+/**
+ * @brief Строка итога по показателю: базовое и наибольшее значение, рост.
+ * @param slack Допуск роста, меньше 0 - показатель не проверяется.
+ * @return true - рост в пределах допуска или показатель не проверяется.
+ */
+static bool soakVerdict(FILE *file, const char *name, long long base,
+                        long long max, long long slack, const char *unit) {
+  bool ok = slack < 0 || base < 0 || max - base <= slack;
+  fprintf(file, "%-5s %12lld -> %12lld %-3s growth %+lld", name, base, max,
+          unit, max - base);
+  if (slack < 0)
+    fprintf(file, ": not checked\n");
+  else
+    fprintf(file, " (limit %lld): %s\n", slack, ok ? "flat" : "GROWS");
+  return ok;
+}
+
+/**
+ * @brief Отчет прогона: сборка, нагрузка, замеры, итог.
+ * @return 0 - показатели не растут, 1 - рост.
+ */
+static int soakReport(const soak_t *soak, FILE *file) {
+  fprintf(file, "soak report\n");
+  fprintf(file, "build: %s (%s), %s\n", SOAK_BUILD, SOAK_FLAGS, __VERSION__);
+  fprintf(file, "games: %lld (%lld per create / destroy cycle), seed %u\n",
+          soak->games, SOAK_CYCLE, soak->seed);
+  fprintf(file, "load:  %lld actions, %lld pieces, %lld lines\n",
+          soak->actions, soak->pieces, soak->lines);
+  fprintf(file, "time:  %.1f s, %.0f games/s\n", soak->elapsed,
+          soak->elapsed > 0 ? soak->games / soak->elapsed : 0.);
+  fprintf(file, "%12s %10s %6s %14s\n", "games", "rss KiB", "fds",
+          "heap bytes");
+  for (int i = 0; i < soak->sample_count; i++) {
+    const soak_sample_t *sample = &soak->samples[i];
+    fprintf(file, "%12lld %10lld %6d %14lld\n", sample->games, sample->rss,
+            sample->fds, sample->heap);
+  }
+  fprintf(file, "after warmup (%lld games):\n", soak->warmup);
+#ifdef SOAK_SANITIZER_HEAP
+  // RSS сборок с ASan и TSan включает теневую память и учет потоков
+  // санитайзера (растет с каждым созданным потоком), поэтому проверяются
+  // только куча и дескрипторы
+  bool ok = soakVerdict(file, "rss", soak->base.rss, soak->max.rss, -1,
+                        "KiB");
+#else
+  bool ok = soakVerdict(file, "rss", soak->base.rss, soak->max.rss,
+                        soak->rss_slack, "KiB");
+#endif
+  ok = soakVerdict(file, "fds", soak->base.fds, soak->max.fds, 0, "") && ok;
+  ok = soakVerdict(file, "heap", soak->base.heap, soak->max.heap,
+                   soak->heap_slack, "B") &&
+       ok;
+  fprintf(file, "result: %s\n", ok ? "PASS" : "FAIL");
+  return ok ? SUCCESSFUL_EXIT : FAILURE_EXIT;
+}
+
+int main(int argc, char **argv) {
+  soak_t soak = {.games = SOAK_GAMES,
+                 .seed = 1,
+                 .rss_slack = SOAK_RSS_SLACK,
+                 .heap_slack = SOAK_HEAP_SLACK};
+  int res = SUCCESSFUL_EXIT;
+  for (int i = 1; i < argc && !res; i++) {
+    if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+      soak.games = atoll(argv[++i]);
+      // После прогрева должен остаться хотя бы один цикл
+      if (soak.games <= SOAK_WARMUP_CYCLES * SOAK_CYCLE) res = FAILURE_EXIT;
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      soak.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+      soak.report = argv[++i];
+    } else if (strcmp(argv[i], "--rss-slack") == 0 && i + 1 < argc) {
+      soak.rss_slack = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--heap-slack") == 0 && i + 1 < argc) {
+      soak.heap_slack = atoll(argv[++i]);
+    } else {
+      res = FAILURE_EXIT;
+    }
+  }
+  if (res) {
+    fprintf(stderr,
+            "usage: %s [--games N > %lld] [--seed S] [--report FILE] "
+            "[--rss-slack KIB] [--heap-slack BYTES]\n",
+            argv[0], SOAK_WARMUP_CYCLES * SOAK_CYCLE);
+    return res;
+  }
+  soak.warmup = soak.games * SOAK_WARMUP_PERCENT / 100;
+  if (soak.warmup < SOAK_WARMUP_CYCLES * SOAK_CYCLE)
+    soak.warmup = SOAK_WARMUP_CYCLES * SOAK_CYCLE;
+  if (soakRun(&soak)) {
+    fprintf(stderr, "soak: cannot create game\n");
+    return FAILURE_EXIT;
+  }
+  res = soakReport(&soak, stdout);
+  if (soak.report != NULL) {
+    FILE *file = fopen(soak.report, "w");
+    if (file == NULL) {
+      fprintf(stderr, "soak: cannot write report %s\n", soak.report);
+      res = FAILURE_EXIT;
+    } else {
+      soakReport(&soak, file);
+      fclose(file);
+    }
+  }
+  return res;
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_adaptive.c
+ * @brief Тест адаптивной сложности: выключенный режим не меняет игру,
+ * скорость и веса фигур в границах, подстройка под новичка и опытного
+ * игрока, выбор фигур по весам
+ */
+
+#include "../brick_game/tetris/s21_tetris_adaptive.h"
+#include "../brick_game/tetris/s21_tetris_bot.h"
+#include "tests_main.h"
+
+/**
+ * @brief Новая игра с известным seed.
+ */
+static void adaptiveStart(engine_t *engine, bool enabled) {
+  engine->state = START;
+  engine->addinfo.seed = 5;
+  engine->adaptive.enabled = enabled;
+  engineInput(engine, Start, false);
+}
+
+/**
+ * @brief Скорость и веса фигур в границах, сумма весов постоянна.
+ */
+static void adaptiveCheckBounds(const engine_t *engine) {
+  ck_assert_int_ge(engine->game_info.speed, ADAPTIVE_SPEED_MIN);
+  ck_assert_int_le(engine->game_info.speed, ADAPTIVE_SPEED_MAX);
+  ck_assert_int_ge(engine->adaptive.skill, 0);
+  ck_assert_int_le(engine->adaptive.skill, ADAPTIVE_ONE);
+  int total = 0;
+  for (int i = 0; i < 7; i++) {
+    ck_assert_int_ge(engine->addinfo.piece_weights[i],
+                     ADAPTIVE_WEIGHT - ADAPTIVE_WEIGHT_RANGE);
+    ck_assert_int_le(engine->addinfo.piece_weights[i],
+                     ADAPTIVE_WEIGHT + ADAPTIVE_WEIGHT_RANGE);
+    total += engine->addinfo.piece_weights[i];
+  }
+  ck_assert_int_eq(total, 7 * ADAPTIVE_WEIGHT);
+}
+
+/**
+ * @brief Выключенный режим (и выключенный после игры с ним) дает ту же
+ * партию, что и игра без настройки.
+ */
+START_TEST(test_adaptive_off) {
+  engine_t plain = {0}, engine = {0};
+  engineInput(&plain, Start, true);
+  engineInput(&engine, Start, true);
+  adaptiveStart(&engine, true);
+  for (int i = 0; i < 50 && engine.state != GAMEOVER; i++)
+    engineInput(&engine, Down, true);
+  adaptiveStart(&plain, false);
+  adaptiveStart(&engine, false);
+  for (int i = 0; i < 7; i++)
+    ck_assert_int_eq(engine.addinfo.piece_weights[i], 0);
+  const UserAction_t actions[] = {Left, Action, Right, Right, Down};
+  for (int i = 0; plain.state != GAMEOVER; i++) {
+    UserAction_t action = actions[i % 5];
+    engineInput(&plain, action, action == Down);
+    engineInput(&engine, action, action == Down);
+    ck_assert_int_eq(engine.addinfo.next_id, plain.addinfo.next_id);
+  }
+  ck_assert_int_eq(engine.state, GAMEOVER);
+  ck_assert_int_eq(engine.game_info.score, plain.game_info.score);
+  ck_assert_uint_eq(engine.game_info.hash, plain.game_info.hash);
+  ck_assert_int_eq(engine.game_info.speed, plain.game_info.speed);
+  engineInput(&plain, Terminate, true);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Включение и выключение режима во время игры действуют со
+ * следующей игры: партия идет так же, как без переключения.
+ */
+START_TEST(test_adaptive_toggle) {
+  for (int enabled = 0; enabled < 2; enabled++) {
+    engine_t plain = {0}, engine = {0};
+    engineInput(&plain, Start, true);
+    engineInput(&engine, Start, true);
+    adaptiveStart(&plain, enabled);
+    adaptiveStart(&engine, enabled);
+    for (int i = 0; i < 5; i++) {
+      engineInput(&plain, Down, true);
+      engineInput(&engine, Down, true);
+    }
+    engine.adaptive.enabled = !enabled;
+    for (int i = 0; plain.state != GAMEOVER; i++) {
+      engineTick(&plain, 1 + i % 40);
+      engineTick(&engine, 1 + i % 40);
+      ck_assert_int_eq(engine.game_info.speed, plain.game_info.speed);
+      for (int j = 0; j < 7; j++)
+        ck_assert_int_eq(engine.addinfo.piece_weights[j],
+                         plain.addinfo.piece_weights[j]);
+      ck_assert_uint_eq(engine.game_info.hash, plain.game_info.hash);
+    }
+    ck_assert_int_eq(engine.state, GAMEOVER);
+    // Следующая игра - с новой настройкой
+    engine.state = START;
+    engineInput(&engine, Start, false);
+    ck_assert(engine.adaptive.active == !enabled);
+    ck_assert_int_eq(engine.addinfo.piece_weights[0],
+                     enabled ? 0 : ADAPTIVE_WEIGHT);
+    engineInput(&plain, Terminate, true);
+    engineInput(&engine, Terminate, true);
+  }
+}
+END_TEST;
+
+/**
+ * @brief Новичок (фигуры падают сами, стакан растет в середине): скорость
+ * ниже скорости уровня, удобных фигур больше.
+ */
+START_TEST(test_adaptive_slow) {
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  adaptiveStart(&engine, true);
+  adaptiveCheckBounds(&engine);
+  while (engine.state != GAMEOVER) {
+    unsigned int piece = engine.piece_count;
+    while (engine.state != GAMEOVER && engine.piece_count == piece)
+      engineTick(&engine, 1);
+    adaptiveCheckBounds(&engine);
+  }
+  ck_assert_int_lt(engine.adaptive.skill, ADAPTIVE_ONE / 4);
+  ck_assert_int_gt(engine.game_info.speed, START_SPEED);
+  ck_assert_int_gt(engine.addinfo.piece_weights[1], ADAPTIVE_WEIGHT);
+  ck_assert_int_lt(engine.addinfo.piece_weights[3], ADAPTIVE_WEIGHT);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Опытный игрок (бот, фигуры сбрасываются сразу): скорость выше
+ * скорости уровня, удобных фигур меньше.
+ */
+START_TEST(test_adaptive_fast) {
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  adaptiveStart(&engine, true);
+  bot_t *bot = botCreate(1000000000000LL);
+  ck_assert_ptr_nonnull(bot);
+  bot->max_depth = 2;
+  while (engine.state == MOVING && engine.piece_count < 100) {
+    bool hold;
+    UserAction_t action = botAction(bot, &engine, &hold);
+    engineInput(&engine, action, hold);
+    adaptiveCheckBounds(&engine);
+  }
+  ck_assert_int_gt(engine.adaptive.skill, ADAPTIVE_ONE * 3 / 4);
+  int level_speed = START_SPEED - (engine.game_info.level - 1) * STEP_SPEED;
+  ck_assert_int_lt(engine.game_info.speed, level_speed);
+  ck_assert_int_lt(engine.addinfo.piece_weights[1], ADAPTIVE_WEIGHT);
+  ck_assert_int_gt(engine.addinfo.piece_weights[3], ADAPTIVE_WEIGHT);
+  botDestroy(bot);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Фигуры выбираются только из фигур с ненулевым весом.
+ */
+START_TEST(test_adaptive_weights) {
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  adaptiveStart(&engine, false);
+  memset(engine.addinfo.piece_weights, 0, 7);
+  engine.addinfo.piece_weights[1] = 3;
+  // Очередь известных фигур заполнена до изменения весов
+  for (int i = 0; i < PREVIEW_MAX; i++)
+    genNextPiece(&engine.game_info, &engine.addinfo);
+  for (int i = 0; i < 100; i++) {
+    genNextPiece(&engine.game_info, &engine.addinfo);
+    ck_assert_int_eq(engine.addinfo.next_id, 1);
+  }
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+START_TEST(test_adaptive_field) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  int height, holes;
+  adaptiveFieldStats(field, &height, &holes);
+  ck_assert_int_eq(height, 0);
+  ck_assert_int_eq(holes, 0);
+  field[FIELD_ROWS - 5][2] = 1;
+  field[FIELD_ROWS - 1][2] = 1;
+  field[FIELD_ROWS - 1][7] = 1;
+  adaptiveFieldStats(field, &height, &holes);
+  ck_assert_int_eq(height, 5);
+  ck_assert_int_eq(holes, 3);
+  freeMatrix(field);
+}
+END_TEST;
+
+Suite *test_adaptive(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_adaptive");
+  tc = tcase_create("adaptive");
+  tcase_add_test(tc, test_adaptive_off);
+  tcase_add_test(tc, test_adaptive_toggle);
+  tcase_add_test(tc, test_adaptive_slow);
+  tcase_add_test(tc, test_adaptive_fast);
+  tcase_add_test(tc, test_adaptive_weights);
+  tcase_add_test(tc, test_adaptive_field);
+  suite_add_tcase(s, tc);
+  return s;
+}
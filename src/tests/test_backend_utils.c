@@ -11,8 +11,8 @@
 START_TEST(test_move) {
   // Создание матриц, начальное состояние, старт игры
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -35,17 +35,17 @@ START_TEST(test_move) {
   shiftPiece(&game_info, &fsm_addinfo, 1);
   ck_assert_int_eq(fsm_addinfo.col_pos, 6);
   // Но после ротации сдвиг возможен еще на 1 позицию вправо
-  rotatePiece(&game_info, &fsm_addinfo);
+  rotatePiece(&game_info, &fsm_addinfo, 1);
   shiftPiece(&game_info, &fsm_addinfo, 1);
   ck_assert_int_eq(fsm_addinfo.col_pos, 7);
   // Проверка, что ротация невозможна, по game_info.field[0][9]
   ck_assert_int_eq(game_info.field[0][9], 7);
-  rotatePiece(&game_info, &fsm_addinfo);
+  rotatePiece(&game_info, &fsm_addinfo, 1);
   ck_assert_int_eq(game_info.field[0][9], 7);
   // Но после сдвига влево ротация доступна
   shiftPiece(&game_info, &fsm_addinfo, -1);
   ck_assert_int_eq(game_info.field[1][9], 0);
-  rotatePiece(&game_info, &fsm_addinfo);
+  rotatePiece(&game_info, &fsm_addinfo, 1);
   ck_assert_int_eq(game_info.field[1][9], 7);
   // Проверка на препятствие на поле при сдвиге
   game_info.field[1][6] = 1;
@@ -61,13 +61,99 @@ START_TEST(test_move) {
 }
 END_TEST;
 
+/**
+ * @brief Вращение со смещением от стены (wall kick), против часовой стрелки,
+ * невозможность вращения в замкнутом пространстве
+ */
+START_TEST(test_kick) {
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
+  signal_t signal;
+  signal.signal = ACT_SIG;
+  signal.action = Start;
+  tetrisCreate(&game_info, &fsm_addinfo);
+  fsmOnStartMode(&signal, &game_info, &fsm_addinfo);
+  // Вертикальная I у левой стены (столбец 0)
+  getPiece(game_info.next, 1, 1);
+  fsm_addinfo.next_id = 1;
+  fsm_addinfo.next_rot_id = 1;
+  fsmOnSpawnMode(&game_info, &fsm_addinfo);
+  for (int i = 0; i < 6; i++) shiftPiece(&game_info, &fsm_addinfo, -1);
+  ck_assert_int_eq(fsm_addinfo.col_pos, -2);
+  ck_assert_int_eq(game_info.field[3][0], 2);
+  // Без смещения горизонтальная I вышла бы за стену, смещается на 2 вправо
+  rotatePiece(&game_info, &fsm_addinfo, 1);
+  ck_assert_int_eq(fsm_addinfo.piece_rot_id, 2);
+  ck_assert_int_eq(fsm_addinfo.col_pos, 0);
+  for (int j = 0; j < 4; j++) ck_assert_int_eq(game_info.field[0][j], 2);
+  ck_assert_int_eq(game_info.field[3][0], 0);
+  // Вращение обратно через FSM (против часовой стрелки)
+  signal.action = ActionCCW;
+  ck_assert_int_eq(fsmOnMovingMode(&signal, &game_info, &fsm_addinfo),
+                   MOVING);
+  ck_assert_int_eq(fsm_addinfo.piece_rot_id, 1);
+  for (int i = 0; i < 4; i++) ck_assert_int_eq(game_info.field[i][2], 2);
+  // Все проверки заняты препятствиями - фигура остается на месте
+  for (int i = 0; i < 6; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (j != 2) game_info.field[i][j] = 1;
+  rotatePiece(&game_info, &fsm_addinfo, -1);
+  ck_assert_int_eq(fsm_addinfo.piece_rot_id, 1);
+  ck_assert_int_eq(fsm_addinfo.col_pos, 0);
+  for (int i = 0; i < 4; i++) ck_assert_int_eq(game_info.field[i][2], 2);
+  tetrisDestroy(&game_info, &fsm_addinfo);
+}
+END_TEST;
+
+/**
+ * @brief Хеш поля, который ведет игра, после каждого шага совпадает с
+ * посчитанным заново по всем клеткам
+ */
+START_TEST(test_hash) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engine.addinfo.seed = 11;
+  engine.game_info.high_score = 0;
+  engineInput(&engine, Start, false);
+  ck_assert_uint_ne(engine.game_info.hash, 0);
+  unsigned int rnd = 5;
+  int cleared = 0;
+  for (int step = 0; step < 20000; step++) {
+    rnd = rnd * 1103515245u + 12345u;
+    UserAction_t action = (UserAction_t)(Left + (rnd >> 16) % 5);
+    int score = engine.game_info.score;
+    // Up - сдвиг вниз по таймеру, вместо Down - падение фигуры
+    if (action == Up) action = Down;
+    engineInput(&engine, action, action == Down && (rnd >> 24) % 4 == 0);
+    if (engine.game_info.score > score) cleared++;
+    if (engine.state == GAMEOVER) engineInput(&engine, Start, false);
+    if (engine.state == START) {
+      engineInput(&engine, Start, false);
+      // Нижняя строка без одной клетки - чтобы строки удалялись и при
+      // случайных ходах
+      for (int j = 0; j < FIELD_COLUMNS; j++)
+        if (j != SPAWN_COL + 1) engine.game_info.field[FIELD_ROWS - 1][j] = 1;
+      engine.game_info.hash = fieldHash(engine.game_info.field);
+    }
+    ck_assert_uint_eq(engine.game_info.hash,
+                      fieldHash(engine.game_info.field));
+  }
+  ck_assert_int_gt(cleared, 0);
+  // Одинаковые поля - одинаковый хеш, разные - разный
+  ck_assert_uint_eq(fieldHash(engine.game_info.field), engine.game_info.hash);
+  engine.game_info.field[19][0] = !engine.game_info.field[19][0];
+  ck_assert_uint_ne(fieldHash(engine.game_info.field), engine.game_info.hash);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
 /**
  * @brief Удаление 1 линии без повышения уровня и изменения скорости
  */
 START_TEST(test_score1) {
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -85,7 +171,7 @@ START_TEST(test_score1) {
     if (i != 5) game_info.field[19][i] = 1;
   }
   // Референсное поле после падения
-  int **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
   emptyField(ref);
   ref[17][5] = 2;
   ref[18][5] = 2;
@@ -105,7 +191,7 @@ START_TEST(test_score1) {
   int compare = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, ref);
   ck_assert_int_eq(compare, SUCCESSFUL_EXIT);
   tetrisDestroy(&game_info, &fsm_addinfo);
-  free(ref);
+  freeMatrix(ref);
 }
 END_TEST;
 
@@ -114,8 +200,8 @@ END_TEST;
  */
 START_TEST(test_score2) {
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -134,7 +220,7 @@ START_TEST(test_score2) {
     if (i != 5) game_info.field[19][i] = 1;
   }
   // Референсное поле после падения
-  int **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
   emptyField(ref);
   ref[18][5] = 2;
   ref[19][5] = 2;
@@ -153,7 +239,7 @@ START_TEST(test_score2) {
   int compare = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, ref);
   ck_assert_int_eq(compare, SUCCESSFUL_EXIT);
   tetrisDestroy(&game_info, &fsm_addinfo);
-  free(ref);
+  freeMatrix(ref);
 }
 END_TEST;
 
@@ -162,8 +248,8 @@ END_TEST;
  */
 START_TEST(test_score3) {
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -183,7 +269,7 @@ START_TEST(test_score3) {
     if (i != 5) game_info.field[19][i] = 1;
   }
   // Референсное поле после падения
-  int **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
   emptyField(ref);
   ref[19][5] = 2;
   int old_speed = game_info.speed;
@@ -201,7 +287,7 @@ START_TEST(test_score3) {
   int compare = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, ref);
   ck_assert_int_eq(compare, SUCCESSFUL_EXIT);
   tetrisDestroy(&game_info, &fsm_addinfo);
-  free(ref);
+  freeMatrix(ref);
 }
 END_TEST;
 
@@ -210,8 +296,8 @@ END_TEST;
  */
 START_TEST(test_score4) {
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -232,7 +318,7 @@ START_TEST(test_score4) {
     if (i != 5) game_info.field[19][i] = 1;
   }
   // Референсное поле после падения
-  int **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **ref = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
   emptyField(ref);
   int old_speed = game_info.speed;
   // Падение и отработка ATTACHING
@@ -249,7 +335,7 @@ START_TEST(test_score4) {
   int compare = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, ref);
   ck_assert_int_eq(compare, SUCCESSFUL_EXIT);
   tetrisDestroy(&game_info, &fsm_addinfo);
-  free(ref);
+  freeMatrix(ref);
 }
 END_TEST;
 
@@ -257,7 +343,7 @@ END_TEST;
  * @brief Запись рекорда в файл.
  */
 START_TEST(test_highscore) {
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
   FILE *file = fopen("highscore.txt", "w");
   fprintf(file, "%d", 0);
   fclose(file);
@@ -281,17 +367,39 @@ START_TEST(test_highscore) {
 }
 END_TEST;
 
+/**
+ * @brief Упакованные массивы: клетка - байт, строки подряд одним блоком.
+ */
+START_TEST(test_matrix_packed) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  ck_assert_ptr_nonnull(field);
+  ck_assert_uint_eq(sizeof(**field), 1);
+  for (int i = 1; i < FIELD_ROWS; i++)
+    ck_assert_ptr_eq(field[i], field[i - 1] + FIELD_COLUMNS);
+  ck_assert_ptr_eq(field[0], (cell_t *)(field + FIELD_ROWS));
+  field[FIELD_ROWS - 1][FIELD_COLUMNS - 1] = 7;
+  ck_assert_int_eq(field[0][FIELD_ROWS * FIELD_COLUMNS - 1], 7);
+  freeMatrix(field);
+  freeMatrix(NULL);
+  // Поле и шаблоны фигур - меньше половины памяти игры
+  ck_assert_uint_lt(engineMemory() - sizeof(engine_t), sizeof(engine_t));
+}
+END_TEST;
+
 Suite *test_backend_utils(void) {
   Suite *s;
   TCase *tc;
   s = suite_create("test_backend_utils");
   tc = tcase_create("back_utils");
   tcase_add_test(tc, test_move);
+  tcase_add_test(tc, test_kick);
+  tcase_add_test(tc, test_hash);
   tcase_add_test(tc, test_score1);
   tcase_add_test(tc, test_score2);
   tcase_add_test(tc, test_score3);
   tcase_add_test(tc, test_score4);
   tcase_add_test(tc, test_highscore);
+  tcase_add_test(tc, test_matrix_packed);
   suite_add_tcase(s, tc);
   return s;
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * @file test_board.c
+ * @brief Тест реализаций операций с полем: выбор реализации, одинаковые
+ * партии общей и специализированной реализаций
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+
+#include "../brick_game/tetris/s21_tetris_board.h"
+#include "tests_main.h"
+
+/**
+ * @brief Новая игра с заданной реализацией операций с полем.
+ */
+static void boardStart(engine_t *engine, board_kind kind, unsigned int seed) {
+  engineInput(engine, Start, true);
+  engine->board = boardSelect(kind);
+  engine->addinfo.seed = seed;
+  engine->game_info.high_score = 0;
+  // После GAMEOVER первый Start возвращает игру в START
+  while (engine->state != MOVING) engineInput(engine, Start, false);
+}
+
+/**
+ * @brief Совпадение состояния двух игр.
+ */
+static void boardCompare(const engine_t *a, const engine_t *b) {
+  ck_assert_int_eq(a->state, b->state);
+  ck_assert_int_eq(a->game_info.score, b->game_info.score);
+  ck_assert_int_eq(a->addinfo.row_pos, b->addinfo.row_pos);
+  ck_assert_int_eq(a->addinfo.col_pos, b->addinfo.col_pos);
+  ck_assert(a->game_info.hash == b->game_info.hash);
+  for (int i = 0; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      ck_assert_int_eq(a->game_info.field[i][j], b->game_info.field[i][j]);
+}
+
+/**
+ * @brief Выбор реализации: явный и через переменную окружения
+ */
+START_TEST(test_board_select) {
+  ck_assert_ptr_eq(boardSelect(BOARD_GENERIC), &board_generic);
+  ck_assert_ptr_eq(boardSelect(BOARD_STANDARD), &board_standard);
+  setenv(BOARD_ENV, "generic", 1);
+  ck_assert_ptr_eq(boardSelect(BOARD_AUTO), &board_generic);
+  setenv(BOARD_ENV, "standard", 1);
+  ck_assert_ptr_eq(boardSelect(BOARD_AUTO), &board_standard);
+  unsetenv(BOARD_ENV);
+  ck_assert_ptr_eq(boardSelect(BOARD_AUTO), &board_standard);
+  engine_t engine = {.state = START};
+  ck_assert_ptr_eq(engineBoard(&engine), &board_generic);
+  engineInput(&engine, Start, true);
+  ck_assert_ptr_eq(engineBoard(&engine), &board_standard);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Общая и специализированная реализации дают одинаковые партии
+ * (случайные действия, удаление строк, мусор)
+ */
+START_TEST(test_board_same_games) {
+  engine_t generic = {.state = START}, standard = {.state = START};
+  boardStart(&generic, BOARD_GENERIC, 7);
+  boardStart(&standard, BOARD_STANDARD, 7);
+  unsigned int rnd = 3;
+  int games = 0, cleared = 0;
+  for (int step = 0; step < 30000; step++) {
+    rnd = rnd * 1103515245u + 12345u;
+    UserAction_t action = (UserAction_t)(Left + (rnd >> 16) % 7);
+    if (action == Up) action = Down;
+    bool hold = action == Down && (rnd >> 24) % 3 == 0;
+    if ((rnd >> 20) % 97 == 0) {
+      // Мусор поднимается после фигуры без удаления строк
+      generic.garbage[0] = standard.garbage[0] = (rnd >> 8) % FIELD_COLUMNS;
+      generic.garbage_count = standard.garbage_count = 1;
+    }
+    engineInput(&generic, action, hold);
+    engineInput(&standard, action, hold);
+    if ((rnd >> 12) % 5 == 0) {
+      engineTick(&generic, 7);
+      engineTick(&standard, 7);
+    }
+    boardCompare(&generic, &standard);
+    if (standard.last_clear > 0) cleared++;
+    if (standard.state == GAMEOVER) {
+      games++;
+      boardStart(&generic, BOARD_GENERIC, 7 + games);
+      boardStart(&standard, BOARD_STANDARD, 7 + games);
+      // Нижние строки без одной клетки - чтобы строки удалялись
+      for (int i = FIELD_ROWS - 4; i < FIELD_ROWS; i++)
+        for (int j = 0; j < FIELD_COLUMNS; j++)
+          if (j != (i + games) % FIELD_COLUMNS)
+            generic.game_info.field[i][j] = standard.game_info.field[i][j] = 2;
+      generic.game_info.hash = fieldHash(generic.game_info.field);
+      standard.game_info.hash = fieldHash(standard.game_info.field);
+    }
+  }
+  ck_assert_int_gt(games, 100);
+  ck_assert_int_gt(cleared, 100);
+  engineInput(&generic, Terminate, true);
+  engineInput(&standard, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Удаление несмежных заполненных строк
+ */
+START_TEST(test_board_clear_rows) {
+  cell_t **a = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **b = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  for (int i = 0; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++) {
+      int value = i % 2 == 1 && i > 12 ? 1 : (i * 7 + j) % 3;
+      a[i][j] = b[i][j] = value;
+    }
+  ck_assert_int_eq(board_generic.clear_rows(a, 14, 18), 2);
+  ck_assert_int_eq(board_standard.clear_rows(b, 14, 18), 2);
+  ck_assert_int_eq(compareMatrix(FIELD_ROWS, FIELD_COLUMNS, a, b),
+                   SUCCESSFUL_EXIT);
+  // Строка 19 вне диапазона не удаляется
+  ck_assert_int_eq(b[FIELD_ROWS - 1][0], 1);
+  ck_assert_int_eq(board_standard.clear_rows(b, 0, FIELD_ROWS), 2);
+  ck_assert_int_eq(board_generic.clear_rows(a, 0, FIELD_ROWS), 2);
+  ck_assert_int_eq(compareMatrix(FIELD_ROWS, FIELD_COLUMNS, a, b),
+                   SUCCESSFUL_EXIT);
+  for (int j = 0; j < FIELD_COLUMNS; j++) ck_assert_int_eq(b[0][j], 0);
+  freeMatrix(a);
+  freeMatrix(b);
+}
+END_TEST;
+
+Suite *test_board(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_board");
+  tc = tcase_create("board");
+  tcase_add_test(tc, test_board_select);
+  tcase_add_test(tc, test_board_same_games);
+  tcase_add_test(tc, test_board_clear_rows);
+  suite_add_tcase(s, tc);
+  return s;
+}
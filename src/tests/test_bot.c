@@ -0,0 +1,99 @@
+/**
+ * @file test_bot.c
+ * @brief Тест бота: игра без проигрыша, таблица транспозиций, шаг через C ABI
+ */
+
+#include "../brick_game/tetris/s21_tetris_bot.h"
+#include "../brick_game/tetris/s21_tetris_lib.h"
+#include "tests_main.h"
+
+/**
+ * @brief Начало игры с заданным seed.
+ */
+static void startEngine(engine_t *engine, unsigned int seed) {
+  engineInput(engine, Start, true);
+  engine->addinfo.seed = seed;
+  engine->game_info.high_score = 0;
+  engineInput(engine, Start, false);
+}
+
+/**
+ * @brief Бот играет 200 фигур без проигрыша и удаляет строки
+ */
+START_TEST(test_bot_play) {
+  engine_t engine = {.state = START};
+  startEngine(&engine, 42);
+  // Глубина ограничена, времени с запасом - результат не зависит от машины
+  bot_t *bot = botCreate(1000000000000LL);
+  ck_assert_ptr_nonnull(bot);
+  bot->max_depth = 2;
+  // Вне состояния MOVING бот ничего не делает
+  engine_t idle = {.state = START};
+  bool hold = true;
+  ck_assert_int_eq(botAction(bot, &idle, &hold), Up);
+  ck_assert(!hold);
+  while (engine.state == MOVING && engine.piece_count < 200) {
+    UserAction_t action = botAction(bot, &engine, &hold);
+    ck_assert_int_ne(action, Up);
+    engineInput(&engine, action, hold);
+    ck_assert_int_le(bot->moves, BOT_MOVES_LIMIT + 1);
+  }
+  ck_assert_int_eq(engine.state, MOVING);
+  ck_assert_int_eq(bot->depth, 2);
+  ck_assert_int_gt(engine.game_info.score, 0);
+  botDestroy(bot);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Повторный поиск для того же поля берет оценки из таблицы
+ */
+START_TEST(test_bot_transposition) {
+  engine_t engine = {.state = START};
+  startEngine(&engine, 7);
+  bot_t *bot = botCreate(1000000000000LL);
+  ck_assert_ptr_nonnull(bot);
+  bot->max_depth = 3;
+  botPlan(bot, &engine);
+  ck_assert_int_eq(bot->depth, 3);
+  int mask = bot->target_mask, col = bot->target_col;
+  long long nodes = bot->nodes;
+  botPlan(bot, &engine);
+  ck_assert_int_gt(bot->tt_hits, 0);
+  ck_assert_int_lt(bot->nodes, nodes);
+  ck_assert_int_eq(bot->target_mask, mask);
+  ck_assert_int_eq(bot->target_col, col);
+  botDestroy(bot);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Шаги бота через C ABI библиотеки
+ */
+START_TEST(test_bot_lib) {
+  TetrisEngine_t *engine = tetrisEngineCreate(3);
+  ck_assert_ptr_nonnull(engine);
+  int stats[TETRIS_STAT_COUNT];
+  for (int i = 0; i < 300; i++) {
+    int state = tetrisEngineBotStep(engine, 200);
+    ck_assert(state == TETRIS_STATE_MOVING || state == TETRIS_STATE_GAMEOVER);
+  }
+  tetrisEngineObserve(engine, NULL, NULL, stats);
+  ck_assert_int_eq(stats[TETRIS_STAT_STATE], TETRIS_STATE_MOVING);
+  tetrisEngineDestroy(engine);
+}
+END_TEST;
+
+Suite *test_bot(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_bot");
+  tc = tcase_create("bot");
+  tcase_add_test(tc, test_bot_play);
+  tcase_add_test(tc, test_bot_transposition);
+  tcase_add_test(tc, test_bot_lib);
+  suite_add_tcase(s, tc);
+  return s;
+}
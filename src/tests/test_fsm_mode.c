@@ -10,8 +10,8 @@
 START_TEST(test_fsm_1) {
   // Создание матриц, начальное состояние START
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   // Переход в SPAWN
   signal.signal = ACT_SIG;
@@ -66,8 +66,8 @@ END_TEST;
 START_TEST(test_fsm_2) {
   // Создание матриц, начальное состояние
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   // Переход в SPAWN
   signal.signal = ACT_SIG;
@@ -75,7 +75,8 @@ START_TEST(test_fsm_2) {
   tetrisCreate(&game_info, &fsm_addinfo);
   state = fsmOnStartMode(&signal, &game_info, &fsm_addinfo);
   // Следующую фигуру меняю на квадрат, для предсказуемости
-  getPiece(game_info.next, 0, 0);
+  fsm_addinfo.next_id = 0;
+  fsm_addinfo.next_rot_id = 0;
   state = fsmOnSpawnMode(&game_info, &fsm_addinfo);
   // Переход в ATTACHING должен произойти на 19 сдвиге
   signal.action = Down;
@@ -95,8 +96,8 @@ END_TEST;
 START_TEST(test_fsm_3) {
   // Создание матриц, начальное состояние
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   signal_t signal;
   signal.signal = ACT_SIG;
   signal.action = Start;
@@ -119,8 +120,8 @@ END_TEST;
 START_TEST(test_fsm_start) {
   // Создание матриц, начальное состояние
   tetris_state state = START;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   tetrisCreate(&game_info, &fsm_addinfo);
   // Сигнал Start - переход в SPAWN
   signal_t signal;
@@ -174,8 +175,8 @@ END_TEST;
 START_TEST(test_fsm_moving) {
   // Создание матриц, начальное состояние
   tetris_state state = MOVING;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   tetrisCreate(&game_info, &fsm_addinfo);
   // Сигнал Start - остаемся в MOVING
   signal_t signal;
@@ -229,8 +230,8 @@ END_TEST;
 START_TEST(test_fsm_pause) {
   // Создание матриц, начальное состояние
   tetris_state state = PAUSE;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   tetrisCreate(&game_info, &fsm_addinfo);
   // Сигнал Start - остаемся в PAUSE
   signal_t signal;
@@ -284,8 +285,8 @@ END_TEST;
 START_TEST(test_fsm_spawn) {
   // Создание матриц, начальное состояние
   tetris_state state = SPAWN;
-  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0};
-  addinfo_t fsm_addinfo = {NULL, 0, 0, 0, 0, 0, 0};
+  GameInfo_t game_info = {NULL, NULL, 0, 0, 0, 0, 0, 0};
+  addinfo_t fsm_addinfo = {0};
   tetrisCreate(&game_info, &fsm_addinfo);
   emptyField(game_info.field);
   // Заполнение 0-й строки, чтобы фигура не могла лечь на поле
@@ -298,6 +299,180 @@ START_TEST(test_fsm_spawn) {
 }
 END_TEST;
 
+/**
+ * @brief SPAWN и ATTACHING проходятся за один шаг FSM, удаление строк при
+ * падении фигуры через fsmStep.
+ */
+START_TEST(test_fsm_step) {
+  engine_t engine = {.state = START};
+  tetrisCreate(&engine.game_info, &engine.addinfo);
+  engine.game_info.high_score = 0;
+  // Старт: через SPAWN сразу в MOVING
+  engineInput(&engine, Start, false);
+  ck_assert_int_eq(engine.state, MOVING);
+  // Следующая фигура - вертикальная I, под ней 4 почти заполненные строки
+  getPiece(engine.game_info.next, 1, 1);
+  engine.addinfo.next_id = 1;
+  engine.addinfo.next_rot_id = 1;
+  engineInput(&engine, Down, true);
+  ck_assert_int_eq(engine.state, MOVING);
+  emptyField(engine.game_info.field);
+  for (int i = 16; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (j != 5) engine.game_info.field[i][j] = 1;
+  placePieceOnField(&engine.game_info, &engine.addinfo);
+  // Падение: MOVING -> ATTACHING -> SPAWN -> MOVING за один вызов
+  engineInput(&engine, Down, true);
+  ck_assert_int_eq(engine.state, MOVING);
+  ck_assert_int_eq(engine.game_info.score, 1500);
+  ck_assert_int_eq(engine.game_info.level, 3);
+  for (int i = 4; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      ck_assert_int_eq(engine.game_info.field[i][j], 0);
+  // Игнорируемые события не меняют состояние
+  engineInput(&engine, Start, false);
+  ck_assert_int_eq(engine.state, MOVING);
+  tetrisDestroy(&engine.game_info, &engine.addinfo);
+}
+END_TEST;
+
+/**
+ * @brief Очередь фигур: следующая берется из начала очереди, в конец
+ * добавляется новая; порядок фигур зависит только от seed
+ */
+START_TEST(test_fsm_preview) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engine.addinfo.seed = 7;
+  engineInput(&engine, Start, false);
+  int ids[PREVIEW_MAX], rot_ids[PREVIEW_MAX];
+  for (int k = 0; k < PREVIEW_MAX; k++)
+    ids[k] = previewPiece(&engine.addinfo, k, &rot_ids[k]);
+  // После каждой фигуры очередь сдвигается на одну
+  for (int n = 1; n < PREVIEW_MAX; n++) {
+    engineInput(&engine, Down, true);
+    ck_assert_int_eq(engine.state, MOVING);
+    ck_assert_int_eq(engine.addinfo.piece_id, ids[n - 1]);
+    ck_assert_int_eq(engine.addinfo.piece_rot_id, rot_ids[n - 1]);
+    for (int k = 0; k < PREVIEW_MAX - n; k++) {
+      int rot_id, id = previewPiece(&engine.addinfo, k, &rot_id);
+      ck_assert_int_eq(id, ids[n + k]);
+      ck_assert_int_eq(rot_id, rot_ids[n + k]);
+    }
+  }
+  // Шаблон текущей фигуры берется из таблицы фигур
+  int mask = pieceMask(engine.addinfo.piece_id, engine.addinfo.piece_rot_id);
+  for (int i = 0; i < PIECE_ROWS; i++)
+    for (int j = 0; j < PIECE_COLUMNS; j++)
+      ck_assert_int_eq(engine.addinfo.piece[i][j] != 0,
+                       (mask >> (i * PIECE_COLUMNS + j)) & 1);
+  // Матрица next (по ТЗ) для GUI строится по id при чтении состояния
+  engineInput(&engine, Terminate, true);
+  userInput(Start, true);
+  userInput(Start, false);
+  GameInfo_t game_info = updateCurrentState();
+  const addinfo_t *gui = &fsmGuiEngine()->addinfo;
+  mask = pieceMask(gui->next_id, gui->next_rot_id);
+  for (int i = 0; i < PIECE_ROWS; i++)
+    for (int j = 0; j < PIECE_COLUMNS; j++)
+      ck_assert_int_eq(game_info.next[i][j],
+                       (mask >> (i * PIECE_COLUMNS + j)) & 1
+                           ? gui->next_id + 1
+                           : 0);
+  userInput(Terminate, false);
+  userInput(Start, false);
+  userInput(Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Несколько игр GUI в одном процессе (fsmGuiUse): функции API
+ * меняют только текущую игру, NULL - игра по умолчанию
+ */
+START_TEST(test_fsm_gui_use) {
+  engine_t first = {.state = START}, second = {.state = START};
+  fsmGuiUse(&first);
+  userInput(Start, true);
+  fsmGuiSeed(3);
+  userInput(Start, false);
+  ck_assert_ptr_eq(fsmGuiEngine(), &first);
+  ck_assert(first.high_score_file);
+  ck_assert(!second.high_score_file);
+  fsmGuiUse(&second);
+  ck_assert_ptr_eq(fsmGuiEngine(), &second);
+  userInput(Start, true);
+  ck_assert_int_eq(updateCurrentState().pause, START_MODE);
+  userInput(Start, false);
+  userInput(Down, true);
+  ck_assert_int_eq(second.piece_count, 2);
+  ck_assert_int_eq(first.piece_count, 1);
+  ck_assert_int_eq(first.state, MOVING);
+  fsmGuiUse(NULL);
+  ck_assert_ptr_ne(fsmGuiEngine(), &first);
+  ck_assert_ptr_ne(fsmGuiEngine(), &second);
+  ck_assert_int_eq(fsmGuiEngine()->state, START);
+  fsmGuiUse(&first);
+  ck_assert_int_eq(updateCurrentState().pause, GAME_MODE);
+  userInput(Terminate, true);
+  fsmGuiUse(&second);
+  userInput(Terminate, true);
+  fsmGuiUse(NULL);
+}
+END_TEST;
+
+/**
+ * @brief Отложение фигуры: первая откладывается и появляется следующая,
+ * затем фигуры меняются местами, не чаще раза на фигуру
+ */
+START_TEST(test_fsm_hold) {
+  remove("highscore.txt");
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engine.game_info.high_score = 0;
+  engineInput(&engine, Start, false);
+  int first = engine.addinfo.piece_id, first_rot = engine.addinfo.piece_rot_id;
+  int next = engine.addinfo.next_id;
+  unsigned int pieces = engine.piece_count;
+  engineInput(&engine, Left, false);
+  engineInput(&engine, Hold, false);
+  ck_assert_int_eq(engine.state, MOVING);
+  ck_assert(engine.addinfo.has_hold);
+  ck_assert_int_eq(engine.addinfo.hold_id, first);
+  ck_assert_int_eq(engine.addinfo.hold_rot_id, first_rot);
+  ck_assert_int_eq(engine.addinfo.piece_id, next);
+  ck_assert_uint_eq(engine.piece_count, pieces + 1);
+  // Повторное отложение той же фигуры игнорируется
+  int second = engine.addinfo.piece_id;
+  engineInput(&engine, Hold, false);
+  ck_assert_int_eq(engine.addinfo.piece_id, second);
+  ck_assert_int_eq(engine.addinfo.hold_id, first);
+  // После закрепления - обмен: отложенная появляется в стартовой позиции
+  engineInput(&engine, Down, true);
+  int third = engine.addinfo.piece_id;
+  engineInput(&engine, Down, false);
+  engineInput(&engine, Hold, false);
+  ck_assert_int_eq(engine.state, MOVING);
+  ck_assert_int_eq(engine.addinfo.piece_id, first);
+  ck_assert_int_eq(engine.addinfo.hold_id, third);
+  ck_assert_int_eq(engine.addinfo.row_pos, 0);
+  ck_assert_int_eq(engine.addinfo.col_pos, SPAWN_COL);
+  ck_assert_uint_eq(engine.piece_count, pieces + 2);
+  ck_assert(engine.game_info.hash == fieldHash(engine.game_info.field));
+  // Обмен на фигуру, которую некуда поместить, заканчивает игру
+  engineInput(&engine, Down, true);
+  for (int i = 0; i < PIECE_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++) engine.game_info.field[i][j] = 1;
+  engineInput(&engine, Hold, false);
+  ck_assert_int_eq(engine.state, GAMEOVER);
+  engine.game_info.score = 100;
+  engineInput(&engine, Hold, false);
+  ck_assert_int_eq(engine.state, START);
+  // Рекорд в файл записывают только игры GUI
+  ck_assert_ptr_null(fopen("highscore.txt", "r"));
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
 Suite *test_fsm_mode(void) {
   Suite *s;
   TCase *tc;
@@ -310,6 +485,10 @@ Suite *test_fsm_mode(void) {
   tcase_add_test(tc, test_fsm_moving);
   tcase_add_test(tc, test_fsm_pause);
   tcase_add_test(tc, test_fsm_spawn);
+  tcase_add_test(tc, test_fsm_step);
+  tcase_add_test(tc, test_fsm_preview);
+  tcase_add_test(tc, test_fsm_hold);
+  tcase_add_test(tc, test_fsm_gui_use);
   suite_add_tcase(s, tc);
   return s;
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file test_hint.c
+ * @brief Тест подсказки хода: размещение на поле, повторный поиск только
+ * при изменении фигуры или поля
+ */
+
+#include "../brick_game/tetris/s21_tetris_hint.h"
+#include "../brick_game/tetris/s21_tetris_snapshot.h"
+#include "tests_main.h"
+
+/**
+ * @brief Размещение подсказки - поворот текущей фигуры, который помещается
+ * на поле без нее и не может опуститься ниже.
+ */
+static void hintCheckPlace(const hint_t *hint, const engine_t *engine) {
+  const addinfo_t *fsm_addinfo = &engine->addinfo;
+  bool rotation = false;
+  for (int rot_id = 0; rot_id < 4; rot_id++)
+    rotation = rotation || pieceMask(fsm_addinfo->piece_id, rot_id) ==
+                               hint->mask;
+  ck_assert(rotation);
+  ck_assert_int_eq(hint->piece_id, fsm_addinfo->piece_id);
+  snapshot_t *snapshot = snapshotFromEngine(engine);
+  ck_assert(snapshotFits(snapshot, hint->mask, hint->row, hint->col));
+  ck_assert(!snapshotFits(snapshot, hint->mask, hint->row + 1, hint->col));
+  snapshotRelease(snapshot);
+}
+
+/**
+ * @brief Сдвиги и вращения фигуры не вызывают поиск, новая фигура -
+ * вызывает.
+ */
+START_TEST(test_hint_moves) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engine.addinfo.seed = 42;
+  engineInput(&engine, Start, false);
+  hint_t *hint = hintCreate(HINT_BUDGET);
+  ck_assert_ptr_nonnull(hint);
+  ck_assert(hintUpdate(hint, &engine));
+  ck_assert_int_eq(hint->plans, 1);
+  ck_assert_int_ge(hint->bot->depth, 1);
+  hintCheckPlace(hint, &engine);
+  int mask = hint->mask, row = hint->row, col = hint->col;
+  engineInput(&engine, Left, false);
+  engineInput(&engine, Action, false);
+  engineInput(&engine, Up, true);
+  for (int i = 0; i < 3; i++) ck_assert(hintUpdate(hint, &engine));
+  ck_assert_int_eq(hint->plans, 1);
+  ck_assert_int_eq(hint->cached, 3);
+  ck_assert_int_eq(hint->mask, mask);
+  ck_assert_int_eq(hint->row, row);
+  ck_assert_int_eq(hint->col, col);
+  unsigned int piece = engine.piece_count;
+  engineInput(&engine, Down, true);
+  ck_assert_uint_ne(engine.piece_count, piece);
+  ck_assert(hintUpdate(hint, &engine));
+  ck_assert_int_eq(hint->plans, 2);
+  hintCheckPlace(hint, &engine);
+  hintDestroy(hint);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Изменение поля под фигурой (как строки соперника в versus) и
+ * обмен с отложенной фигурой вызывают поиск, вне MOVING подсказки нет.
+ */
+START_TEST(test_hint_board) {
+  engine_t engine = {.state = START};
+  hint_t *hint = hintCreate(HINT_BUDGET);
+  ck_assert(!hintUpdate(hint, &engine));
+  engineInput(&engine, Start, true);
+  engineInput(&engine, Start, false);
+  ck_assert(hintUpdate(hint, &engine));
+  engine.game_info.field[FIELD_ROWS - 1][0] = 1;
+  engine.game_info.hash ^= zobrist_keys[FIELD_ROWS - 1][0];
+  ck_assert(hintUpdate(hint, &engine));
+  ck_assert_int_eq(hint->plans, 2);
+  hintCheckPlace(hint, &engine);
+  int piece_id = engine.addinfo.piece_id;
+  engineInput(&engine, Hold, false);
+  ck_assert(hintUpdate(hint, &engine));
+  ck_assert_int_eq(hint->plans, engine.addinfo.piece_id != piece_id ? 3 : 2);
+  hintCheckPlace(hint, &engine);
+  engineInput(&engine, Pause, false);
+  ck_assert(!hintUpdate(hint, &engine));
+  hintDestroy(hint);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+Suite *test_hint(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_hint");
+  tc = tcase_create("hint");
+  tcase_add_test(tc, test_hint_moves);
+  tcase_add_test(tc, test_hint_board);
+  suite_add_tcase(s, tc);
+  return s;
+}
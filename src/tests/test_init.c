@@ -16,7 +16,7 @@ START_TEST(test_create) {
   ck_assert_ptr_ne(game_info.field, NULL);
   ck_assert_ptr_ne(game_info.next, NULL);
   // Проверка, что поле игры на старте пустое
-  int **empty = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  cell_t **empty = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
   for (int i = 0; i < FIELD_ROWS; i++)
     for (int j = 0; j < FIELD_COLUMNS; j++) empty[i][j] = 0;
   int res = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, empty);
@@ -28,7 +28,7 @@ START_TEST(test_create) {
   ck_assert_int_eq(game_info.pause, GAME_MODE);
   res = compareMatrix(FIELD_ROWS, FIELD_COLUMNS, game_info.field, empty);
   ck_assert_int_eq(res, FAILURE_EXIT);
-  free(empty);
+  freeMatrix(empty);
   // Проверка, что есть информация о следующей фигуре
   empty = createMatrix(PIECE_ROWS, PIECE_COLUMNS);
   for (int i = 0; i < PIECE_ROWS; i++)
@@ -36,7 +36,7 @@ START_TEST(test_create) {
   res = compareMatrix(PIECE_ROWS, PIECE_COLUMNS, game_info.next, empty);
   ck_assert_int_eq(res, FAILURE_EXIT);
   userInput(Terminate, true);
-  free(empty);
+  freeMatrix(empty);
 }
 END_TEST;
 
@@ -70,6 +70,34 @@ START_TEST(test_high_score) {
 }
 END_TEST;
 
+/**
+ * @brief Предзагрузка рекорда: прочитанное значение сохраняется и файл
+ * больше не читается, новый рекорд и новая предзагрузка его заменяют
+ */
+START_TEST(test_high_score_prefetch) {
+  char filename[] = "highscore.txt";
+  FILE *file = fopen(filename, "w");
+  fprintf(file, "%d", 2500);
+  fclose(file);
+  highScorePrefetch();
+  // Повторный запуск до получения результата не создает второй поток
+  highScorePrefetch();
+  ck_assert_int_eq(getHighScore(), 2500);
+  file = fopen(filename, "w");
+  fprintf(file, "%d", 3100);
+  fclose(file);
+  ck_assert_int_eq(getHighScore(), 2500);
+  highScorePrefetch();
+  ck_assert_int_eq(getHighScore(), 3100);
+  GameInfo_t game_info = {.score = 4000, .high_score = 4000};
+  saveHighScore(&game_info);
+  ck_assert_int_eq(getHighScore(), 4000);
+  remove(filename);
+  highScorePrefetch();
+  ck_assert_int_eq(getHighScore(), 0);
+}
+END_TEST;
+
 Suite *test_init(void) {
   Suite *s;
   TCase *tc;
@@ -77,6 +105,7 @@ Suite *test_init(void) {
   tc = tcase_create("create");
   tcase_add_test(tc, test_create);
   tcase_add_test(tc, test_high_score);
+  tcase_add_test(tc, test_high_score_prefetch);
   suite_add_tcase(s, tc);
   return s;
 }
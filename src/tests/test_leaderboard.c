@@ -0,0 +1,255 @@
+/**
+ * @file test_leaderboard.c
+ * @brief Тест таблицы рекордов: лучшие результаты, лучший результат игрока,
+ * процентиль, восстановление из журнала и индекса
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../brick_game/tetris/s21_tetris_leaderboard.h"
+#include "tests_main.h"
+
+/**
+ * @brief Временный каталог хранилища.
+ */
+static void lbTestDir(char *dir, size_t size) {
+  snprintf(dir, size, "/tmp/s21_tetris_lb_XXXXXX");
+  ck_assert_ptr_nonnull(mkdtemp(dir));
+}
+
+/**
+ * @brief Удаление файлов хранилища и каталога.
+ */
+static void lbTestRemove(const char *dir) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, LB_LOG_FILE);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/%s", dir, LB_INDEX_FILE);
+  unlink(path);
+  rmdir(dir);
+}
+
+/**
+ * @brief Добавление результата игрока со счетом score.
+ */
+static void lbTestAdd(leaderboard_t *lb, const char *player, int score) {
+  lb_result_t result = {0};
+  snprintf(result.player, LB_NAME_SIZE, "%s", player);
+  result.score = score;
+  result.lines = score / 100;
+  ck_assert_int_eq(lbAdd(lb, &result), SUCCESSFUL_EXIT);
+}
+
+/**
+ * @brief Лучшие результаты по убыванию счета, больше LB_TOP_K не хранится
+ */
+START_TEST(test_leaderboard_top) {
+  char dir[64];
+  lbTestDir(dir, sizeof(dir));
+  leaderboard_t *lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  lb_result_t top[LB_TOP_K + 1];
+  ck_assert_int_eq(lbTop(lb, top, LB_TOP_K), 0);
+  // Счета 0, 7, 14, ... в перемешанном порядке
+  for (int i = 0; i < LB_TOP_K * 3; i++)
+    lbTestAdd(lb, "a", (i * 37 % (LB_TOP_K * 3)) * 7);
+  ck_assert_int_eq(lbCount(lb), LB_TOP_K * 3);
+  ck_assert_int_eq(lbTop(lb, top, 3), 3);
+  ck_assert_int_eq(top[0].score, (LB_TOP_K * 3 - 1) * 7);
+  ck_assert_int_eq(top[1].score, (LB_TOP_K * 3 - 2) * 7);
+  ck_assert_int_eq(top[2].score, (LB_TOP_K * 3 - 3) * 7);
+  ck_assert_int_eq(lbTop(lb, top, LB_TOP_K + 1), LB_TOP_K);
+  for (int i = 1; i < LB_TOP_K; i++)
+    ck_assert_int_eq(top[i].score, top[i - 1].score - 7);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  lbTestRemove(dir);
+}
+END_TEST;
+
+/**
+ * @brief Лучший результат и количество игр каждого игрока, процентиль
+ */
+START_TEST(test_leaderboard_player) {
+  char dir[64];
+  lbTestDir(dir, sizeof(dir));
+  leaderboard_t *lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  lb_result_t best;
+  long long games = 0;
+  ck_assert_int_eq(lbPlayerBest(lb, "bob", &best, &games), FAILURE_EXIT);
+  ck_assert_double_eq_tol(lbPercentile(lb, 100), 0, 1e-9);
+  // Игроков больше начального размера таблицы
+  char name[LB_NAME_SIZE];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(name, sizeof(name), "p%d", i % 250);
+    lbTestAdd(lb, name, i);
+  }
+  lbTestAdd(lb, "bob", 300);
+  lbTestAdd(lb, "bob", 900);
+  lbTestAdd(lb, "bob", 500);
+  // Имя длиннее LB_NAME_SIZE обрезается
+  lbTestAdd(lb, "a_very_long_player_name", 7);
+  ck_assert_int_eq(lbPlayerBest(lb, "bob", &best, &games), SUCCESSFUL_EXIT);
+  ck_assert_int_eq(best.score, 900);
+  ck_assert_int_eq(best.lines, 9);
+  ck_assert_int_eq(games, 3);
+  ck_assert_int_eq(lbPlayerBest(lb, "p17", &best, &games), SUCCESSFUL_EXIT);
+  ck_assert_int_eq(best.score, 767);
+  ck_assert_int_eq(games, 4);
+  ck_assert_int_eq(lbPlayerBest(lb, "a_very_long_pla", &best, &games),
+                   SUCCESSFUL_EXIT);
+  ck_assert_int_eq(lbPlayerBest(lb, "p250", &best, &games), FAILURE_EXIT);
+  // Счета 0..999, 300, 900, 500, 7
+  ck_assert_double_eq_tol(lbPercentile(lb, 0), 0, 1e-9);
+  ck_assert_double_eq_tol(lbPercentile(lb, 500), 502.0 / 1004 * 100, 1e-9);
+  ck_assert_double_eq_tol(lbPercentile(lb, 5000), 100, 1e-9);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  lbTestRemove(dir);
+}
+END_TEST;
+
+/**
+ * @brief Повторное открытие (в том числе в отдельном потоке): индекс после
+ * закрытия, журнал без закрытия, недописанная последняя запись журнала
+ */
+START_TEST(test_leaderboard_reopen) {
+  char dir[64];
+  lbTestDir(dir, sizeof(dir));
+  leaderboard_t *lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  for (int i = 0; i < LB_TAIL_MAX + 10; i++) lbTestAdd(lb, "a", i);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  // Индекс и журнал, открытие в отдельном потоке
+  lb_pending_t pending;
+  lbOpenStart(&pending, dir);
+  lb = lbOpenWait(&pending);
+  ck_assert_ptr_nonnull(lb);
+  ck_assert_int_eq(lbCount(lb), LB_TAIL_MAX + 10);
+  ck_assert_double_eq_tol(lbPercentile(lb, 10),
+                          10.0 / (LB_TAIL_MAX + 10) * 100, 1e-9);
+  lbTestAdd(lb, "b", -5);
+  lbTestAdd(lb, "b", 100000);
+  ck_assert_int_eq(lbFlush(lb), SUCCESSFUL_EXIT);
+  // Без закрытия (как после падения): индекс устарел, хвост журнала
+  // дочитывается
+  leaderboard_t *copy = lbOpen(dir);
+  ck_assert_ptr_nonnull(copy);
+  ck_assert_int_eq(lbCount(copy), LB_TAIL_MAX + 12);
+  ck_assert_double_eq_tol(lbPercentile(copy, 0),
+                          1.0 / (LB_TAIL_MAX + 12) * 100, 1e-9);
+  lb_result_t top[2];
+  ck_assert_int_eq(lbTop(copy, top, 2), 2);
+  ck_assert_int_eq(top[0].score, 100000);
+  ck_assert_str_eq(top[0].player, "b");
+  ck_assert_int_eq(top[1].score, LB_TAIL_MAX + 9);
+  ck_assert_int_eq(lbClose(copy), SUCCESSFUL_EXIT);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  // Недописанная запись отрезается
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, LB_LOG_FILE);
+  int fd = open(path, O_WRONLY | O_APPEND);
+  ck_assert_int_ge(fd, 0);
+  ck_assert_int_eq(write(fd, "partial", 7), 7);
+  close(fd);
+  lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  ck_assert_int_eq(lbCount(lb), LB_TAIL_MAX + 12);
+  lbTestAdd(lb, "c", 200000);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  ck_assert_int_eq(lbCount(lb), LB_TAIL_MAX + 13);
+  ck_assert_int_eq(lbTop(lb, top, 1), 1);
+  ck_assert_str_eq(top[0].player, "c");
+  long long games;
+  ck_assert_int_eq(lbPlayerBest(lb, "b", top, &games), SUCCESSFUL_EXIT);
+  ck_assert_int_eq(games, 2);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  lbTestRemove(dir);
+}
+END_TEST;
+
+/**
+ * @brief Неполная запись пачки (ограничение размера файла): следующая
+ * запись продолжает пачку, записи в журнале не повторяются
+ */
+START_TEST(test_leaderboard_short_write) {
+  char dir[64];
+  lbTestDir(dir, sizeof(dir));
+  leaderboard_t *lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  for (int i = 0; i < LB_BATCH - 1; i++) lbTestAdd(lb, "a", i);
+  struct rlimit limit, old;
+  ck_assert_int_eq(getrlimit(RLIMIT_FSIZE, &old), 0);
+  limit = old;
+  limit.rlim_cur = sizeof(lb_result_t) * 10 + 5;
+  void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+  ck_assert_int_eq(setrlimit(RLIMIT_FSIZE, &limit), 0);
+  lb_result_t result = {.player = "b", .score = LB_BATCH};
+  ck_assert_int_eq(lbAdd(lb, &result), FAILURE_EXIT);
+  ck_assert_int_eq(setrlimit(RLIMIT_FSIZE, &old), 0);
+  signal(SIGXFSZ, handler);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, LB_LOG_FILE);
+  struct stat st;
+  ck_assert_int_eq(stat(path, &st), 0);
+  ck_assert_int_eq(st.st_size, LB_BATCH * sizeof(lb_result_t));
+  lb = lbOpen(dir);
+  ck_assert_ptr_nonnull(lb);
+  ck_assert_int_eq(lbCount(lb), LB_BATCH);
+  lb_result_t top[1];
+  ck_assert_int_eq(lbTop(lb, top, 1), 1);
+  ck_assert_str_eq(top[0].player, "b");
+  long long games;
+  ck_assert_int_eq(lbPlayerBest(lb, "a", top, &games), SUCCESSFUL_EXIT);
+  ck_assert_int_eq(games, LB_BATCH - 1);
+  ck_assert_int_eq(lbClose(lb), SUCCESSFUL_EXIT);
+  lbTestRemove(dir);
+}
+END_TEST;
+
+/**
+ * @brief Результат законченной игры движка
+ */
+START_TEST(test_leaderboard_engine) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engine.addinfo.seed = 11;
+  engine.game_info.high_score = 0;
+  engineInput(&engine, Start, false);
+  for (int i = 0; i < 1000 && engine.state != GAMEOVER; i++)
+    engineInput(&engine, Down, false);
+  ck_assert_int_eq(engine.state, GAMEOVER);
+  lb_result_t result;
+  lbResultFromEngine(&engine, "tester", &result);
+  ck_assert_str_eq(result.player, "tester");
+  ck_assert_uint_eq(result.seed, 11);
+  ck_assert_int_eq(result.score, engine.game_info.score);
+  ck_assert_int_eq(result.level, engine.game_info.level);
+  ck_assert_int_eq(result.lines, engine.lines);
+  ck_assert_int_ge(result.duration_ms, 0);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+Suite *test_leaderboard(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_leaderboard");
+  tc = tcase_create("leaderboard");
+  tcase_add_test(tc, test_leaderboard_top);
+  tcase_add_test(tc, test_leaderboard_player);
+  tcase_add_test(tc, test_leaderboard_reopen);
+  tcase_add_test(tc, test_leaderboard_short_write);
+  tcase_add_test(tc, test_leaderboard_engine);
+  suite_add_tcase(s, tc);
+  return s;
+}
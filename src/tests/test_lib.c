@@ -0,0 +1,96 @@
+/**
+ * @file test_lib.c
+ * @brief Тест C ABI библиотеки: создание, сброс, шаги, наблюдение, удаление
+ */
+
+#include "../brick_game/tetris/s21_tetris_lib.h"
+#include "tests_main.h"
+
+/**
+ * @brief Создание игры, наблюдение и одиночные шаги
+ */
+START_TEST(test_lib_step) {
+  int field[TETRIS_FIELD_CELLS], next[TETRIS_NEXT_CELLS],
+      stats[TETRIS_STAT_COUNT];
+  TetrisEngine_t *engine = tetrisEngineCreate(1);
+  ck_assert_ptr_ne(engine, NULL);
+  // После создания игра сразу запущена, фигура на поле
+  tetrisEngineObserve(engine, field, next, stats);
+  ck_assert_int_eq(stats[TETRIS_STAT_STATE], TETRIS_STATE_MOVING);
+  ck_assert_int_eq(stats[TETRIS_STAT_PAUSE], GAME_MODE);
+  ck_assert_int_eq(stats[TETRIS_STAT_SCORE], 0);
+  ck_assert_int_eq(stats[TETRIS_STAT_LEVEL], 1);
+  int filled = 0;
+  for (int i = 0; i < TETRIS_FIELD_CELLS; i++) filled += field[i] != 0;
+  ck_assert_int_eq(filled, 4);
+  filled = 0;
+  for (int i = 0; i < TETRIS_NEXT_CELLS; i++) filled += next[i] != 0;
+  ck_assert_int_eq(filled, 4);
+  // Неизвестное действие не выполняется
+  ck_assert_int_eq(tetrisEngineStep(engine, 100, 0), -1);
+  // Падение фигуры: новая фигура снова в состоянии MOVING
+  ck_assert_int_eq(tetrisEngineStep(engine, TETRIS_ACTION_DOWN, 1),
+                   TETRIS_STATE_MOVING);
+  tetrisEngineObserve(engine, field, NULL, NULL);
+  filled = 0;
+  for (int i = 0; i < TETRIS_FIELD_CELLS; i++) filled += field[i] != 0;
+  ck_assert_int_eq(filled, 8);
+  // Пауза и выход из игры
+  ck_assert_int_eq(tetrisEngineStep(engine, TETRIS_ACTION_PAUSE, 0),
+                   TETRIS_STATE_PAUSE);
+  ck_assert_int_eq(tetrisEngineStep(engine, TETRIS_ACTION_TERMINATE, 1),
+                   TETRIS_STATE_GAMEOVER);
+  // Сброс - новая партия с пустым полем и одной фигурой
+  ck_assert_int_eq(tetrisEngineReset(engine, 2), TETRIS_STATE_MOVING);
+  tetrisEngineObserve(engine, field, NULL, stats);
+  filled = 0;
+  for (int i = 0; i < TETRIS_FIELD_CELLS; i++) filled += field[i] != 0;
+  ck_assert_int_eq(filled, 4);
+  ck_assert_int_eq(stats[TETRIS_STAT_PAUSE], GAME_MODE);
+  tetrisEngineDestroy(engine);
+}
+END_TEST;
+
+/**
+ * @brief Пакетные шаги и повторяемость партии при одинаковом seed
+ */
+START_TEST(test_lib_batch) {
+  int field_1[TETRIS_FIELD_CELLS], field_2[TETRIS_FIELD_CELLS];
+  int stats_1[TETRIS_STAT_COUNT], stats_2[TETRIS_STAT_COUNT];
+  int actions[64], holds[64];
+  for (int i = 0; i < 64; i++) {
+    actions[i] = TETRIS_ACTION_LEFT + i % 5;
+    holds[i] = i % 7 == 0;
+  }
+  TetrisEngine_t *engine_1 = tetrisEngineCreate(7);
+  TetrisEngine_t *engine_2 = tetrisEngineCreate(7);
+  int done_1 = tetrisEngineStepBatch(engine_1, actions, holds, 64);
+  int done_2 = 0;
+  for (int i = 0; i < done_1; i++, done_2++)
+    tetrisEngineStep(engine_2, actions[i], holds[i]);
+  ck_assert_int_eq(done_1, done_2);
+  tetrisEngineObserve(engine_1, field_1, NULL, stats_1);
+  tetrisEngineObserve(engine_2, field_2, NULL, stats_2);
+  for (int i = 0; i < TETRIS_FIELD_CELLS; i++)
+    ck_assert_int_eq(field_1[i], field_2[i]);
+  for (int i = 0; i < TETRIS_STAT_COUNT; i++)
+    ck_assert_int_eq(stats_1[i], stats_2[i]);
+  // Пакет останавливается на окончании игры
+  int stop[3] = {TETRIS_ACTION_TERMINATE, TETRIS_ACTION_LEFT,
+                 TETRIS_ACTION_LEFT};
+  ck_assert_int_eq(tetrisEngineStepBatch(engine_1, stop, NULL, 3), 1);
+  tetrisEngineDestroy(engine_1);
+  tetrisEngineDestroy(engine_2);
+}
+END_TEST;
+
+Suite *test_lib(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_lib");
+  tc = tcase_create("lib");
+  tcase_add_test(tc, test_lib_step);
+  tcase_add_test(tc, test_lib_batch);
+  suite_add_tcase(s, tc);
+  return s;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_metrics.c
+ * @brief Тест метрик: счетчики игры, суммирование, экспорт в Prometheus
+ */
+
+#include "tests_main.h"
+
+/**
+ * @brief Счетчики удаления строк, фигур, уровня и ввода
+ */
+START_TEST(test_metrics_counters) {
+  engine_t engine = {.state = START};
+  tetrisCreate(&engine.game_info, &engine.addinfo);
+  metricsRegister(&engine.metrics);
+  engine.game_info.high_score = 0;
+  engineInput(&engine, Start, false);
+  ck_assert_uint_eq(engine.metrics.games_started, 1);
+  // Следующая фигура - вертикальная I, под ней 4 почти заполненные строки
+  getPiece(engine.game_info.next, 1, 1);
+  engine.addinfo.next_id = 1;
+  engine.addinfo.next_rot_id = 1;
+  engineInput(&engine, Down, true);
+  emptyField(engine.game_info.field);
+  for (int i = 16; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      if (j != 5) engine.game_info.field[i][j] = 1;
+  placePieceOnField(&engine.game_info, &engine.addinfo);
+  engineInput(&engine, Down, true);
+  ck_assert_uint_eq(engine.metrics.clears[4], 1);
+  ck_assert_uint_eq(engine.metrics.clears[1], 0);
+  ck_assert_uint_eq(engine.metrics.level_ups, 2);
+  ck_assert_uint_eq(engine.metrics.pieces[1], 1);
+  unsigned long long pieces = 0;
+  for (int i = 0; i < PIECE_TYPES; i++) pieces += engine.metrics.pieces[i];
+  ck_assert_uint_eq(pieces, 3);
+  ck_assert_uint_eq(engine.metrics.inputs, 3);
+  // Окончание игры по Esc
+  engineInput(&engine, Terminate, false);
+  unsigned long long games = 0;
+  for (int i = 0; i < METRICS_DURATION_BUCKETS; i++)
+    games += engine.metrics.game_duration[i];
+  ck_assert_uint_eq(games, 1);
+  // Сумма по зарегистрированным играм сохраняется после удаления игры
+  metrics_t total;
+  ck_assert_int_eq(metricsAggregate(&total), 1);
+  ck_assert_uint_eq(total.clears[4], 1);
+  metricsUnregister(&engine.metrics);
+  ck_assert_int_eq(metricsAggregate(&total), 0);
+  ck_assert_uint_eq(total.clears[4], 1);
+  ck_assert_uint_eq(total.inputs, 4);
+  tetrisDestroy(&engine.game_info, &engine.addinfo);
+}
+END_TEST;
+
+/**
+ * @brief Экспорт метрик в текстовом формате Prometheus
+ */
+START_TEST(test_metrics_export) {
+  char filename[] = "metrics_test.prom";
+  engine_t engine = {.state = START};
+  tetrisCreate(&engine.game_info, &engine.addinfo);
+  metricsRegister(&engine.metrics);
+  engineInput(&engine, Start, false);
+  for (int i = 0; i < 2 * METRICS_SAMPLE_PERIOD; i++)
+    engineInput(&engine, Left, false);
+  ck_assert_int_eq(metricsWritePrometheus(filename), SUCCESSFUL_EXIT);
+  FILE *file = fopen(filename, "r");
+  ck_assert_ptr_ne(file, NULL);
+  char line[256], inputs_line[64];
+  // Старт игры и 2 * METRICS_SAMPLE_PERIOD сдвигов, замеры на 3 шагах
+  snprintf(inputs_line, sizeof(inputs_line), "tetris_inputs_total %d\n",
+           2 * METRICS_SAMPLE_PERIOD + 1);
+  int found_inputs = 0, found_latency = 0, found_clears = 0;
+  int found_dropped = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    if (strcmp(line, inputs_line) == 0) found_inputs = 1;
+    if (strcmp(line, "tetris_fsm_step_latency_seconds_count 3\n") == 0)
+      found_latency = 1;
+    if (strcmp(line, "tetris_line_clears_total{type=\"single\"} 0\n") == 0)
+      found_clears = 1;
+    if (strcmp(line, "tetris_metrics_dropped_engines_total 0\n") == 0)
+      found_dropped = 1;
+  }
+  fclose(file);
+  remove(filename);
+  ck_assert_int_eq(found_inputs, 1);
+  ck_assert_int_eq(found_latency, 1);
+  ck_assert_int_eq(found_clears, 1);
+  ck_assert_int_eq(found_dropped, 1);
+  // Ошибка записи в несуществующий каталог
+  ck_assert_int_eq(metricsWritePrometheus("no_such_dir/metrics.prom"),
+                   FAILURE_EXIT);
+  metricsUnregister(&engine.metrics);
+  tetrisDestroy(&engine.game_info, &engine.addinfo);
+}
+END_TEST;
+
+/**
+ * @brief Список игр растет без ограничения, удаление в любом порядке
+ * сохраняет суммы
+ */
+START_TEST(test_metrics_registry) {
+  enum { ENGINES = 5 * METRICS_REGISTRY_MIN + 3 };
+  metrics_t *metrics = (metrics_t *)calloc(ENGINES, sizeof(metrics_t));
+  metrics_t total;
+  int engines = metricsAggregate(&total);
+  unsigned long long inputs = total.inputs;
+  for (int i = 0; i < ENGINES; i++) {
+    metricsRegister(&metrics[i]);
+    metricsAdd(&metrics[i].inputs, 1);
+  }
+  ck_assert_int_eq(metricsAggregate(&total), engines + ENGINES);
+  ck_assert_uint_eq(total.inputs, inputs + ENGINES);
+  // Через одну, затем оставшиеся с конца
+  for (int i = 0; i < ENGINES; i += 2) metricsUnregister(&metrics[i]);
+  ck_assert_int_eq(metricsAggregate(&total), engines + ENGINES / 2);
+  for (int i = ENGINES - 1; i >= 0; i--) metricsUnregister(&metrics[i]);
+  ck_assert_int_eq(metricsAggregate(&total), engines);
+  ck_assert_uint_eq(total.inputs, inputs + ENGINES);
+  free(metrics);
+}
+END_TEST;
+
+Suite *test_metrics(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_metrics");
+  tc = tcase_create("metrics");
+  tcase_add_test(tc, test_metrics_counters);
+  tcase_add_test(tc, test_metrics_export);
+  tcase_add_test(tc, test_metrics_registry);
+  suite_add_tcase(s, tc);
+  return s;
+}
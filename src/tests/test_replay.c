@@ -0,0 +1,171 @@
+/**
+ * @file test_replay.c
+ * @brief Тест журнала ввода игр: запись, чтение через отображение в память,
+ * повтор с тем же результатом, пропуск недописанной записи
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../brick_game/tetris/s21_tetris_replay.h"
+#include "tests_main.h"
+
+/**
+ * @brief Временный файл журнала.
+ */
+static void replayTestPath(char *path, size_t size) {
+  snprintf(path, size, "/tmp/s21_tetris_replay_XXXXXX");
+  int fd = mkstemp(path);
+  ck_assert_int_ge(fd, 0);
+  close(fd);
+}
+
+/**
+ * @brief Игра с записью: клавиши, шаги времени и падения по псевдослучайной
+ * последовательности, как их передает userInput / userKey / userTick.
+ * Игра не длиннее steps событий.
+ */
+static void replayTestPlay(engine_t *engine, replay_recorder_t *recorder,
+                           unsigned int seed, int steps) {
+  engine->addinfo.seed = seed;
+  engineInput(engine, Start, false);
+  replayRecord(recorder, engine, REPLAY_INPUT, Start, false);
+  const UserAction_t keys[] = {Left, Right, Down};
+  const UserAction_t inputs[] = {Left, Right, Action, ActionCCW, Hold, Down};
+  for (int i = 0; i < steps && engine->state != GAMEOVER; i++) {
+    int r = rand_r(&seed) % 10;
+    if (r < 5) {
+      engineTick(engine, 1);
+      replayRecord(recorder, engine, REPLAY_TICK, Up, 1);
+    } else if (r < 7) {
+      UserAction_t key = keys[rand_r(&seed) % 3];
+      bool pressed = rand_r(&seed) % 2;
+      engineKey(engine, key, pressed);
+      replayRecord(recorder, engine, REPLAY_KEY, key, pressed);
+    } else {
+      UserAction_t action = inputs[rand_r(&seed) % 6];
+      bool hold = action == Down;
+      engineInput(engine, action, hold);
+      replayRecord(recorder, engine, REPLAY_INPUT, action, hold);
+    }
+  }
+}
+
+START_TEST(test_replay_same_game) {
+  char path[64];
+  replayTestPath(path, sizeof(path));
+  replay_recorder_t *recorder = replayRecorderOpen(path);
+  ck_assert_ptr_nonnull(recorder);
+  engine_t engine = {0}, copy = {0};
+  engineInput(&engine, Start, true);
+  replayTestPlay(&engine, recorder, 7, 100000);
+  ck_assert_int_eq(engine.state, GAMEOVER);
+  ck_assert_int_eq(replayRecorderClose(recorder), 0);
+
+  replay_log_t log;
+  ck_assert_int_eq(replayMap(path, &log), 0);
+  ck_assert_int_eq(log.games, 1);
+  ck_assert(!log.truncated);
+  const replay_event_t *events;
+  const replay_game_t *game = replayGame(&log, 0, &events);
+  ck_assert_uint_eq(game->seed, 7);
+  ck_assert_uint_eq(game->flags, REPLAY_FINISHED);
+
+  engineInput(&copy, Start, true);
+  replayStart(&copy, game);
+  for (unsigned int i = 0; i < game->count; i++) replayApply(&copy, &events[i]);
+  ck_assert_int_eq(copy.state, GAMEOVER);
+  ck_assert_int_eq(copy.game_info.score, engine.game_info.score);
+  ck_assert_int_eq(copy.lines, engine.lines);
+  ck_assert_uint_eq(copy.piece_count, engine.piece_count);
+  ck_assert_uint_eq(copy.game_info.hash, engine.game_info.hash);
+  ck_assert_uint_eq(copy.timing.ticks, engine.timing.ticks);
+  replayUnmap(&log);
+  engineInput(&engine, Terminate, true);
+  engineInput(&copy, Terminate, true);
+  unlink(path);
+}
+END_TEST
+
+START_TEST(test_replay_truncated) {
+  char path[64];
+  replayTestPath(path, sizeof(path));
+  replay_recorder_t *recorder = replayRecorderOpen(path);
+  ck_assert_ptr_nonnull(recorder);
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  replayTestPlay(&engine, recorder, 1, 100000);
+  // Вторая игра не закончена: записывается при закрытии журнала
+  engineInput(&engine, Start, false);
+  replayTestPlay(&engine, recorder, 2, 50);
+  ck_assert_int_ne(engine.state, GAMEOVER);
+  ck_assert_int_eq(replayRecorderClose(recorder), 0);
+  engineInput(&engine, Terminate, true);
+
+  replay_log_t log;
+  ck_assert_int_eq(replayMap(path, &log), 0);
+  ck_assert_int_eq(log.games, 2);
+  const replay_event_t *events;
+  ck_assert_uint_eq(replayGame(&log, 0, &events)->flags, REPLAY_FINISHED);
+  ck_assert_uint_eq(replayGame(&log, 1, &events)->flags, 0);
+  ck_assert_uint_eq(replayGame(&log, 1, &events)->seed, 2);
+  size_t size = log.size;
+  replayUnmap(&log);
+
+  // Недописанная запись в конце (падение процесса) пропускается
+  ck_assert_int_eq(truncate(path, size - 3), 0);
+  ck_assert_int_eq(replayMap(path, &log), 0);
+  ck_assert_int_eq(log.games, 1);
+  ck_assert(log.truncated);
+  replayUnmap(&log);
+  ck_assert_int_eq(replayMap("/nonexistent/replay.log", &log), 1);
+  unlink(path);
+}
+END_TEST
+
+START_TEST(test_replay_api) {
+  char path[64];
+  replayTestPath(path, sizeof(path));
+  replay_recorder_t *recorder = replayRecorderOpen(path);
+  ck_assert_ptr_nonnull(recorder);
+  userInput(Start, true);
+  const engine_t *engine = fsmGuiEngine();
+  while (engine->state != START) userInput(Terminate, false);
+  userRecord(recorder);
+  userInput(Start, false);
+  for (int i = 0; i < 10; i++) userTick();
+  userKey(Left, true);
+  userKey(Left, false);
+  while (engine->state != GAMEOVER) userInput(Down, true);
+  userRecord(NULL);
+  ck_assert_int_eq(replayRecorderClose(recorder), 0);
+
+  replay_log_t log;
+  ck_assert_int_eq(replayMap(path, &log), 0);
+  ck_assert_int_eq(log.games, 1);
+  const replay_event_t *events;
+  const replay_game_t *game = replayGame(&log, 0, &events);
+  ck_assert_uint_eq(game->seed, engine->game_seed);
+  // Шаги времени подряд записываются одним событием
+  ck_assert_int_eq(events[0].kind, REPLAY_TICK);
+  ck_assert_int_eq(events[0].value, 10);
+  ck_assert_int_eq(events[1].kind, REPLAY_KEY);
+  ck_assert_int_eq(events[1].action, Left);
+  replayUnmap(&log);
+  unlink(path);
+}
+END_TEST
+
+Suite *test_replay(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_replay");
+  tc = tcase_create("replay");
+  tcase_add_test(tc, test_replay_same_game);
+  tcase_add_test(tc, test_replay_truncated);
+  tcase_add_test(tc, test_replay_api);
+  suite_add_tcase(s, tc);
+  return s;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file test_snapshot.c
+ * @brief Тест снимков поля: совпадение с полем и хешем игры, размещение без
+ * изменения исходного снимка, общие строки, удаление строк, перебор
+ * размещений из общего снимка в нескольких потоках
+ */
+
+#include <pthread.h>
+
+#include "../brick_game/tetris/s21_tetris_snapshot.h"
+#include "tests_main.h"
+
+// Потоков перебора и глубина перебора (фигур)
+#define SNAPSHOT_THREADS 4
+#define SNAPSHOT_DEPTH 2
+
+/**
+ * @brief Клетки снимка совпадают с полем.
+ */
+static void snapshotCheckField(const snapshot_t *snapshot, cell_t **field) {
+  for (int i = 0; i < FIELD_ROWS; i++)
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      ck_assert_int_eq(snapshotCell(snapshot, i, j), field[i][j]);
+  ck_assert_uint_eq(snapshot->hash, fieldHash(field));
+}
+
+/**
+ * @brief Неровное поле с дырами, нижняя строка без первых 4 клеток.
+ */
+static void snapshotFillField(cell_t **field) {
+  emptyField(field);
+  for (int j = 4; j < FIELD_COLUMNS; j++) field[FIELD_ROWS - 1][j] = 3;
+  for (int j = 5; j < FIELD_COLUMNS; j += 2) field[FIELD_ROWS - 2][j] = 5;
+  field[FIELD_ROWS - 3][7] = 2;
+  field[FIELD_ROWS - 6][9] = 6;
+}
+
+START_TEST(test_snapshot_field) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  snapshotFillField(field);
+  snapshot_t *snapshot = snapshotFromField(field);
+  ck_assert_ptr_nonnull(snapshot);
+  snapshotCheckField(snapshot, field);
+  // Пустые строки - одна общая строка
+  ck_assert_ptr_eq(snapshot->rows[0], snapshot->rows[1]);
+  ck_assert_ptr_ne(snapshot->rows[FIELD_ROWS - 1],
+                   snapshot->rows[FIELD_ROWS - 2]);
+  snapshotRelease(snapshot);
+  freeMatrix(field);
+}
+END_TEST;
+
+/**
+ * @brief Размещение: исходный снимок не меняется, новыми создаются только
+ * строки фигуры, строки живут, пока на них есть ссылки.
+ */
+START_TEST(test_snapshot_place) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  snapshotFillField(field);
+  snapshot_t *parent = snapshotFromField(field);
+  // T (id 6) вертикально у правой стены
+  int mask = pieceMask(6, 1);
+  int row = snapshotDropRow(parent, mask, 0, 7), piece_rows = 0;
+  ck_assert_int_ge(row, 0);
+  ck_assert(!snapshotFits(parent, mask, row + 1, 7));
+  for (int i = 0; i < PIECE_ROWS; i++)
+    piece_rows += ((mask >> (i * PIECE_COLUMNS)) & 0xF) != 0;
+  ck_assert(!snapshotFits(parent, mask, 0, FIELD_COLUMNS));
+  ck_assert_int_eq(snapshotDropRow(parent, mask, 0, FIELD_COLUMNS), -1);
+  snapshot_t *child = snapshotPlace(parent, 6, 1, row, 7);
+  ck_assert_ptr_nonnull(child);
+  ck_assert_int_eq(child->lines, 0);
+  ck_assert_int_eq(snapshotShared(parent, child), FIELD_ROWS - piece_rows);
+  snapshotCheckField(parent, field);
+  snapshotRelease(parent);
+  for (int i = 0; i < PIECE_ROWS; i++)
+    for (int j = 0; j < PIECE_COLUMNS; j++)
+      if ((mask >> (i * PIECE_COLUMNS + j)) & 1) field[row + i][7 + j] = 7;
+  snapshotCheckField(child, field);
+  snapshotRelease(child);
+  freeMatrix(field);
+}
+END_TEST;
+
+/**
+ * @brief Удаление строки: строки выше сдвигаются указателями, хеш
+ * пересчитывается.
+ */
+START_TEST(test_snapshot_lines) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  snapshotFillField(field);
+  snapshot_t *parent = snapshotFromField(field);
+  // I (id 1) горизонтально в нижнюю строку
+  int row = snapshotDropRow(parent, pieceMask(1, 0), 0, 0);
+  ck_assert_int_eq(row, FIELD_ROWS - 1);
+  snapshot_t *child = snapshotPlace(parent, 1, 0, row, 0);
+  ck_assert_int_eq(child->lines, 1);
+  for (int i = 1; i < FIELD_ROWS; i++)
+    ck_assert_ptr_eq(child->rows[i], parent->rows[i - 1]);
+  shiftField(field, FIELD_ROWS - 1);
+  snapshotCheckField(child, field);
+  snapshotRelease(parent);
+  snapshotRelease(child);
+  freeMatrix(field);
+}
+END_TEST;
+
+/**
+ * @brief Снимок игры - поле без текущей фигуры.
+ */
+START_TEST(test_snapshot_engine) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engineInput(&engine, Start, false);
+  engineInput(&engine, Down, true);
+  engineInput(&engine, Left, false);
+  ck_assert_int_eq(engine.state, MOVING);
+  snapshot_t *snapshot = snapshotFromEngine(&engine);
+  removePieceFromField(&engine.game_info, &engine.addinfo);
+  snapshotCheckField(snapshot, engine.game_info.field);
+  placePieceOnField(&engine.game_info, &engine.addinfo);
+  snapshotRelease(snapshot);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/// @brief Перебор размещений в потоке
+typedef struct {
+  snapshot_t *root;
+  /// Первая фигура ветви
+  int id;
+  /// Результат: размещений, удаленных строк и сумма хешей
+  long long nodes;
+  long long lines;
+  unsigned long long hash_sum;
+} snapshot_search_t;
+
+/**
+ * @brief Все размещения фигуры id и дальше (до depth фигур) - O, I, ...
+ */
+static void snapshotSearch(snapshot_search_t *search, snapshot_t *snapshot,
+                           int id, int depth) {
+  for (int rot_id = 0; rot_id < 4; rot_id++) {
+    int mask = pieceMask(id, rot_id);
+    for (int col = -PIECE_COLUMNS + 1; col < FIELD_COLUMNS; col++) {
+      int row = snapshotDropRow(snapshot, mask, 0, col);
+      if (row < 0) continue;
+      snapshot_t *child = snapshotPlace(snapshot, id, rot_id, row, col);
+      ck_assert_ptr_nonnull(child);
+      search->nodes++;
+      search->lines += child->lines;
+      search->hash_sum += child->hash;
+      if (depth > 1) snapshotSearch(search, child, (id + 1) % 7, depth - 1);
+      snapshotRelease(child);
+    }
+  }
+}
+
+static void *snapshotThread(void *arg) {
+  snapshot_search_t *search = arg;
+  snapshotSearch(search, search->root, search->id, SNAPSHOT_DEPTH);
+  snapshotRelease(search->root);
+  return NULL;
+}
+
+/**
+ * @brief Ветви одного снимка в нескольких потоках дают тот же результат,
+ * что и последовательно, исходный снимок не меняется.
+ */
+START_TEST(test_snapshot_threads) {
+  cell_t **field = createMatrix(FIELD_ROWS, FIELD_COLUMNS);
+  snapshotFillField(field);
+  snapshot_t *root = snapshotFromField(field);
+  snapshot_search_t expected[SNAPSHOT_THREADS] = {0};
+  snapshot_search_t parallel[SNAPSHOT_THREADS] = {0};
+  pthread_t threads[SNAPSHOT_THREADS];
+  for (int i = 0; i < SNAPSHOT_THREADS; i++) {
+    expected[i].id = i;
+    snapshotSearch(&expected[i], root, i, SNAPSHOT_DEPTH);
+    parallel[i].id = i;
+    parallel[i].root = snapshotRetain(root);
+    ck_assert_int_eq(pthread_create(&threads[i], NULL, snapshotThread,
+                                    &parallel[i]),
+                     0);
+  }
+  for (int i = 0; i < SNAPSHOT_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    ck_assert_int_gt(parallel[i].nodes, 0);
+    ck_assert_int_eq(parallel[i].nodes, expected[i].nodes);
+    ck_assert_int_eq(parallel[i].lines, expected[i].lines);
+    ck_assert_uint_eq(parallel[i].hash_sum, expected[i].hash_sum);
+  }
+  ck_assert_int_eq(atomic_load(&root->refs), 1);
+  ck_assert_int_eq(atomic_load(&root->rows[FIELD_ROWS - 1]->refs), 1);
+  snapshotCheckField(root, field);
+  snapshotRelease(root);
+  freeMatrix(field);
+}
+END_TEST;
+
+Suite *test_snapshot(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_snapshot");
+  tc = tcase_create("snapshot");
+  tcase_add_test(tc, test_snapshot_field);
+  tcase_add_test(tc, test_snapshot_place);
+  tcase_add_test(tc, test_snapshot_lines);
+  tcase_add_test(tc, test_snapshot_engine);
+  tcase_add_test(tc, test_snapshot_threads);
+  suite_add_tcase(s, tc);
+  return s;
+}
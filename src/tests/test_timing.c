@@ -0,0 +1,247 @@
+/**
+ * @file test_timing.c
+ * @brief Тест управления по времени: автоповтор сдвига, мягкое падение,
+ * гравитация, задержка фиксации
+ */
+
+#include "../brick_game/tetris/s21_tetris_timing.h"
+#include "tests_main.h"
+
+/**
+ * @brief Новая игра с известным seed и настройками по умолчанию.
+ */
+static void timingStart(engine_t *engine) {
+  engineInput(engine, Start, true);
+  engine->addinfo.seed = 3;
+  engine->game_info.high_score = 0;
+  engineInput(engine, Start, false);
+}
+
+/**
+ * @brief Сдвиг сразу при нажатии, повтор после DAS с периодом ARR, без
+ * повторов после отпускания
+ */
+START_TEST(test_timing_das) {
+  engine_t engine = {.state = START};
+  timingStart(&engine);
+  // Без гравитации
+  engine.game_info.speed = 1000000;
+  int col = engine.addinfo.col_pos;
+  engineKey(&engine, Right, true);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 1);
+  engineTick(&engine, TIMING_DAS - 1);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 1);
+  engineTick(&engine, 1);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 2);
+  engineTick(&engine, TIMING_ARR);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 3);
+  engineKey(&engine, Right, false);
+  engineTick(&engine, TIMING_DAS * 2);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 3);
+  // Из двух нажатых направлений действует последнее, после его отпускания
+  // - снова первое с новой задержкой
+  engineKey(&engine, Right, true);
+  engineKey(&engine, Left, true);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 3);
+  engineKey(&engine, Left, false);
+  engineTick(&engine, TIMING_DAS);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 4);
+  // ARR 0 - сразу до стены
+  engine.timing.config.arr = 0;
+  engineTick(&engine, 1);
+  int mask = pieceMask(engine.addinfo.piece_id, engine.addinfo.piece_rot_id);
+  int right = 0;
+  for (int i = 0; i < PIECE_ROWS * PIECE_COLUMNS; i++)
+    if ((mask >> i) & 1 && i % PIECE_COLUMNS > right) right = i % PIECE_COLUMNS;
+  ck_assert_int_eq(engine.addinfo.col_pos + right, FIELD_COLUMNS - 1);
+  ck_assert(engine.game_info.hash == fieldHash(engine.game_info.field));
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Гравитация по скорости игры, мягкое падение при удержании Down
+ */
+START_TEST(test_timing_soft_drop) {
+  engine_t engine = {.state = START};
+  timingStart(&engine);
+  // Строка за 0.84 с: 50 шагов - без падения, 51 - на строку ниже
+  int row = engine.addinfo.row_pos;
+  engineTick(&engine, 50);
+  ck_assert_int_eq(engine.addinfo.row_pos, row);
+  engineTick(&engine, 1);
+  ck_assert_int_eq(engine.addinfo.row_pos, row + 1);
+  engineKey(&engine, Down, true);
+  ck_assert_int_eq(engine.addinfo.row_pos, row + 2);
+  engineTick(&engine, TIMING_SOFT_DROP * 3);
+  ck_assert_int_eq(engine.addinfo.row_pos, row + 5);
+  engineKey(&engine, Down, false);
+  engineTick(&engine, TIMING_SOFT_DROP * 3);
+  ck_assert_int_eq(engine.addinfo.row_pos, row + 5);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Фигура на опоре фиксируется после задержки; сдвиги на опоре
+ * сбрасывают задержку не больше lock_resets раз
+ */
+START_TEST(test_timing_lock_delay) {
+  engine_t engine = {.state = START};
+  timingStart(&engine);
+  engine.game_info.speed = 1000000;
+  unsigned int pieces = engine.piece_count;
+  // Мягкое падение до опоры: фигура не фиксируется
+  engineKey(&engine, Down, true);
+  while (engine.timing.lock_timer == 0) engineTick(&engine, 1);
+  engineKey(&engine, Down, false);
+  ck_assert_uint_eq(engine.piece_count, pieces);
+  ck_assert_int_gt(engine.addinfo.row_pos, FIELD_ROWS - PIECE_ROWS - 1);
+  // Сдвиги туда и обратно сбрасывают задержку
+  for (int i = 0; i < TIMING_LOCK_RESETS; i++) {
+    engineKey(&engine, i % 2 ? Right : Left, true);
+    engineKey(&engine, i % 2 ? Right : Left, false);
+    engineTick(&engine, TIMING_LOCK_DELAY);
+    ck_assert_uint_eq(engine.piece_count, pieces);
+  }
+  ck_assert_int_eq(engine.timing.lock_resets, TIMING_LOCK_RESETS);
+  // Сбросы исчерпаны - сдвиг не продлевает задержку
+  engineKey(&engine, Left, true);
+  engineKey(&engine, Left, false);
+  engineTick(&engine, 1);
+  ck_assert_uint_eq(engine.piece_count, pieces + 1);
+  ck_assert_int_eq(engine.state, MOVING);
+  // Новая фигура - новая задержка и все сбросы
+  ck_assert_int_eq(engine.timing.lock_resets, 0);
+  ck_assert_int_eq(engine.timing.lock_timer, 0);
+  ck_assert(engine.game_info.hash == fieldHash(engine.game_info.field));
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Сдвиг и вращение через userInput (ACT_SIG) на опоре сбрасывают
+ * задержку фиксации так же, как клавиши с автоповтором, и тратят те же
+ * сбросы
+ */
+START_TEST(test_timing_lock_input) {
+  engine_t engine = {.state = START};
+  timingStart(&engine);
+  engine.game_info.speed = 1000000;
+  unsigned int pieces = engine.piece_count;
+  engineKey(&engine, Down, true);
+  while (engine.timing.lock_timer == 0) engineTick(&engine, 1);
+  engineKey(&engine, Down, false);
+  engineTick(&engine, TIMING_LOCK_DELAY - 5);
+  int rot_id = engine.addinfo.piece_rot_id;
+  engineInput(&engine, Action, false);
+  ck_assert_int_ne(engine.addinfo.piece_rot_id, rot_id);
+  ck_assert_int_eq(engine.timing.lock_timer, 0);
+  ck_assert_int_eq(engine.timing.lock_resets, 1);
+  // После вращения фигура может снова падать: до опоры
+  engineKey(&engine, Down, true);
+  while (engine.timing.lock_timer == 0) engineTick(&engine, 1);
+  engineKey(&engine, Down, false);
+  engineTick(&engine, TIMING_LOCK_DELAY - 5);
+  int col = engine.addinfo.col_pos, resets = engine.timing.lock_resets;
+  engineInput(&engine, Left, false);
+  ck_assert_int_eq(engine.addinfo.col_pos, col - 1);
+  ck_assert_int_eq(engine.timing.lock_timer, 0);
+  ck_assert_int_eq(engine.timing.lock_resets, resets + 1);
+  engineTick(&engine, TIMING_LOCK_DELAY - 5);
+  ck_assert_uint_eq(engine.piece_count, pieces);
+  // Сбросы исчерпаны - сдвиг через userInput задержку не продлевает
+  engine.timing.lock_resets = TIMING_LOCK_RESETS;
+  engineInput(&engine, Right, false);
+  ck_assert_int_eq(engine.addinfo.col_pos, col);
+  engineTick(&engine, 6);
+  ck_assert_uint_eq(engine.piece_count, pieces + 1);
+  ck_assert_int_eq(engine.timing.lock_timer, 0);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Шаги времени вне MOVING только считаются, шаги и клавиши до
+ * создания массивов игнорируются
+ */
+START_TEST(test_timing_states) {
+  engine_t engine = {.state = START};
+  engineTick(&engine, 5);
+  engineKey(&engine, Right, true);
+  ck_assert(engine.timing.ticks == 0);
+  ck_assert_uint_eq(engine.timing.held, 0);
+  timingStart(&engine);
+  engineInput(&engine, Pause, false);
+  int row = engine.addinfo.row_pos;
+  engineKey(&engine, Down, true);
+  engineTick(&engine, 200);
+  ck_assert_int_eq(engine.state, PAUSE);
+  ck_assert_int_eq(engine.addinfo.row_pos, row);
+  ck_assert(engine.timing.ticks == 200);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Опрос клавиатуры игровым циклом в момент now_ms: нажатие клавиши
+ * вправо (или повтор терминала), затем шаги времени игры.
+ */
+static void timingPoll(held_key_t *held, bool pressed, long long now_ms,
+                       long long *tick) {
+  long long now = now_ms * 1000000;
+  UserAction_t action = userHeldKey(held, pressed ? Right : Up, pressed, now);
+  if (action != Up) userInput(action, false);
+  for (; now - *tick >= TIMING_TICK_NS; *tick += TIMING_TICK_NS) userTick();
+}
+
+/**
+ * @brief Клавиша терминала: короткое нажатие - один сдвиг, удержание с
+ * первым повтором через 500 мс (затем раз в 25 мс) не прерывается
+ * отпусканием до конца повторов
+ */
+START_TEST(test_timing_held_key) {
+  engine_t engine = {.state = START};
+  fsmGuiUse(&engine);
+  userInput(Start, true);
+  fsmGuiSeed(3);
+  userInput(Start, false);
+  engine.game_info.speed = 1000000;
+  int col = engine.addinfo.col_pos;
+  held_key_t held = {Up, 0, false};
+  long long tick = 0;
+  for (long long ms = 0; ms < 1000; ms++) timingPoll(&held, ms == 0, ms, &tick);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 1);
+  ck_assert_uint_eq(engine.timing.held, 0);
+  // Удержание: нажатие в 1000 мс, повторы терминала с 1500 до 2000 мс
+  for (long long ms = 1000; ms < 1500; ms++)
+    timingPoll(&held, ms == 1000, ms, &tick);
+  ck_assert_int_eq(engine.addinfo.col_pos, col + 2);
+  ck_assert_uint_eq(engine.timing.held, 0);
+  for (long long ms = 1500; ms < 2500; ms++) {
+    timingPoll(&held, ms <= 2000 && (ms - 1500) % 25 == 0, ms, &tick);
+    if (ms < 2000 + KEY_RELEASE_NS / 1000000)
+      ck_assert_uint_eq(engine.timing.held, 1u << Right);
+  }
+  ck_assert_int_gt(engine.addinfo.col_pos, col + 3);
+  ck_assert_uint_eq(engine.timing.held, 0);
+  ck_assert_int_eq(held.action, Up);
+  userInput(Terminate, true);
+  fsmGuiUse(NULL);
+}
+END_TEST;
+
+Suite *test_timing(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_timing");
+  tc = tcase_create("timing");
+  tcase_add_test(tc, test_timing_das);
+  tcase_add_test(tc, test_timing_soft_drop);
+  tcase_add_test(tc, test_timing_lock_delay);
+  tcase_add_test(tc, test_timing_lock_input);
+  tcase_add_test(tc, test_timing_states);
+  tcase_add_test(tc, test_timing_held_key);
+  suite_add_tcase(s, tc);
+  return s;
+}
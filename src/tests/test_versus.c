@@ -0,0 +1,146 @@
+/**
+ * @file test_versus.c
+ * @brief Тест режима versus: атака мусором, гашение, координатор
+ */
+
+#include "../brick_game/tetris/s21_tetris_versus.h"
+#include "tests_main.h"
+
+/**
+ * @brief Замена текущей фигуры игры на заданную.
+ */
+static void setPiece(engine_t *engine, int id, int rot_id, int col) {
+  removePieceFromField(&engine->game_info, &engine->addinfo);
+  engine->addinfo.piece_id = id;
+  engine->addinfo.piece_rot_id = rot_id;
+  getPiece(engine->addinfo.piece, id, rot_id);
+  engine->addinfo.row_pos = 0;
+  engine->addinfo.col_pos = col;
+  placePieceOnField(&engine->game_info, &engine->addinfo);
+}
+
+/**
+ * @brief Tetris отправляет сопернику 4 строки, из них одна гасит входящий
+ * мусор; мусор поднимается после закрепления фигуры соперником
+ */
+START_TEST(test_versus_attack) {
+  static versus_match_t match;
+  versus_config_t config;
+  versusDefaultConfig(&config);
+  config.gravity_ticks = 0;
+  ck_assert_int_eq(versusCreate(&match, &config, 1, 1), FAILURE_EXIT);
+  ck_assert_int_eq(versusCreate(&match, &config, 2, 11), SUCCESSFUL_EXIT);
+  engine_t *engine = &match.players[0].engine;
+  // Нижние 4 строки заполнены, кроме столбца 0; вертикальная палка над ним
+  removePieceFromField(&engine->game_info, &engine->addinfo);
+  for (int i = FIELD_ROWS - 4; i < FIELD_ROWS; i++)
+    for (int j = 1; j < FIELD_COLUMNS; j++) engine->game_info.field[i][j] = 3;
+  engine->game_info.hash = fieldHash(engine->game_info.field);
+  placePieceOnField(&engine->game_info, &engine->addinfo);
+  setPiece(engine, 1, 1, -2);
+  // Входящий мусор игрока 0 гасится первым
+  engine->garbage[0] = 5;
+  engine->garbage_count = 1;
+  ck_assert_int_eq(versusInput(&match, 0, Down, true), SUCCESSFUL_EXIT);
+  versusStep(&match);
+  ck_assert_int_eq(engine->last_clear, 4);
+  ck_assert_int_eq(engine->garbage_count, 0);
+  ck_assert_int_eq(match.players[0].sent, 3);
+  engine_t *opponent = &match.players[1].engine;
+  ck_assert_int_eq(opponent->garbage_count, 3);
+  ck_assert_int_eq(match.players[1].received, 3);
+  // Соперник бросает фигуру без удаления строк - мусор поднимается
+  versusInput(&match, 1, Down, true);
+  versusStep(&match);
+  ck_assert_int_eq(opponent->garbage_count, 0);
+  for (int i = FIELD_ROWS - 3; i < FIELD_ROWS; i++) {
+    int garbage = 0;
+    for (int j = 0; j < FIELD_COLUMNS; j++)
+      garbage += opponent->game_info.field[i][j] == GARBAGE_CELL;
+    ck_assert_int_eq(garbage, FIELD_COLUMNS - 1);
+  }
+  ck_assert(opponent->game_info.hash == fieldHash(opponent->game_info.field));
+  ck_assert_int_eq(match.alive, 2);
+  ck_assert_int_eq(versusWinner(&match), -1);
+  // Сдача игрока 1 заканчивает матч
+  versusInput(&match, 1, Terminate, true);
+  versusStep(&match);
+  ck_assert_int_eq(match.alive, 1);
+  ck_assert_int_eq(versusWinner(&match), 0);
+  unsigned long long ticks = match.ticks;
+  versusStep(&match);
+  ck_assert(match.ticks == ticks);
+  versusDestroy(&match);
+}
+END_TEST;
+
+/**
+ * @brief Подъем мусора до верха поля заканчивает игру
+ */
+START_TEST(test_versus_topout) {
+  engine_t engine = {.state = START};
+  engineInput(&engine, Start, true);
+  engineInput(&engine, Start, false);
+  for (int i = 0; i < FIELD_ROWS; i++) engine.garbage[i] = i % FIELD_COLUMNS;
+  engine.garbage_count = FIELD_ROWS;
+  engineInput(&engine, Down, true);
+  ck_assert_int_eq(engine.state, GAMEOVER);
+  ck_assert_int_eq(engine.game_info.pause, GAMEOVER_MODE);
+  ck_assert_int_eq(engine.garbage_count, 0);
+  engineInput(&engine, Terminate, true);
+}
+END_TEST;
+
+/**
+ * @brief Координатор в своем потоке доводит до конца матчи с одинаковыми
+ * seed одинаково (шаги игр одновременны, результат не зависит от потока)
+ */
+START_TEST(test_versus_coordinator) {
+  enum { MATCHES = 64 };
+  static versus_match_t matches[MATCHES];
+  versus_config_t config;
+  versusDefaultConfig(&config);
+  config.gravity_ticks = 1;
+  versus_coordinator_t coordinator;
+  ck_assert_int_eq(coordinatorStart(&coordinator, 0), SUCCESSFUL_EXIT);
+  for (int i = 0; i < MATCHES; i++) {
+    ck_assert_int_eq(versusCreate(&matches[i], &config, 2 + i % 3, 9),
+                     SUCCESSFUL_EXIT);
+    coordinatorAdd(&coordinator, &matches[i]);
+    ck_assert_int_eq(versusWinner(&matches[i]), -1);
+  }
+  // Без ввода фигуры падают в одно место, все игроки проигрывают на одном
+  // шаге - ничья
+  bool finished = false;
+  while (!finished) {
+    finished = true;
+    pthread_mutex_lock(&coordinator.lock);
+    for (int i = 0; i < MATCHES; i++) finished &= matches[i].alive < 2;
+    pthread_mutex_unlock(&coordinator.lock);
+  }
+  for (int i = 0; i < MATCHES; i++)
+    coordinatorRemove(&coordinator, &matches[i]);
+  ck_assert_ptr_null(coordinator.matches);
+  ck_assert_int_gt(atomic_load(&coordinator.ticks), 0);
+  coordinatorStop(&coordinator);
+  for (int i = 0; i < MATCHES; i++) {
+    ck_assert_int_eq(versusWinner(&matches[i]), -1);
+    ck_assert(matches[i].ticks == matches[0].ticks);
+    ck_assert(matches[i].players[0].engine.game_info.hash ==
+              matches[0].players[0].engine.game_info.hash);
+  }
+  for (int i = 0; i < MATCHES; i++) versusDestroy(&matches[i]);
+}
+END_TEST;
+
+Suite *test_versus(void) {
+  Suite *s;
+  TCase *tc;
+  s = suite_create("test_versus");
+  tc = tcase_create("versus");
+  tcase_add_test(tc, test_versus_attack);
+  tcase_add_test(tc, test_versus_topout);
+  tcase_add_test(tc, test_versus_coordinator);
+  suite_add_tcase(s, tc);
+  return s;
+}
@@ -11,6 +11,17 @@ int main() {
   srunner_add_suite(sr, test_frontend_mode());
   srunner_add_suite(sr, test_fsm_mode());
   srunner_add_suite(sr, test_backend_utils());
+  srunner_add_suite(sr, test_lib());
+  srunner_add_suite(sr, test_metrics());
+  srunner_add_suite(sr, test_bot());
+  srunner_add_suite(sr, test_versus());
+  srunner_add_suite(sr, test_timing());
+  srunner_add_suite(sr, test_leaderboard());
+  srunner_add_suite(sr, test_board());
+  srunner_add_suite(sr, test_replay());
+  srunner_add_suite(sr, test_adaptive());
+  srunner_add_suite(sr, test_snapshot());
+  srunner_add_suite(sr, test_hint());
   srunner_run_all(sr, CK_NORMAL);
   number_failed = srunner_ntests_failed(sr);
   srunner_free(sr);
@@ -21,7 +32,8 @@ int main() {
  * @brief Функция сравнения двух матриц одинакового размера
  * @return 0 - если матрицы равны, 1 - если не равны
  */
-int compareMatrix(int rows, int cols, int **matrix_1, int **matrix_2) {
+int compareMatrix(int rows, int cols, cell_t **matrix_1,
+                  cell_t **matrix_2) {
   int res = SUCCESSFUL_EXIT;
   for (int i = 0; i < rows && !res; i++)
     for (int j = 0; j < cols && !res; j++)
@@ -32,7 +44,7 @@ int compareMatrix(int rows, int cols, int **matrix_1, int **matrix_2) {
 /**
  * @brief Заполняет все поле нулями
  */
-void emptyField(int **field) {
+void emptyField(cell_t **field) {
   for (int i = 0; i < FIELD_ROWS; i++)
     for (int j = 0; j < FIELD_COLUMNS; j++) field[i][j] = 0;
 }
\ No newline at end of file
@@ -3,17 +3,30 @@
 
 #include <check.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "../brick_game/tetris/s21_api.h"
 #include "../brick_game/tetris/s21_tetris_fsm.h"
 #include "../gui/cli/s21_define.h"
 
-int compareMatrix(int rows, int cols, int **matrix_1, int **matrix_2);
-void emptyField(int **field);
+int compareMatrix(int rows, int cols, cell_t **matrix_1,
+                  cell_t **matrix_2);
+void emptyField(cell_t **field);
 
 Suite *test_init(void);
 Suite *test_frontend_mode(void);
 Suite *test_fsm_mode(void);
 Suite *test_backend_utils(void);
+Suite *test_lib(void);
+Suite *test_metrics(void);
+Suite *test_bot(void);
+Suite *test_versus(void);
+Suite *test_timing(void);
+Suite *test_leaderboard(void);
+Suite *test_board(void);
+Suite *test_replay(void);
+Suite *test_adaptive(void);
+Suite *test_snapshot(void);
+Suite *test_hint(void);
 
 #endif  // TESTS_MAIN_H
@@ -0,0 +1,475 @@
+/**
+ * @file s21_analyze.c
+ * @brief Офлайн-анализ записанных игр (журналы --record).
+ *
+ * Журналы отображаются в память (replayMap), игры повторяются на игре без
+ * интерфейса (replayStart, replayApply) в нескольких потоках: каждый поток
+ * берет из общей очереди блоки по ANALYZE_CHUNK игр и копит свою статистику,
+ * в конце статистика потоков складывается. Результат - таблицы CSV по
+ * столбцам в каталоге --out:
+ * levels.csv - по уровням: игры, смерти, фигуры, строки (и по 1-4 за раз),
+ * время на уровне, строк в минуту, время до первого действия с новой
+ * фигурой (среднее, медиана, 90-й процентиль) и время на фигуру;
+ * deaths.csv - смерти по уровню и фигуре, которая не поместилась;
+ * summary.csv - итог по всем играм.
+ *
+ * Запуск: tetris_analyze [--threads N] [--out DIR] LOG...
+ * Синтетический журнал (бот с ошибками, время по шагам игры) для проверки
+ * скорости: tetris_analyze --generate N [--seed S] FILE.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../brick_game/tetris/s21_tetris_bot.h"
+#include "../brick_game/tetris/s21_tetris_fsm.h"
+#include "../brick_game/tetris/s21_tetris_replay.h"
+#include "../brick_game/tetris/s21_tetris_timing.h"
+
+// Уровни 1..10 (индекс - номер уровня)
+#define ANALYZE_LEVELS 11
+// Игр в блоке, который поток берет из очереди
+#define ANALYZE_CHUNK 64
+// Гистограмма времени до первого действия: шаг, мс, и количество корзин
+#define ANALYZE_HIST_MS 10
+#define ANALYZE_HIST_BUCKETS 1000
+// Максимум потоков
+#define ANALYZE_THREADS_MAX 256
+// Синтетические игры: время бота на фигуру, нс, доля фигур без бота
+// (1 / GENERATE_MISTAKE), пауза перед фигурой и между действиями в шагах
+// времени, максимум фигур в игре
+#define GENERATE_BOT_BUDGET 20000LL
+#define GENERATE_MISTAKE 5
+#define GENERATE_WAIT 60
+#define GENERATE_MOVE_TICKS 3
+#define GENERATE_PIECES 2000
+
+/// @brief Статистика одного уровня
+typedef struct {
+  long long games;
+  long long deaths;
+  long long pieces;
+  long long lines;
+  /// Удалений 1, 2, 3 и 4 строк за раз
+  long long clears[4];
+  long long time_ms;
+  /// Время до первого действия с фигурой: сумма, количество, гистограмма
+  long long hesitation_ms;
+  long long hesitations;
+  long long hesitation_hist[ANALYZE_HIST_BUCKETS];
+  /// Время от появления фигуры до появления следующей
+  long long placement_ms;
+} level_stats_t;
+
+/// @brief Статистика потока (и итоговая)
+typedef struct {
+  long long games;
+  long long finished;
+  /// Из них закончены выходом (Terminate)
+  long long quits;
+  /// Игра из журнала закончилась не так, как записана (другие правила)
+  long long diverged;
+  long long events;
+  long long score;
+  long long lines;
+  long long time_ms;
+  level_stats_t levels[ANALYZE_LEVELS];
+  long long deaths[ANALYZE_LEVELS][7];
+} analyze_stats_t;
+
+/// @brief Общая очередь игр всех журналов
+typedef struct {
+  replay_log_t *logs;
+  int count;
+  int log;
+  long long game;
+  pthread_mutex_t mutex;
+} analyze_queue_t;
+
+/// @brief Задание потока
+typedef struct {
+  analyze_queue_t *queue;
+  analyze_stats_t *stats;
+} analyze_worker_t;
+
+/**
+ * @brief Следующий блок игр из очереди.
+ * @return Журнал блока или NULL, если игры кончились.
+ */
+static replay_log_t *analyzeTake(analyze_queue_t *queue, long long *begin,
+                                 long long *end) {
+  replay_log_t *res = NULL;
+  pthread_mutex_lock(&queue->mutex);
+  while (queue->log < queue->count &&
+         queue->game >= queue->logs[queue->log].games) {
+    queue->log++;
+    queue->game = 0;
+  }
+  if (queue->log < queue->count) {
+    res = &queue->logs[queue->log];
+    *begin = queue->game;
+    *end = *begin + ANALYZE_CHUNK < res->games ? *begin + ANALYZE_CHUNK
+                                                : res->games;
+    queue->game = *end;
+  }
+  pthread_mutex_unlock(&queue->mutex);
+  return res;
+}
+
+/**
+ * @brief Время до первого действия с фигурой.
+ */
+static void analyzeHesitation(level_stats_t *level, unsigned int ms) {
+  int bucket = ms / ANALYZE_HIST_MS;
+  if (bucket >= ANALYZE_HIST_BUCKETS) bucket = ANALYZE_HIST_BUCKETS - 1;
+  level->hesitation_hist[bucket]++;
+  level->hesitation_ms += ms;
+  level->hesitations++;
+}
+
+/**
+ * @brief Повтор одной игры с накоплением статистики.
+ *
+ * Фигура считается появившейся при изменении engine_t.piece_count, первое
+ * действие с ней - первое событие, кроме шагов времени и отпускания
+ * клавиш. Строки и фигуры относятся к уровню, на котором они получены.
+ */
+static void analyzeGame(engine_t *engine, const replay_game_t *game,
+                        const replay_event_t *events, analyze_stats_t *stats) {
+  replayStart(engine, game);
+  unsigned int piece = engine->piece_count;
+  int level = engine->game_info.level, lines = 0;
+  unsigned int now = 0, spawn_ms = 0, level_ms = 0;
+  bool waiting = true;
+  stats->levels[level].games++;
+  for (unsigned int i = 0; i < game->count && engine->state != GAMEOVER;
+       i++) {
+    const replay_event_t *event = &events[i];
+    now = event->time_ms;
+    if (waiting && event->kind != REPLAY_TICK &&
+        (event->kind != REPLAY_KEY || event->value)) {
+      analyzeHesitation(&stats->levels[level], now - spawn_ms);
+      waiting = false;
+    }
+    replayApply(engine, event);
+    if (engine->lines != lines) {
+      int cleared = engine->lines - lines;
+      stats->levels[level].lines += cleared;
+      stats->levels[level].clears[(cleared > 4 ? 4 : cleared) - 1]++;
+      lines = engine->lines;
+    }
+    if (engine->piece_count != piece) {
+      stats->levels[level].pieces++;
+      stats->levels[level].placement_ms += now - spawn_ms;
+      piece = engine->piece_count;
+      spawn_ms = now;
+      waiting = true;
+    }
+    if (engine->game_info.level != level) {
+      stats->levels[level].time_ms += now - level_ms;
+      level = engine->game_info.level;
+      level_ms = now;
+      stats->levels[level].games++;
+    }
+  }
+  stats->levels[level].time_ms += now - level_ms;
+  bool over = engine->state == GAMEOVER;
+  // Выход из игры (Terminate) тоже ведет в GAMEOVER, но это не смерть
+  bool quit = over && game->count &&
+              events[game->count - 1].kind == REPLAY_INPUT &&
+              events[game->count - 1].action == Terminate;
+  stats->quits += quit;
+  if (over && !quit) {
+    stats->levels[level].deaths++;
+    stats->deaths[level][engine->addinfo.piece_id]++;
+  }
+  if (over != ((game->flags & REPLAY_FINISHED) != 0)) stats->diverged++;
+  stats->games++;
+  stats->finished += over;
+  stats->events += game->count;
+  stats->score += engine->game_info.score;
+  stats->lines += engine->lines;
+  stats->time_ms += now;
+}
+
+/**
+ * @brief Поток анализа: своя игра и своя статистика.
+ */
+static void *analyzeWorker(void *arg) {
+  analyze_worker_t *worker = arg;
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  long long begin, end;
+  replay_log_t *log;
+  while ((log = analyzeTake(worker->queue, &begin, &end)) != NULL) {
+    for (long long i = begin; i < end; i++) {
+      const replay_event_t *events;
+      const replay_game_t *game = replayGame(log, i, &events);
+      analyzeGame(&engine, game, events, worker->stats);
+    }
+  }
+  engineInput(&engine, Terminate, true);
+  return NULL;
+}
+
+/**
+ * @brief Сложение статистики потока src с итоговой dst.
+ */
+static void analyzeMerge(analyze_stats_t *dst, const analyze_stats_t *src) {
+  // Все поля - счетчики long long
+  const long long *from = (const long long *)src;
+  long long *to = (long long *)dst;
+  for (size_t i = 0; i < sizeof(analyze_stats_t) / sizeof(long long); i++)
+    to[i] += from[i];
+}
+
+/**
+ * @brief Процентиль времени до первого действия по гистограмме, мс.
+ */
+static double analyzePercentile(const level_stats_t *level, double p) {
+  long long rank = (long long)(p * level->hesitations), seen = 0;
+  int bucket = 0;
+  while (bucket < ANALYZE_HIST_BUCKETS - 1 &&
+         seen + level->hesitation_hist[bucket] <= rank)
+    seen += level->hesitation_hist[bucket++];
+  return level->hesitations ? (bucket + 0.5) * ANALYZE_HIST_MS : 0;
+}
+
+/**
+ * @brief Открытие файла dir/name на запись.
+ */
+static FILE *analyzeOpen(const char *dir, const char *name) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *file = fopen(path, "w");
+  if (file == NULL) fprintf(stderr, "tetris_analyze: cannot write %s\n", path);
+  return file;
+}
+
+/**
+ * @brief Запись таблиц CSV.
+ * @return 0 - успешно, 1 - ошибка записи.
+ */
+static int analyzeWrite(const analyze_stats_t *stats, const char *dir) {
+  FILE *levels = analyzeOpen(dir, "levels.csv");
+  FILE *deaths = analyzeOpen(dir, "deaths.csv");
+  FILE *summary = analyzeOpen(dir, "summary.csv");
+  int res = levels && deaths && summary ? SUCCESSFUL_EXIT : FAILURE_EXIT;
+  if (!res) {
+    fprintf(levels,
+            "level,games,deaths,pieces,lines,singles,doubles,triples,"
+            "tetrises,time_s,lines_per_min,hesitation_mean_ms,"
+            "hesitation_p50_ms,hesitation_p90_ms,placement_mean_ms\n");
+    for (int i = 1; i < ANALYZE_LEVELS; i++) {
+      const level_stats_t *l = &stats->levels[i];
+      double minutes = l->time_ms / 60000.0;
+      fprintf(levels, "%d,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%.3f,",
+              i, l->games, l->deaths, l->pieces, l->lines, l->clears[0],
+              l->clears[1], l->clears[2], l->clears[3], l->time_ms / 1000.0);
+      fprintf(levels, "%.3f,%.1f,%.1f,%.1f,%.1f\n",
+              minutes > 0 ? l->lines / minutes : 0,
+              l->hesitations ? (double)l->hesitation_ms / l->hesitations : 0,
+              analyzePercentile(l, 0.5), analyzePercentile(l, 0.9),
+              l->pieces ? (double)l->placement_ms / l->pieces : 0);
+    }
+    fprintf(deaths, "level,piece,deaths\n");
+    for (int i = 1; i < ANALYZE_LEVELS; i++)
+      for (int j = 0; j < 7; j++)
+        if (stats->deaths[i][j])
+          fprintf(deaths, "%d,%c,%lld\n", i, "OIZSJLT"[j], stats->deaths[i][j]);
+    fprintf(summary,
+            "games,finished,quits,diverged,events,score_mean,lines_mean,"
+            "duration_mean_s\n");
+    double games = stats->games ? (double)stats->games : 1;
+    fprintf(summary, "%lld,%lld,%lld,%lld,%lld,%.1f,%.2f,%.2f\n",
+            stats->games, stats->finished, stats->quits, stats->diverged,
+            stats->events,
+            stats->score / games, stats->lines / games,
+            stats->time_ms / games / 1000);
+  }
+  FILE *files[] = {levels, deaths, summary};
+  for (int i = 0; i < 3; i++)
+    if (files[i] != NULL && fclose(files[i]) != 0) res = FAILURE_EXIT;
+  return res;
+}
+
+/**
+ * @brief Анализ журналов в threads потоков.
+ * @return 0 - успешно, 1 - ошибка.
+ */
+static int analyzeRun(char **paths, int count, int threads, const char *dir) {
+  analyze_queue_t queue = {.count = count};
+  queue.logs = calloc(count, sizeof(replay_log_t));
+  analyze_stats_t *stats = calloc(threads + 1, sizeof(analyze_stats_t));
+  int res = queue.logs && stats ? SUCCESSFUL_EXIT : FAILURE_EXIT;
+  for (int i = 0; i < count && !res; i++) {
+    res = replayMap(paths[i], &queue.logs[i]);
+    if (res) fprintf(stderr, "tetris_analyze: cannot read %s\n", paths[i]);
+    if (!res && queue.logs[i].truncated)
+      fprintf(stderr, "tetris_analyze: %s: truncated record skipped\n",
+              paths[i]);
+  }
+  if (!res) {
+    pthread_mutex_init(&queue.mutex, NULL);
+    pthread_t ids[ANALYZE_THREADS_MAX];
+    analyze_worker_t workers[ANALYZE_THREADS_MAX];
+    long long start = metricsNow();
+    int started = 0;
+    for (; started < threads; started++) {
+      workers[started] = (analyze_worker_t){&queue, &stats[started + 1]};
+      if (pthread_create(&ids[started], NULL, analyzeWorker,
+                         &workers[started]) != 0)
+        break;
+    }
+    // Если ни один поток не создан, анализ идет в основном потоке
+    if (started == 0) analyzeWorker(&(analyze_worker_t){&queue, &stats[1]});
+    for (int i = 0; i < started; i++) pthread_join(ids[i], NULL);
+    double elapsed = (metricsNow() - start) / 1e9;
+    for (int i = 1; i <= threads; i++) analyzeMerge(&stats[0], &stats[i]);
+    pthread_mutex_destroy(&queue.mutex);
+    fprintf(stderr,
+            "tetris_analyze: %lld games, %lld events, %d threads, %.3f s, "
+            "%.0f games/min\n",
+            stats[0].games, stats[0].events, started ? started : 1, elapsed,
+            elapsed > 0 ? stats[0].games * 60 / elapsed : 0);
+    res = analyzeWrite(&stats[0], dir);
+  }
+  for (int i = 0; i < count && queue.logs != NULL; i++)
+    replayUnmap(&queue.logs[i]);
+  free(queue.logs);
+  free(stats);
+  return res;
+}
+
+/**
+ * @brief Добавление события синтетической игры с выполнением на engine.
+ * После конца игры события не добавляются (как при записи).
+ */
+static void generateEvent(engine_t *engine, replay_event_t *events,
+                          unsigned int *count, unsigned int time_ms,
+                          replay_kind kind, UserAction_t action, int value) {
+  if (engine->state == GAMEOVER) return;
+  events[*count] = (replay_event_t){time_ms, kind, action, value};
+  replayApply(engine, &events[(*count)++]);
+}
+
+/**
+ * @brief Одна фигура синтетической игры: пауза, затем с вероятностью
+ * 1 / GENERATE_MISTAKE случайные сдвиги и вращения, иначе ходы бота; между
+ * действиями идут шаги времени, в конце - падение.
+ */
+static void generatePiece(engine_t *engine, bot_t *bot, unsigned int *seed,
+                          replay_event_t *events, replay_game_t *game,
+                          unsigned int *time_ms) {
+  const UserAction_t moves[] = {Left, Right, Action, ActionCCW};
+  unsigned int tick_ms = TIMING_TICK_NS / 1000000;
+  int wait = 1 + rand_r(seed) % GENERATE_WAIT;
+  *time_ms += wait * tick_ms;
+  generateEvent(engine, events, &game->count, *time_ms, REPLAY_TICK, Up, wait);
+  bool mistake = rand_r(seed) % GENERATE_MISTAKE == 0, hold = false;
+  unsigned int piece = engine->piece_count;
+  for (int k = 0; k < BOT_MOVES_LIMIT && !hold && engine->state == MOVING &&
+                  engine->piece_count == piece;
+       k++) {
+    UserAction_t action = mistake ? moves[rand_r(seed) % 4]
+                                  : botAction(bot, engine, &hold);
+    if (mistake && rand_r(seed) % 4 == 0) {
+      action = Down;
+      hold = true;
+    }
+    generateEvent(engine, events, &game->count, *time_ms, REPLAY_INPUT, action,
+                  hold);
+    *time_ms += GENERATE_MOVE_TICKS * tick_ms;
+    generateEvent(engine, events, &game->count, *time_ms, REPLAY_TICK, Up,
+                  GENERATE_MOVE_TICKS);
+  }
+  if (engine->piece_count == piece)
+    generateEvent(engine, events, &game->count, *time_ms, REPLAY_INPUT, Down,
+                  true);
+}
+
+/**
+ * @brief Синтетический журнал: games игр бота с ошибками (generatePiece),
+ * время идет шагами игры. Игры длиннее GENERATE_PIECES фигур обрываются и
+ * записываются незаконченными.
+ * @return 0 - успешно, 1 - ошибка.
+ */
+static int generateLog(long long games, const char *path, unsigned int seed) {
+  FILE *file = fopen(path, "wb");
+  size_t size = REPLAY_EVENTS_INIT;
+  replay_event_t *events = malloc(size * sizeof(replay_event_t));
+  bot_t *bot = botCreate(GENERATE_BOT_BUDGET);
+  int res = file && events && bot ? SUCCESSFUL_EXIT : FAILURE_EXIT;
+  engine_t engine = {0};
+  engineInput(&engine, Start, true);
+  for (long long g = 0; g < games && !res; g++) {
+    replay_game_t game = {REPLAY_MAGIC, seed + (unsigned int)g, 0, 0};
+    replayStart(&engine, &game);
+    unsigned int time_ms = 0, pieces = 0;
+    while (engine.state != GAMEOVER && pieces++ < GENERATE_PIECES && !res) {
+      // Событий на фигуру не больше 2 + 2 * BOT_MOVES_LIMIT
+      if (game.count + 2 + 2 * BOT_MOVES_LIMIT > size) {
+        replay_event_t *grown = realloc(events, 2 * size * sizeof(*grown));
+        if (grown == NULL) res = FAILURE_EXIT;
+        if (grown != NULL) {
+          events = grown;
+          size *= 2;
+        }
+      }
+      if (!res) generatePiece(&engine, bot, &seed, events, &game, &time_ms);
+    }
+    if (engine.state == GAMEOVER) game.flags |= REPLAY_FINISHED;
+    if (!res &&
+        (fwrite(&game, sizeof(game), 1, file) != 1 ||
+         fwrite(events, sizeof(*events), game.count, file) != game.count))
+      res = FAILURE_EXIT;
+  }
+  engineInput(&engine, Terminate, true);
+  botDestroy(bot);
+  if (file != NULL && fclose(file) != 0) res = FAILURE_EXIT;
+  free(events);
+  return res;
+}
+
+int main(int argc, char **argv) {
+  int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  const char *dir = ".";
+  long long generate = 0;
+  unsigned int seed = 1;
+  int first = 1, res = SUCCESSFUL_EXIT;
+  while (first < argc && argv[first][0] == '-' && !res) {
+    if (strcmp(argv[first], "--threads") == 0 && first + 1 < argc) {
+      threads = atoi(argv[++first]);
+      if (threads < 1 || threads > ANALYZE_THREADS_MAX) res = FAILURE_EXIT;
+    } else if (strcmp(argv[first], "--out") == 0 && first + 1 < argc) {
+      dir = argv[++first];
+    } else if (strcmp(argv[first], "--generate") == 0 && first + 1 < argc) {
+      generate = atoll(argv[++first]);
+      if (generate < 1) res = FAILURE_EXIT;
+    } else if (strcmp(argv[first], "--seed") == 0 && first + 1 < argc) {
+      seed = (unsigned int)strtoul(argv[++first], NULL, 10);
+    } else {
+      res = FAILURE_EXIT;
+    }
+    first++;
+  }
+  if (threads < 1) threads = 1;
+  if (threads > ANALYZE_THREADS_MAX) threads = ANALYZE_THREADS_MAX;
+  if (res || first >= argc || (generate && first + 1 != argc)) {
+    fprintf(stderr,
+            "Usage: %s [--threads N] [--out DIR] LOG...\n"
+            "       %s --generate N [--seed S] FILE\n",
+            argv[0], argv[0]);
+    return FAILURE_EXIT;
+  }
+  if (generate) {
+    res = generateLog(generate, argv[first], seed);
+    if (res) fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[first]);
+  } else {
+    res = analyzeRun(argv + first, argc - first, threads, dir);
+  }
+  return res;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file s21_fsm_diagram.c
+ * @brief Генерация схемы FSM (Graphviz DOT) из спецификации
+ * s21_tetris_fsm.def - той же, из которой собирается таблица переходов.
+ *
+ * Запуск: make fsm_diagram (FSM.dot, и FSM.pdf при наличии graphviz).
+ */
+#include <stdio.h>
+
+/**
+ * @brief Имя события без префикса EV_ для подписи перехода.
+ */
+static const char *eventLabel(const char *event) { return event + 3; }
+
+int main() {
+  printf("digraph FSM {\n");
+  printf("  rankdir=LR;\n");
+  printf("  node [shape=box, style=rounded];\n");
+  printf("  START [style=\"rounded,bold\"];\n");
+#define FSM_HANDLER(name, function)
+#define FSM_TRANSITION(state, event, handler, next)
+#define FSM_AUTO(state) printf("  %s [style=\"rounded,dashed\"];\n", #state);
+#include "../brick_game/tetris/s21_tetris_fsm.def"
+
+#define FSM_HANDLER(name, function)
+#define FSM_TRANSITION(state, event, handler, next)                \
+  printf("  %s -> %s [label=\"%s\\n%s\"];\n", #state, #next, \
+         eventLabel(#event), #handler);
+#define FSM_BRANCH(state, event, next)                              \
+  printf("  %s -> %s [label=\"%s\", style=dashed];\n", #state, #next, \
+         eventLabel(#event));
+#include "../brick_game/tetris/s21_tetris_fsm.def"
+  printf("}\n");
+  return 0;
+}